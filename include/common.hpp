@@ -6,6 +6,12 @@
 // 数学工具
 #include "common/math.hpp"
 
+// 时钟
+#include "common/clock.hpp"
+
+// 无锁数据结构
+#include "common/lockfree.hpp"
+
 // 参数管理
 #include "common/parameter.hpp"
 
@@ -15,8 +21,20 @@
 // 显示管理
 #include "common/display.hpp"
 
+// 分阶段性能统计
+#include "common/profiler.hpp"
+
+// 飞行记录仪
+#include "common/flightrecorder.hpp"
+
+// 异步日志
+#include "common/log.hpp"
+
 // 调试和性能监控管理
 #include "common/debug.hpp"
 
+// 共享内存帧发布
+#include "common/publisher.hpp"
+
 // 串口通信管理
 #include "common/uart.hpp"
\ No newline at end of file
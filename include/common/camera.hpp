@@ -2,7 +2,12 @@
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
+#include "common/framecache.hpp"
 #include "common/parameter.hpp"
+#include "common/recording.hpp"
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace common
 {
@@ -15,7 +20,11 @@ public:
     enum class InputMode {
         CAMERA,
         VIDEO,
-        PICTURE
+        PICTURE,
+        FOLDER,     // 图片目录，按文件名顺序逐帧读取，读完后Capture返回false
+        FRAMES,     // 预先解码的帧（多条流水线只读共享），读完后Capture返回false
+        CACHE,      // 预处理帧缓存（已缩放、灰度化或二值化），读完后Capture返回false
+        RECORDING   // 录制文件（.nsrec），按录制的采集时间回放，读完后Capture返回false
     };
     int _video_delay;
     
@@ -34,6 +43,47 @@ public:
     void Print_Camera_Info() const; // 打印摄像头信息
     int Get_Camera_Index() const; // 获取当前摄像头索引
     double Get_Actual_FPS() const; // 获取摄像头实际帧率
+    int64_t Get_Capture_Ns() const{return _capture_ns;} // 获取当前帧采集时间戳（common::Now_Ns）
+    int64_t Get_Recorded_Ns() const{return _recorded_ns;} // recording模式下当前帧的录制时间戳（录制时的时钟）
+
+    /**
+     * @brief 改为从预先解码的帧读取
+     * @param frames 只读共享的帧，每次Capture复制一帧，不修改共享数据
+     */
+    void Use_Frames(std::shared_ptr<const std::vector<cv::Mat>> frames);
+
+    /**
+     * @brief 改为从预处理帧缓存读取，跳过缩放和灰度化（二值缓存还跳过二值化），不提供彩色原图
+     * @return 缓存的尺寸或阈值与当前参数不符时不使用，返回false
+     */
+    bool Use_Cache(std::shared_ptr<const FrameCache> cache);
+
+    /**
+     * @brief 采集到的帧是否已经过预处理（不需要再缩放）
+     */
+    bool Is_Preprocessed() const{return _input_mode == InputMode::CACHE;}
+
+    /**
+     * @brief 把之后采集的每帧写入录制文件
+     * @details 摄像头输出MJPEG时改为取原始MJPEG数据自行解码，原样记录不重新编码；其他输入记录未压缩的BGR图像
+     */
+    void Attach_Recording(std::shared_ptr<RecordingWriter> writer);
+
+    /**
+     * @brief recording模式的录制文件（串口回放共用以保持时序），其他模式为nullptr
+     */
+    std::shared_ptr<RecordingReader> Get_Recording() const{return _recording;}
+
+    /**
+     * @brief 解码录制文件的第k帧
+     * @return 是否成功
+     */
+    static bool Decode_Recorded(const RecordingReader& recording, size_t k, cv::Mat& frame);
+
+    /**
+     * @brief 列出目录中的图片（png/jpg/jpeg/bmp），按文件名排序
+     */
+    static std::vector<std::string> List_Images(const std::string& folder_path);
 
     int Get_Row_Cut_Up() const{return _row_cut_up;}
     int Get_Row_Cut_Bottom() const{return _row_cut_bottom;}
@@ -42,6 +92,10 @@ private:
     bool Init_Camera();
     bool Init_Video();
     bool Init_Picture();
+    bool Init_Folder();
+    bool Init_Recording();
+    bool Capture_Frame();
+    void Record_Frame();
     void Load_Config();
     int Get_Threshold_Value() const;
 
@@ -62,6 +116,20 @@ private:
     int _row_cut_up;
     int _row_cut_bottom;
 
+    int64_t _capture_ns = 0; //当前帧采集时间戳
+    int64_t _recorded_ns = 0; //recording模式下当前帧的录制时间戳
+
+    std::vector<std::string> _folder_files; //folder模式的图片列表
+    size_t _folder_index = 0;               //folder/frames模式下一帧序号
+    std::shared_ptr<const std::vector<cv::Mat>> _frames;    //frames模式的共享帧
+    std::shared_ptr<const FrameCache> _cache;               //cache模式的预处理帧缓存
+    std::shared_ptr<RecordingReader> _recording;            //recording模式的录制文件
+    bool _recording_realtime = true;                        //recording模式按录制时间等待
+    std::shared_ptr<RecordingWriter> _record;               //录制写出，为空不录制
+    bool _raw_mjpeg = false;                                //取摄像头原始MJPEG数据
+    cv::Mat _packet;                                        //当前帧的原始MJPEG数据
+    uint32_t _record_frame_id = 0;                          //已录制帧数
+
 
 
 };
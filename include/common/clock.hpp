@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace common{
+
+/**
+ * @brief 单调时钟当前时间（纳秒）
+ *
+ * 各线程间传递的时间戳统一使用该时钟，便于直接相减计算延迟
+ */
+inline int64_t Now_Ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
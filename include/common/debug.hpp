@@ -204,6 +204,12 @@ public:
      */
     void log_final_report();
     
+    /**
+     * @brief 追加自定义文本到性能日志
+     * @param text 文本内容
+     */
+    void log_text(const std::string& text);
+    
     /**
      * @brief 获取日志文件名
      * @return 日志文件名
@@ -1,9 +1,10 @@
 #pragma once
 
 #include <opencv2/opencv.hpp>
-#include <queue>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
-#include <unordered_map>
 
 namespace common{
 
@@ -13,13 +14,45 @@ extern const uint16_t ROWSIMAGE;
 extern const uint16_t COLSIMAGEIPM;
 extern const uint16_t ROWSIMAGEIPM;   
 
+#define DISPLAY_MAX_WINDOWS 8   //窗口序号上限
 
+/**
+ * @brief 是否为无界面模式
+ *
+ * 无界面模式下不分配绘制图像、不绘制叠加信息、不调用HighGUI。
+ * 编译时定义NS_HEADLESS则恒为真，相关绘制分支被编译器整体去除；否则读取配置Headless，
+ * 配置Shm_Publish（由外部查看器显示）时同样为真。
+ */
+#ifdef NS_HEADLESS
+constexpr bool Is_Headless() { return true; }
+#else
+bool Is_Headless();
+#endif
+
+/**
+ * @brief 多窗口显示
+ *
+ * 每个窗口一个三缓冲：处理线程把图像拷贝到后缓冲后与中间缓冲交换，显示线程取走中间缓冲，
+ * 双方互不阻塞。显示跟不上时旧帧被新帧覆盖并计入丢帧，内存占用固定。
+ * 显示线程在条件变量上等待新帧，并按TARGET_FPS限制刷新频率。
+ */
 class Display{
 
 public:
-    using Frame = std::pair<uint8_t,cv::Mat>;   //显示帧数据结构
-    using Frame_Queue = std::queue<Frame>;      //显示帧队列类型
-    using WndMap = std::unordered_map<uint8_t,std::string>;  //窗口映射表类型
+    /**
+     * @brief 单个窗口的三缓冲
+     */
+    struct Window
+    {
+        std::string name;               //窗口名称
+        cv::Mat buffers[3];             //三缓冲
+        int back = 0;                   //后缓冲（处理线程独占）
+        int front = 2;                  //前缓冲（显示线程独占）
+        std::atomic<uint8_t> middle {1};    //低2位：中间缓冲序号；第3位：有未显示的新帧
+        std::atomic<bool> active {false};   //窗口已创建
+        std::atomic<uint64_t> shown {0};    //已显示帧数
+        std::atomic<uint64_t> dropped {0};  //未显示即被覆盖的帧数
+    };
 
     Display();
     ~Display();
@@ -36,17 +69,26 @@ public:
 
     void add_window(uint8_t series, const std::string& wnd_name);
     void sync();
-    void show_image(uint8_t series,cv::Mat frame);
+    void show_image(uint8_t series,const cv::Mat& frame);
+
+    // 丢帧统计
+    uint64_t shown_frames(uint8_t series) const;
+    uint64_t dropped_frames(uint8_t series) const;
 
 
 private:
 
+    void display_loop();
+    void notify();
+
     const int max_show = 4; //最大同时显示窗口数
     cv::Mat imgShow;        //显示图像缓冲区
     bool realShow = false;  //是否实时显示标志
-    bool thread_flag = false;  //线程运行标志
-    Frame_Queue frame_queue;  //显示帧队列
-    WndMap wnd_map;         //窗口映射表
+    std::atomic<bool> thread_flag {true};  //线程运行标志
+    Window windows[DISPLAY_MAX_WINDOWS];  //窗口三缓冲
+    std::mutex wake_mutex;              //保护wake_pending
+    std::condition_variable wake_cv;    //新帧通知
+    bool wake_pending = false;          //有未处理的新帧通知
     std::thread loop;       //显示线程
 
 };
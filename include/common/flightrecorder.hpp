@@ -0,0 +1,130 @@
+#pragma once
+
+#include "common/profiler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace common{
+
+#define FLIGHT_MAGIC "NSFR1\0\0"        //记录文件头（8字节，含结尾0）
+#define FLIGHT_STAGES ((int)Stage::Control) //记录的视觉线程阶段：Frame ~ Speed_Control
+#define FLIGHT_SCENE_LENGTH 16
+
+// 记录标志位
+#define FLIGHT_FIT_VALID 0x01           //中心线拟合有效
+#define FLIGHT_TELEMETRY 0x02           //已收到下位机遥测
+#define FLIGHT_MOTION 0x04              //运动控制已启用
+
+/**
+ * @brief 单帧记录（固定128字节，可平凡拷贝）
+ */
+struct Flight_Record
+{
+    uint32_t frame_id;                  //帧序号
+    uint16_t servo_pwm;                 //舵机PWM
+    uint8_t flags;                      //FLIGHT_*标志
+    uint8_t reserved;
+    int64_t capture_ns;                 //采集时间（单调时钟）
+    int64_t stamp_ns;                   //记录时间（单调时钟）
+    uint32_t stage_ns[FLIGHT_STAGES];   //各阶段本帧耗时（纳秒）
+    char scene[FLIGHT_SCENE_LENGTH];    //当前场景
+    int16_t start_left_x;               //赛道起点
+    int16_t start_right_x;
+    int16_t start_y;
+    int16_t control_center;             //控制中心x坐标
+    int16_t corners[4][2];              //左下、右下、左上、右上角点
+    float middle_error;                 //中线误差
+    float speed;                        //目标速度
+    float measured_speed;               //实测速度（编码器）
+    float sigma;                        //中心线拟合残差
+    uint32_t uart_rx_errors;            //串口累计校验错误帧
+    uint32_t uart_tx_dropped;           //串口累计发送丢帧
+    uint32_t uart_coalesced;            //串口累计覆盖指令
+};
+static_assert(sizeof(Flight_Record) == 128, "Flight_Record布局变化时需同步修改记录文件版本");
+
+/**
+ * @brief 记录文件头
+ */
+struct Flight_Header
+{
+    char magic[8];
+    uint32_t record_size;
+    uint32_t count;             //记录条数，按时间先后排列
+    int64_t dump_ns;            //保存时间（单调时钟）
+    uint32_t stages;            //每条记录的阶段数
+    uint32_t reserved;
+};
+
+/**
+ * @brief 飞行记录仪：固定大小的内存环形缓冲，只保留最近的若干帧
+ *
+ * 视觉线程每帧原地填写一条记录（Next后Commit），不分配内存、不加锁。
+ * 退出、收到信号（SIGINT/SIGTERM/SIGSEGV/SIGABRT等）或按键时保存到文件，
+ * 信号处理中只使用open/write/close，文件名在构造时生成。用tool/flight_decode解析。
+ */
+class FlightRecorder
+{
+public:
+    /**
+     * @brief 构造
+     * @param capacity 保留的帧数
+     */
+    explicit FlightRecorder(size_t capacity = 4096);
+    ~FlightRecorder();
+
+    /**
+     * @brief 取下一条待填写的记录（仅视觉线程调用）
+     */
+    Flight_Record& Next()
+    {
+        Flight_Record& record = _records[_count.load(std::memory_order_relaxed) % _records.size()];
+        record = Flight_Record{};
+        return record;
+    }
+
+    /**
+     * @brief 提交Next取得的记录
+     */
+    void Commit() { _count.fetch_add(1, std::memory_order_release); }
+
+    /**
+     * @brief 保存到文件（可在信号处理中调用）
+     * @param path 文件路径，nullptr为构造时生成的文件名（信号处理专用）
+     * @return 是否成功
+     */
+    bool Dump(const char* path = nullptr) const;
+
+    /**
+     * @brief 保存到新文件（按键或退出时调用，不在信号处理中使用）
+     *
+     * 每次按当前时间和序号生成文件名，多次保存互不覆盖。
+     * @param path 输出实际写入的文件路径
+     * @return 是否成功
+     */
+    bool Snapshot(std::string& path);
+
+    const char* Path() const { return _path; }
+    uint64_t Count() const { return _count.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 安装信号处理，收到致命信号或终止信号时保存后按默认方式退出
+     */
+    void Install_Signal_Handlers();
+
+    /**
+     * @brief 读取记录文件
+     * @return 是否成功
+     */
+    static bool Load(const std::string& path, std::vector<Flight_Record>& records);
+
+private:
+    std::vector<Flight_Record> _records;
+    std::atomic<uint64_t> _count {0};
+    char _path[64];             //信号处理时写入的文件名（构造时生成）
+    uint32_t _snapshots = 0;    //Snapshot次数，用于生成文件名
+};
+
+}
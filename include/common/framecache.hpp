@@ -0,0 +1,130 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace common{
+
+#define FRAME_CACHE_MAGIC "NSFC1\0\0"       //预处理帧缓存文件头（8字节，含结尾0）
+#define FRAME_CACHE_DATA_ALIGN 4096         //帧数据起始按页对齐
+#define FRAME_CACHE_FRAME_ALIGN 64          //每帧按缓存行对齐，映射后可直接作为图像使用
+
+/**
+ * @brief 缓存帧格式
+ */
+enum class Frame_Format : uint8_t
+{
+    GRAY = 0,       //缩放后的灰度图，每像素1字节，可扫描阈值
+    BINARY = 1      //按固定阈值二值化后按位打包，每像素1位，行按字节对齐
+};
+
+/**
+ * @brief 缓存文件头
+ */
+struct Frame_Cache_Header
+{
+    char magic[8];
+    uint32_t header_size;       //sizeof(Frame_Cache_Header)
+    uint8_t format;             //Frame_Format
+    uint8_t reserved[3];
+    uint16_t width;             //处理图像尺寸
+    uint16_t height;
+    int32_t threshold;          //二值化阈值，灰度缓存为-1
+    uint32_t frame_count;       //帧数
+    uint32_t frame_stride;      //相邻两帧数据的间隔（字节，按缓存行对齐）
+    uint32_t reserved2;
+    uint64_t key;               //预处理参数及输入文件的校验值，不一致时缓存作废
+    uint64_t data_offset;       //第一帧数据的位置
+    uint64_t index_offset;      //帧索引的位置（数据之后）
+    double fps;                 //视频帧率，图片目录为0
+};
+
+/**
+ * @brief 帧索引：缓存帧对应的原始帧
+ */
+struct Frame_Cache_Index
+{
+    uint32_t source_index;      //在视频或录制文件中的帧序号，或在图片目录中的文件序号（从0开始，跳过无法读取的帧）
+    uint32_t reserved;
+};
+
+/**
+ * @brief 预处理帧缓存
+ *
+ * 把录像逐帧缩放、灰度化（可选按阈值二值化并按位打包）后写入文件，回放时只读映射，
+ * 灰度帧不拷贝直接作为图像使用，二值帧按位解包，跳过解码和预处理。
+ * 文件名及文件头中含预处理参数（尺寸、格式、阈值）和输入文件（路径、大小、修改时间）的校验值，
+ * 参数或输入变化后自动重建。对象只读，可由多条流水线共享。
+ */
+class FrameCache
+{
+public:
+    ~FrameCache();
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    /**
+     * @brief 打开已有的缓存文件
+     * @param key 期望的校验值，0为不检查
+     * @return 失败（不存在、损坏或校验值不符）时返回nullptr
+     */
+    static std::shared_ptr<const FrameCache> Open(const std::string& path, uint64_t key = 0);
+
+    /**
+     * @brief 解码并预处理输入，写出缓存文件（先写临时文件再改名，可多进程同时生成）
+     * @param source 视频文件、录制文件(.nsrec)或图片目录
+     * @param threshold 二值化阈值，仅BINARY格式使用
+     * @return 是否成功
+     */
+    static bool Build(const std::string& source, const std::string& path, int width, int height,
+                      Frame_Format format, int threshold);
+
+    /**
+     * @brief 打开缓存目录中与输入及预处理参数对应的缓存，不存在或已作废时重新生成
+     * @param dir 缓存目录，不存在时创建
+     */
+    static std::shared_ptr<const FrameCache> Open_Or_Build(const std::string& source, const std::string& dir,
+                                                           int width, int height, Frame_Format format, int threshold);
+
+    /**
+     * @brief 预处理参数及输入文件的校验值，输入不可读时返回0
+     */
+    static uint64_t Key(const std::string& source, int width, int height, Frame_Format format, int threshold);
+
+    /**
+     * @brief 缓存文件路径：<dir>/<输入文件名>_<校验值>.nsfc
+     */
+    static std::string Path(const std::string& dir, const std::string& source, uint64_t key);
+
+    size_t Frame_Count() const { return _header->frame_count; }
+    int Width() const { return _header->width; }
+    int Height() const { return _header->height; }
+    int Threshold() const { return _header->threshold; }
+    double Fps() const { return _header->fps; }
+    Frame_Format Format() const { return static_cast<Frame_Format>(_header->format); }
+    const Frame_Cache_Index& Index(size_t k) const { return _index[k]; }
+
+    /**
+     * @brief 灰度帧（只读映射的图像，不拷贝，不可写入）
+     */
+    cv::Mat Gray(size_t k) const;
+
+    /**
+     * @brief 解包二值帧到binary（0/255，尺寸不变时复用内存）
+     */
+    void Unpack(size_t k, cv::Mat& binary) const;
+
+private:
+    FrameCache() = default;
+
+    const uint8_t* Frame_Data(size_t k) const { return _base + _header->data_offset + k * _header->frame_stride; }
+
+    const uint8_t* _base = nullptr;     //映射的文件
+    size_t _size = 0;
+    const Frame_Cache_Header* _header = nullptr;
+    const Frame_Cache_Index* _index = nullptr;
+};
+
+}
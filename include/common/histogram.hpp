@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace common{
+
+/**
+ * @brief 对数-线性分桶的延迟直方图（HDR风格）
+ *
+ * 小于32的值逐一分桶，之后每个2的幂区间再分16个子桶，相对误差约3%。
+ * 计数使用relaxed原子操作，任意线程可记录，读取时无需加锁。
+ * 取值单位由调用方决定，本项目统一使用纳秒。
+ */
+class Histogram
+{
+public:
+    static constexpr int SUB_BITS = 5;                      //子桶精度位数
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;         //线性区间大小
+    static constexpr int HALF_COUNT = SUB_COUNT / 2;        //每个幂区间的子桶数
+    static constexpr int BUCKETS = SUB_COUNT + (64 - SUB_BITS) * HALF_COUNT;
+
+    Histogram() { Reset(); }
+
+    /**
+     * @brief 记录一个样本
+     */
+    void Record(int64_t value)
+    {
+        uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+        _counts[Index(v)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(v, std::memory_order_relaxed);
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while(v > max && !_max.compare_exchange_weak(max, v, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief 清空统计
+     */
+    void Reset()
+    {
+        for(auto& c : _counts)
+            c.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 合并另一个直方图
+     */
+    void Merge(const Histogram& other)
+    {
+        for(int i = 0; i < BUCKETS; i++)
+            _counts[i].fetch_add(other._counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _count.fetch_add(other.Count(), std::memory_order_relaxed);
+        _sum.fetch_add(other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        uint64_t v = other.Max();
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while(v > max && !_max.compare_exchange_weak(max, v, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief 百分位数
+     * @param percent 百分比（0~100）
+     * @return 对应桶的上界
+     */
+    uint64_t Percentile(double percent) const
+    {
+        uint64_t total = Count();
+        if(total == 0)
+            return 0;
+        uint64_t target = static_cast<uint64_t>(percent / 100.0 * total + 0.5);
+        if(target < 1)
+            target = 1;
+        uint64_t seen = 0;
+        for(int i = 0; i < BUCKETS; i++)
+        {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if(seen >= target)
+            {
+                uint64_t upper = Upper(i);
+                return upper < Max() ? upper : Max();
+            }
+        }
+        return Max();
+    }
+
+    uint64_t Count() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return _max.load(std::memory_order_relaxed); }
+    double Mean() const
+    {
+        uint64_t n = Count();
+        return n ? static_cast<double>(_sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+private:
+    static int Index(uint64_t v)
+    {
+        if(v < SUB_COUNT)
+            return static_cast<int>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - (SUB_BITS - 1);                   //使 v >> shift 落在[HALF_COUNT, SUB_COUNT)
+        int mantissa = static_cast<int>(v >> shift);
+        return SUB_COUNT + (shift - 1) * HALF_COUNT + (mantissa - HALF_COUNT);
+    }
+
+    static uint64_t Upper(int index)
+    {
+        if(index < SUB_COUNT)
+            return static_cast<uint64_t>(index);
+        int shift = (index - SUB_COUNT) / HALF_COUNT + 1;
+        uint64_t mantissa = (index - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::atomic<uint64_t> _counts[BUCKETS];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+};
+
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace common{
+
+/**
+ * @brief 无锁信箱（顺序锁实现）
+ *
+ * 单写多读，只保留最新值。写端从不阻塞；读端在写入过程中读取时自动重试。
+ * 数据按64位字以原子方式存取，避免顺序锁中的数据竞争。
+ * @tparam T 必须可平凡拷贝
+ */
+template<typename T>
+class Mailbox
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Mailbox只支持可平凡拷贝的类型");
+
+public:
+    Mailbox()
+    {
+        for(auto& word : _words)
+            word.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 写入最新值（仅允许一个写线程）
+     */
+    void Store(const T& value)
+    {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);     // 奇数：写入中
+        std::atomic_thread_fence(std::memory_order_release);
+        for(size_t i = 0; i < WORDS; i++)
+            _words[i].store(buffer[i], std::memory_order_relaxed);
+        _seq.store(seq + 2, std::memory_order_release);     // 偶数：写入完成
+    }
+
+    /**
+     * @brief 读取最新值
+     * @param value 输出值
+     * @return 是否已有写入过的值
+     */
+    bool Load(T& value) const
+    {
+        uint64_t buffer[WORDS];
+        uint32_t seq1, seq2;
+        do
+        {
+            seq1 = _seq.load(std::memory_order_acquire);
+            if(seq1 & 1)
+                continue;
+            for(size_t i = 0; i < WORDS; i++)
+                buffer[i] = _words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq2 = _seq.load(std::memory_order_relaxed);
+            if(seq1 == seq2)
+                break;
+        } while(true);
+
+        if(seq1 == 0)
+            return false;
+        std::memcpy(&value, buffer, sizeof(T));
+        return true;
+    }
+
+    /**
+     * @brief 写入次数，可用于判断是否有新值
+     */
+    uint32_t Version() const
+    {
+        return _seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> _seq {0};
+    std::atomic<uint64_t> _words[WORDS];
+};
+
+/**
+ * @brief 无锁单生产者单消费者队列
+ *
+ * 固定容量环形数组，生产者只写_tail、消费者只写_head，队满时Push失败而不阻塞。
+ * @tparam T 元素类型
+ * @tparam N 容量，必须为2的幂
+ */
+template<typename T, size_t N>
+class Spsc_Queue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Spsc_Queue容量必须为2的幂");
+
+public:
+    /**
+     * @brief 入队（仅生产者线程调用）
+     * @return 队满时返回false
+     */
+    bool Push(const T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head.load(std::memory_order_acquire) >= N)
+            return false;
+        _items[tail & (N - 1)] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（仅消费者线程调用）
+     * @return 队空时返回false
+     */
+    bool Pop(T& value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail.load(std::memory_order_acquire))
+            return false;
+        value = _items[head & (N - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前元素个数（近似值）
+     */
+    size_t Size() const
+    {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> _head {0};  //消费者位置
+    alignas(64) std::atomic<size_t> _tail {0};  //生产者位置
+    T _items[N];
+};
+
+/**
+ * @brief 无锁多生产者单消费者队列
+ *
+ * 固定容量环形数组，每个槽带序号：生产者用CAS抢占写位置，写完后发布槽序号，
+ * 消费者按序号判断槽是否已写完。队满时Push失败而不阻塞。
+ * @tparam T 元素类型
+ * @tparam N 容量，必须为2的幂
+ */
+template<typename T, size_t N>
+class Mpsc_Queue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Mpsc_Queue容量必须为2的幂");
+
+public:
+    Mpsc_Queue()
+    {
+        for(size_t i = 0; i < N; i++)
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 入队，在槽内原地构造元素（任意线程调用）
+     * @param fill 填充函数，参数为槽内元素的引用
+     * @return 队满时返回false
+     */
+    template<typename F>
+    bool Emplace(F&& fill)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while(true)
+        {
+            cell = &_cells[tail & (N - 1)];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)tail;
+            if(diff == 0)
+            {
+                if(_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if(diff < 0)
+                return false;   // 队满
+            else
+                tail = _tail.load(std::memory_order_relaxed);
+        }
+        fill(cell->value);
+        cell->seq.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Push(const T& value)
+    {
+        return Emplace([&](T& item) { item = value; });
+    }
+
+    /**
+     * @brief 出队（仅消费者线程调用）
+     * @return 队空或队首尚未写完时返回false
+     */
+    bool Pop(T& value)
+    {
+        Cell& cell = _cells[_head & (N - 1)];
+        if(cell.seq.load(std::memory_order_acquire) != _head + 1)
+            return false;
+        value = cell.value;
+        cell.seq.store(_head + N, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+    /**
+     * @brief 当前元素个数（近似值，仅消费者线程调用）
+     */
+    size_t Size() const
+    {
+        return _tail.load(std::memory_order_relaxed) - _head;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    alignas(64) std::atomic<size_t> _tail {0};  //生产者位置
+    alignas(64) size_t _head = 0;               //消费者位置
+    Cell _cells[N];
+};
+
+}
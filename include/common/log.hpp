@@ -0,0 +1,105 @@
+#pragma once
+
+#include "common/lockfree.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// 日志级别
+#define NS_LOG_LEVEL_TRACE 0
+#define NS_LOG_LEVEL_DEBUG 1
+#define NS_LOG_LEVEL_INFO  2
+#define NS_LOG_LEVEL_WARN  3
+#define NS_LOG_LEVEL_ERROR 4
+#define NS_LOG_LEVEL_OFF   5
+
+// 编译期最低级别，低于该级别的日志语句连同参数求值一起被去除（CMake选项NS_LOG_LEVEL）
+#ifndef NS_LOG_LEVEL
+#define NS_LOG_LEVEL NS_LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RECORD_TEXT 240     //单条日志最大长度，超出部分截断
+#define LOG_QUEUE_SIZE 1024     //日志队列容量
+
+namespace common{
+
+/**
+ * @brief 一条日志
+ */
+struct Log_Record
+{
+    int64_t stamp_ns;           //记录时间（单调时钟）
+    uint8_t level;              //日志级别
+    uint16_t length;            //文本长度
+    char text[LOG_RECORD_TEXT]; //格式化后的文本
+};
+
+/**
+ * @brief 异步日志
+ *
+ * 调用线程只把格式化后的文本写入无锁多生产者队列，由后台线程批量写到标准输出，
+ * 日志从不阻塞帧循环；队满时丢弃并计数。运行期级别由Print_Mode决定（启用时输出DEBUG级）。
+ */
+class Logger
+{
+public:
+    static Logger& Instance();
+    ~Logger();
+
+    /**
+     * @brief 运行期是否输出该级别
+     */
+    bool Enabled(int level) const { return level >= _level.load(std::memory_order_relaxed); }
+    void Set_Level(int level) { _level.store(level, std::memory_order_relaxed); }
+
+    /**
+     * @brief 格式化并入队（printf格式）
+     */
+    void Write(int level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    /**
+     * @brief 等待队列中的日志全部写出
+     */
+    void Flush();
+
+    uint64_t Dropped() const { return _dropped.load(std::memory_order_relaxed); }   //队满丢弃的条数
+
+private:
+    Logger();
+    void writer_loop();
+
+    Mpsc_Queue<Log_Record, LOG_QUEUE_SIZE> _queue;
+    std::atomic<int> _level {NS_LOG_LEVEL_INFO};
+    std::atomic<uint64_t> _dropped {0};
+    std::atomic<uint64_t> _written {0};     //已写出条数
+    std::atomic<uint64_t> _pushed {0};      //已入队条数
+    int64_t _start_ns;
+    std::atomic<bool> _running {true};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake_cv;
+    std::thread _writer;
+};
+
+}
+
+/**
+ * @brief 日志宏
+ *
+ * 级别低于NS_LOG_LEVEL时整条语句在编译期去除；运行期未启用时只做一次原子读，参数不求值。
+ * 用法：NS_LOG_DEBUG("左边缘点方差：%f", stdev);
+ */
+#define NS_LOG(level, ...) \
+    do { \
+        if constexpr((level) >= NS_LOG_LEVEL) { \
+            if(::common::Logger::Instance().Enabled(level)) \
+                ::common::Logger::Instance().Write(level, __VA_ARGS__); \
+        } \
+    } while(0)
+
+#define NS_LOG_TRACE(...) NS_LOG(NS_LOG_LEVEL_TRACE, __VA_ARGS__)
+#define NS_LOG_DEBUG(...) NS_LOG(NS_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define NS_LOG_INFO(...)  NS_LOG(NS_LOG_LEVEL_INFO, __VA_ARGS__)
+#define NS_LOG_WARN(...)  NS_LOG(NS_LOG_LEVEL_WARN, __VA_ARGS__)
+#define NS_LOG_ERROR(...) NS_LOG(NS_LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -100,11 +100,38 @@ namespace common{
     // 计算组合数
     int Combination(int n, int k);
 
-    // 贝塞尔曲线（优化版本）
-    std::vector<POINT> Bazier(double dt,std::vector<POINT> points);
+    // 德卡斯特茹算法使用栈上缓冲的最大控制点数（超过时使用堆上缓冲）
+    #define BEZIER_MAX_POINTS 8
 
-    // 贝塞尔曲线（德卡斯特茹算法版本）
-    std::vector<POINT> Bazier_DeCasteljau(double dt, std::vector<POINT> points);
+    /**
+     * @brief 伯恩斯坦系数表
+     *
+     * 以(次数,采样数)为键缓存，t_k = k / (samples - 1) 均匀采样，
+     * weights[k * (degree + 1) + i] = C(n,i) * t_k^i * (1-t_k)^(n-i)
+     */
+    struct Bernstein_Table
+    {
+        int degree = 0;               // 曲线次数
+        int samples = 0;              // 采样点数（含首尾）
+        std::vector<double> weights;  // 系数表，按行存储
+    };
+
+    // 获取伯恩斯坦系数表（线程内缓存）
+    const Bernstein_Table& Get_Bernstein_Table(int degree, int samples);
+
+    // 贝塞尔曲线（系数表 + 前向差分，输出写入调用方缓冲区）
+    void Bazier(double dt, const POINT* points, size_t count, std::vector<POINT>& output);
+    inline void Bazier(double dt, const std::vector<POINT>& points, std::vector<POINT>& output)
+    {
+        Bazier(dt, points.data(), points.size(), output);
+    }
+
+    // 贝塞尔曲线（德卡斯特茹算法版本，输出写入调用方缓冲区）
+    void Bazier_DeCasteljau(double dt, const POINT* points, size_t count, std::vector<POINT>& output);
+    inline void Bazier_DeCasteljau(double dt, const std::vector<POINT>& points, std::vector<POINT>& output)
+    {
+        Bazier_DeCasteljau(dt, points.data(), points.size(), output);
+    }
 
     // 将double转换为字符串
     auto Double_To_String(double val,int fixed);
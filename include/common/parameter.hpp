@@ -15,8 +15,25 @@ public:
 
     void Add_Parameter(const std::string& key, const nlohmann::json& value);
     nlohmann::json Get_Parameter(const std::string& key);
+    const std::string& Get_Config_Path() const { return _config_path; }
+
+    /**
+     * @brief 覆盖参数（只在内存中生效，不写回配置文件）
+     * @details 对之后所有Parameter对象的Get_Parameter生效，须在构造读取该参数的对象之前设置，
+     *          供离线回放等工具替换输入源、关闭界面
+     */
+    static void Override(const std::string& key, const nlohmann::json& value);
+
+    /**
+     * @brief 只对当前线程覆盖参数，优先于Override
+     * @details 批量回放时每个工作线程在构造流水线前设置自己的输入源和参数组
+     */
+    static void Override_Thread(const std::string& key, const nlohmann::json& value);
+    static void Clear_Thread_Overrides();
 
 private:
+    static nlohmann::json _overrides;   //覆盖的参数
+    static thread_local nlohmann::json _thread_overrides;   //当前线程覆盖的参数
     nlohmann::json _config; //配置文件
     std::string _config_path; //配置文件路径
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace common{
+
+/**
+ * @brief 硬件计数器
+ */
+enum Perf_Counter
+{
+    PERF_CYCLES = 0,        // CPU周期
+    PERF_INSTRUCTIONS,      // 指令数
+    PERF_CACHE_MISSES,      // 缓存未命中
+    PERF_BRANCH_MISSES,     // 分支预测失败
+    PERF_COUNTERS
+};
+
+/**
+ * @brief 一次计数器读数
+ */
+struct Perf_Sample
+{
+    uint64_t value[PERF_COUNTERS];
+    uint8_t valid;      // 按位表示各计数器是否可用
+};
+
+/**
+ * @brief perf_event硬件计数器（可选）
+ *
+ * 每个线程在首次读取时打开自己的计数器组（仅统计本线程、用户态），一次read读出全部计数器。
+ * 权限不足（perf_event_paranoid）或硬件不支持时该线程不计数，计时统计不受影响。
+ */
+class Perf_Counters
+{
+public:
+    /**
+     * @brief 开启或关闭计数
+     * @return 开启时当前线程能否打开计数器，不能时保持关闭
+     */
+    static bool Enable(bool enable);
+    static bool Enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 读取当前线程的计数器
+     * @return 未开启或本线程不可用时返回false
+     */
+    static bool Read(Perf_Sample& sample);
+
+    static const char* Name(int counter);
+
+private:
+    static std::atomic<bool> _enabled;
+};
+
+}
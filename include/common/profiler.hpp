@@ -0,0 +1,181 @@
+#pragma once
+
+#include "common/clock.hpp"
+#include "common/histogram.hpp"
+#include "common/lockfree.hpp"
+#include "common/perfcounter.hpp"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace common{
+
+/**
+ * @brief 计时阶段
+ */
+enum class Stage : uint8_t
+{
+    Frame = 0,          // 整帧
+    Capture,            // 图像采集
+    Preprocess,         // 缩放、灰度、二值化
+    Track_Recognition,  // 迷宫巡线
+    Edge_Extract,       // 边缘提取
+    Recognition_Element,// 元素识别
+    Middle_Error,       // 补线及中线误差
+    Fitting,            // 中心线拟合
+    Speed_Control,      // 速度规划
+    Control,            // 控制周期
+    Uart_Tx,            // 串口写出
+    COUNT
+};
+
+#define PROFILE_TRACE_QUEUE 8192    //追踪事件队列容量
+
+/**
+ * @brief 追踪事件（Chrome trace-event的完整事件）
+ */
+struct Trace_Event
+{
+    int64_t start_ns;
+    int64_t duration_ns;
+    uint32_t thread;
+    Stage stage;
+};
+
+/**
+ * @brief 分阶段性能统计
+ *
+ * 每个阶段一个无锁延迟直方图（纳秒），任意线程可记录。开启追踪时同时把事件写入无锁队列，
+ * 由Flush_Trace写到Chrome trace-event JSON文件（chrome://tracing 或 Perfetto打开）。
+ * 计时作用域记录到当前线程绑定的统计对象，未绑定时为全局对象，批量回放时各线程可互不干扰。
+ * 开启硬件计数器（Perf_Counters）时同时累计各阶段的周期、指令、缓存未命中和分支预测失败。
+ */
+class Profiler
+{
+public:
+    Profiler() { Reset(); }
+    ~Profiler();
+
+    /**
+     * @brief 全局统计对象
+     */
+    static Profiler& Global();
+
+    /**
+     * @brief 当前线程绑定的统计对象
+     */
+    static Profiler& Current();
+
+    /**
+     * @brief 绑定当前线程的统计对象，nullptr恢复为全局对象
+     */
+    static void Bind(Profiler* profiler);
+
+    /**
+     * @brief 记录一次阶段耗时
+     */
+    void Record(Stage stage, int64_t start_ns, int64_t end_ns);
+
+    /**
+     * @brief 累计一次阶段的硬件计数器增量
+     */
+    void Record_Counters(Stage stage, const Perf_Sample& begin, const Perf_Sample& end);
+
+    /**
+     * @brief 阶段的硬件计数器累计值
+     * @return 计数的调用次数
+     */
+    uint64_t Counters(Stage stage, uint64_t value[PERF_COUNTERS]) const;
+
+    const Histogram& Get(Stage stage) const { return _stages[(int)stage]; }
+    uint32_t Last(Stage stage) const { return _last_ns[(int)stage].load(std::memory_order_relaxed); }    //最近一次耗时（纳秒）
+    static const char* Name(Stage stage);
+
+    /**
+     * @brief 各阶段P50/P90/P99/最大值报表
+     */
+    std::string Report() const;
+
+    void Reset();
+
+    /**
+     * @brief 累加另一个统计对象的直方图和计数器（批量回放汇总各线程结果）
+     */
+    void Merge(const Profiler& other);
+
+    /**
+     * @brief 开始输出Chrome trace
+     * @param path 输出文件路径
+     * @return 是否成功打开文件
+     */
+    bool Start_Trace(const std::string& path);
+
+    /**
+     * @brief 把队列中的追踪事件写入文件（仅一个线程调用，不在帧内调用）
+     */
+    void Flush_Trace();
+
+    /**
+     * @brief 写完剩余事件并关闭文件
+     */
+    void Stop_Trace();
+
+    uint64_t Dropped_Events() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    Histogram _stages[(int)Stage::COUNT];
+    std::atomic<uint64_t> _counters[(int)Stage::COUNT][PERF_COUNTERS];
+    std::atomic<uint64_t> _counted[(int)Stage::COUNT];
+    std::atomic<uint32_t> _last_ns[(int)Stage::COUNT];
+    std::atomic<uint8_t> _counter_valid {0};     //出现过的计数器
+    std::atomic<bool> _tracing {false};
+    std::atomic<uint64_t> _dropped {0};
+    Mpsc_Queue<Trace_Event, PROFILE_TRACE_QUEUE> _events;
+    std::mutex _trace_mutex;    //仅保护文件
+    std::ofstream _trace;
+    bool _first_event = true;
+    int64_t _trace_start_ns = 0;
+};
+
+/**
+ * @brief 计时作用域，析构时记录到当前线程的统计对象
+ */
+class Profile_Scope
+{
+public:
+    explicit Profile_Scope(Stage stage) : _stage(stage)
+    {
+        _counting = Perf_Counters::Enabled() && Perf_Counters::Read(_begin);
+        _start = Now_Ns();
+    }
+    ~Profile_Scope()
+    {
+        int64_t end = Now_Ns();
+        Profiler& profiler = Profiler::Current();
+        Perf_Sample sample;
+        if(_counting && Perf_Counters::Read(sample))
+            profiler.Record_Counters(_stage, _begin, sample);
+        profiler.Record(_stage, _start, end);
+    }
+
+    Profile_Scope(const Profile_Scope&) = delete;
+    Profile_Scope& operator=(const Profile_Scope&) = delete;
+
+private:
+    Stage _stage;
+    int64_t _start;
+    bool _counting;
+    Perf_Sample _begin;
+};
+
+}
+
+#define NS_PROFILE_CONCAT_(a, b) a##b
+#define NS_PROFILE_CONCAT(a, b) NS_PROFILE_CONCAT_(a, b)
+
+/**
+ * @brief 从此处到作用域结束计时，用法：NS_PROFILE(Edge_Extract);
+ */
+#define NS_PROFILE(stage) ::common::Profile_Scope NS_PROFILE_CONCAT(_profile_scope_, __LINE__)(::common::Stage::stage)
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// USB通信帧
+#define USB_FRAME_HEAD 0x42 // USB通信帧头
+#define USB_FRAME_LENMIN 4  // USB通信帧最短字节长度
+#define USB_FRAME_LENMAX 24 // USB通信帧最长字节长度（含IMU等遥测帧）
+
+// USB通信地址
+#define USB_ADDR_CARCTRL 1 // 智能车速度+方向控制
+#define USB_ADDR_ENCODER 2 // 编码器测速（下位机上报）
+#define USB_ADDR_IMU 3     // 惯性测量单元（下位机上报）
+#define USB_ADDR_BUZZER 4  // 蜂鸣器音效控制
+#define USB_ADDR_LED 5     // LED灯效控制
+#define USB_ADDR_KEY 6     // 按键信息
+
+namespace common{
+namespace protocol{
+
+/**
+ * @brief USB通信帧描述
+ *
+ * 帧格式：帧头 | 地址 | 帧长 | 字段... | 校验和，校验和为之前所有字节的累加。
+ * 字段按声明顺序紧凑排列（小端，与下位机一致），偏移与帧长均在编译期确定，
+ * 编解码为定长memcpy加定长累加，无堆分配、无分支。
+ * @tparam Addr 通信地址
+ * @tparam Fields 字段类型，必须可平凡拷贝
+ */
+template<uint8_t Addr, typename... Fields>
+struct Message
+{
+    static_assert((std::is_trivially_copyable<Fields>::value && ...), "帧字段必须可平凡拷贝");
+
+    static constexpr uint8_t ADDR = Addr;
+    static constexpr size_t PAYLOAD = (sizeof(Fields) + ... + 0);     // 数据字节数
+    static constexpr size_t LENGTH = PAYLOAD + 4;                     // 帧长（含帧头、地址、帧长、校验和）
+
+    static_assert(LENGTH <= USB_FRAME_LENMAX, "帧长超过USB_FRAME_LENMAX");
+
+    /**
+     * @brief 第I个字段在帧中的偏移
+     */
+    static constexpr size_t Offset(size_t index)
+    {
+        constexpr size_t sizes[] = {0, sizeof(Fields)...};
+        size_t offset = 3;
+        for(size_t i = 0; i < index; i++)
+            offset += sizes[i + 1];
+        return offset;
+    }
+
+    /**
+     * @brief 计算校验和
+     * @param frame 帧数据（至少LENGTH字节）
+     */
+    static uint8_t Checksum(const uint8_t* frame)
+    {
+        uint8_t check = 0;
+        for(size_t i = 0; i < LENGTH - 1; i++)
+            check += frame[i];
+        return check;
+    }
+
+    /**
+     * @brief 编码
+     * @param frame 输出缓冲（至少LENGTH字节）
+     * @param fields 字段值
+     */
+    static void Encode(uint8_t* frame, const Fields&... fields)
+    {
+        frame[0] = USB_FRAME_HEAD;
+        frame[1] = ADDR;
+        frame[2] = static_cast<uint8_t>(LENGTH);
+        Put(frame, std::index_sequence_for<Fields...>{}, fields...);
+        frame[LENGTH - 1] = Checksum(frame);
+    }
+
+    /**
+     * @brief 解码
+     * @param frame 帧数据（至少LENGTH字节）
+     * @param fields 输出字段
+     * @return 地址、帧长及校验和是否匹配
+     */
+    static bool Decode(const uint8_t* frame, Fields&... fields)
+    {
+        Get(frame, std::index_sequence_for<Fields...>{}, fields...);
+        return (frame[1] == ADDR) & (frame[2] == LENGTH) & (frame[LENGTH - 1] == Checksum(frame));
+    }
+
+private:
+    template<size_t... I>
+    static void Put(uint8_t* frame, std::index_sequence<I...>, const Fields&... fields)
+    {
+        (std::memcpy(frame + Offset(I), &fields, sizeof(Fields)), ...);
+    }
+
+    template<size_t... I>
+    static void Get(const uint8_t* frame, std::index_sequence<I...>, Fields&... fields)
+    {
+        (std::memcpy(&fields, frame + Offset(I), sizeof(Fields)), ...);
+    }
+};
+
+// ========================================== 帧定义 ==========================================
+
+// 速度+方向控制：速度(m/s) + 舵机PWM(500~2500)
+using Car_Control = Message<USB_ADDR_CARCTRL, float, uint16_t>;
+
+// 蜂鸣器音效：音效编号(1~5)
+using Buzzer_Sound = Message<USB_ADDR_BUZZER, uint8_t>;
+
+// LED灯效：R + G + B
+using Led_Color = Message<USB_ADDR_LED, uint8_t, uint8_t, uint8_t>;
+
+// 按键：按键编号
+using Key_Press = Message<USB_ADDR_KEY, uint8_t>;
+
+// 编码器：实测车速(m/s) + 累计脉冲数
+using Encoder = Message<USB_ADDR_ENCODER, float, int32_t>;
+
+// IMU：偏航角速度(rad/s) + 纵向加速度(m/s^2) + 横向加速度(m/s^2)
+using Imu = Message<USB_ADDR_IMU, float, float, float>;
+
+}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace common{
+
+#define SHM_NAME "/natural_selection"   //默认共享内存名（位于/dev/shm）
+#define SHM_MAGIC 0x3146534E            //"NSF1"
+#define SHM_SLOTS 4                     //环形槽数
+#define SHM_MAX_POINTS 512              //每条线最多点数
+#define SHM_SCENE_LENGTH 24             //场景名长度
+
+/**
+ * @brief 共享内存中的点
+ */
+struct Shm_Point
+{
+    int16_t x;
+    int16_t y;
+};
+
+/**
+ * @brief 叠加信息（由查看器绘制）
+ */
+struct Shm_Overlay
+{
+    uint64_t frame_id;          //帧序号
+    int64_t stamp_ns;           //发布时间（单调时钟）
+    char scene[SHM_SCENE_LENGTH];   //场景名
+    float fps;                  //平均帧率
+    int32_t control_center;     //控制中心x坐标
+    int32_t control_row;        //控制中心所在行
+    float sigma;                //中心线拟合残差
+    float speed;                //速度
+    uint16_t servo_pwm;         //舵机PWM
+    uint16_t line_count;        //左、中、右线点数
+    uint16_t center_count;      //拟合中心线点数
+    uint16_t reserved;
+    Shm_Point left[SHM_MAX_POINTS];
+    Shm_Point middle[SHM_MAX_POINTS];
+    Shm_Point right[SHM_MAX_POINTS];
+    Shm_Point center[SHM_MAX_POINTS];
+    Shm_Point corners[4];       //左下、右下、左上、右上角点
+};
+
+/**
+ * @brief 共享内存头部
+ *
+ * 槽i位于 sizeof(Shm_Header) + i * slot_size 处，每个槽依次存放Shm_Slot、原始图像、二值图像。
+ */
+struct alignas(64) Shm_Header
+{
+    uint32_t magic;             //发布端初始化完成后写入
+    uint32_t slots;             //槽数
+    uint32_t slot_size;         //单个槽字节数
+    uint32_t image_capacity;    //单幅图像容量（字节）
+    std::atomic<uint64_t> latest;   //最新帧序号，所在槽为latest % slots，0表示尚无帧
+};
+
+/**
+ * @brief 槽头部，seq为顺序锁：奇数表示写入中
+ */
+struct alignas(64) Shm_Slot
+{
+    std::atomic<uint32_t> seq;
+    int32_t raw_rows, raw_cols, raw_type;
+    int32_t binary_rows, binary_cols, binary_type;
+    Shm_Overlay overlay;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "共享内存中的原子变量必须无锁");
+
+/**
+ * @brief 帧发布端（视觉进程）
+ *
+ * 每帧写入环形中的下一个槽，写完后更新latest。写端从不等待读端，
+ * 读端落后时直接跳到最新帧；只有读端正在读的槽被整圈覆盖时该次读取作废重试。
+ */
+class FramePublisher
+{
+public:
+    ~FramePublisher();
+
+    /**
+     * @brief 创建共享内存
+     * @param width 图像最大宽度
+     * @param height 图像最大高度
+     * @param name 共享内存名
+     * @return 是否成功
+     */
+    bool Open(int width, int height, const std::string& name = SHM_NAME);
+    bool Is_Open() const { return _header != nullptr; }
+
+    /**
+     * @brief 发布一帧（仅允许一个写线程）
+     * @param raw 原始图像（8位，最多3通道）
+     * @param binary 二值图像
+     * @param overlay 叠加信息
+     */
+    void Publish(const cv::Mat& raw, const cv::Mat& binary, const Shm_Overlay& overlay);
+
+private:
+    std::string _name;
+    Shm_Header* _header = nullptr;
+    size_t _size = 0;
+    uint64_t _count = 0;
+};
+
+/**
+ * @brief 共享内存中读出的一帧
+ */
+struct Shm_Frame
+{
+    cv::Mat raw;
+    cv::Mat binary;
+    Shm_Overlay overlay;
+};
+
+/**
+ * @brief 帧订阅端（查看器进程），只读映射
+ */
+class FrameSubscriber
+{
+public:
+    ~FrameSubscriber();
+
+    /**
+     * @brief 连接共享内存
+     * @param path 共享内存名（以/开头且不含其他/），或经挂载访问的文件路径
+     * @return 是否成功
+     */
+    bool Attach(const std::string& path = SHM_NAME);
+    bool Is_Attached() const { return _header != nullptr; }
+    void Detach();
+
+    /**
+     * @brief 读取最新帧
+     * @param frame 输出帧
+     * @return 是否读到新帧（与上次读取的帧不同）
+     */
+    bool Read(Shm_Frame& frame);
+
+    uint64_t Retries() const { return _retries; }   //读到写入中的槽而重试的次数
+
+private:
+    const Shm_Header* _header = nullptr;
+    size_t _size = 0;
+    uint64_t _last = 0;
+    uint64_t _retries = 0;
+};
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace common{
+
+#define RECORDING_MAGIC "NSREC1\0"          //录制文件头（8字节，含结尾0）
+#define RECORDING_ALIGN 8                   //数据块按8字节对齐
+#define RECORDING_EXTENSION ".nsrec"
+
+// 帧编码（fourcc）
+#define RECORDING_CODEC_MJPG 0x47504A4D     //'MJPG'：摄像头输出的原始MJPEG数据，未重新编码
+#define RECORDING_CODEC_BGR 0x33524742      //'BGR3'：未压缩的BGR图像（摄像头不输出MJPEG或输入为视频文件时）
+
+/**
+ * @brief 数据块类型
+ */
+enum class Chunk_Type : uint32_t
+{
+    CONFIG = 1,     //参数快照（JSON文本）
+    FRAME = 2,      //一帧图像：Recording_Frame + 编码数据
+    UART_RX = 3,    //一条校验通过的下位机消息（完整帧）
+    UART_TX = 4,    //一批写出到串口的数据（若干完整帧）
+};
+
+/**
+ * @brief 文件头
+ */
+struct Recording_Header
+{
+    char magic[8];
+    uint32_t header_size;       //sizeof(Recording_Header)
+    uint32_t chunk_header_size; //sizeof(Recording_Chunk)
+    int64_t start_ns;           //开始录制的时间（单调时钟，与各数据块时间戳同源）
+    int64_t wall_time;          //开始录制的日历时间（秒）
+    uint64_t index_offset;      //索引位置，0为未正常关闭（读取时顺序扫描重建索引）
+    uint64_t index_count;       //索引条数
+};
+
+/**
+ * @brief 数据块头，其后紧跟size字节数据，再补齐到RECORDING_ALIGN
+ */
+struct Recording_Chunk
+{
+    uint32_t type;              //Chunk_Type
+    uint32_t size;              //数据字节数
+    int64_t stamp_ns;           //采集/收发时间（common::Now_Ns）
+};
+
+/**
+ * @brief 图像数据块的定长部分，其后为编码数据
+ */
+struct Recording_Frame
+{
+    uint32_t frame_id;          //帧序号（从1开始）
+    uint32_t codec;             //RECORDING_CODEC_*
+    uint16_t width;             //图像尺寸
+    uint16_t height;
+    uint32_t reserved;
+};
+
+/**
+ * @brief 索引项（文件末尾，按写入顺序排列）
+ */
+struct Recording_Index
+{
+    uint64_t offset;            //数据块头的位置
+    int64_t stamp_ns;           //数据块时间戳
+    uint32_t type;              //Chunk_Type
+    uint32_t size;              //数据字节数
+};
+
+/**
+ * @brief 录制写出
+ *
+ * 采集线程、串口IO线程等只把数据块拷入队列，由后台线程顺序写出并记录索引，不阻塞调用线程；
+ * 队列超过上限时丢弃新数据块并计数。关闭时在文件末尾写出索引并回填文件头，
+ * 程序异常退出时索引缺失，读取时顺序扫描重建。
+ */
+class RecordingWriter
+{
+public:
+    /**
+     * @param queue_limit 队列最多缓存的字节数
+     */
+    explicit RecordingWriter(size_t queue_limit = 64 << 20);
+    ~RecordingWriter();
+
+    /**
+     * @brief 创建录制文件并写入参数快照
+     * @param config 参数快照（JSON文本）
+     * @return 是否成功
+     */
+    bool Open(const std::string& path, const std::string& config);
+
+    /**
+     * @brief 写出剩余数据、索引及文件头后关闭
+     */
+    void Close();
+
+    bool Is_Open() const { return _open.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 记录一帧图像（任意线程）
+     * @param codec RECORDING_CODEC_*
+     * @param data 编码数据
+     */
+    void Write_Frame(int64_t stamp_ns, uint32_t frame_id, uint32_t codec, int width, int height, const void* data, size_t size);
+
+    /**
+     * @brief 记录串口收发数据（任意线程）
+     * @param type UART_RX或UART_TX
+     */
+    void Write_Uart(Chunk_Type type, int64_t stamp_ns, const void* data, size_t size);
+
+    uint64_t Dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    uint64_t Chunks() const { return _chunks.load(std::memory_order_relaxed); }
+    const std::string& Path() const { return _path; }
+
+private:
+    void Append(Chunk_Type type, int64_t stamp_ns, const void* head, size_t head_size, const void* data, size_t size);
+    void Writer_Loop();
+
+    std::string _path;
+    FILE* _file = nullptr;
+    Recording_Header _header;               //关闭时回填索引位置
+    std::atomic<bool> _open {false};
+    size_t _queue_limit;
+
+    std::mutex _mutex;                      //保护_queue、_queued及_running
+    std::condition_variable _cv;
+    std::deque<std::vector<uint8_t>> _queue;    //待写出的数据块（含块头及对齐）
+    size_t _queued = 0;                     //队列中的字节数
+    bool _running = false;
+    std::thread _thread;
+
+    std::vector<Recording_Index> _index;    //仅写线程访问
+    uint64_t _offset = 0;                   //下一个数据块的位置（仅写线程访问）
+    std::atomic<uint64_t> _dropped {0};     //队列满时丢弃的数据块
+    std::atomic<uint64_t> _chunks {0};      //已写出的数据块
+};
+
+/**
+ * @brief 录制读取
+ *
+ * 只读映射文件，按类型整理索引，可按序号或时间随机访问，数据不拷贝。对象只读，可多线程共享。
+ */
+class RecordingReader
+{
+public:
+    ~RecordingReader();
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    /**
+     * @brief 打开录制文件
+     * @return 失败时返回nullptr
+     */
+    static std::shared_ptr<RecordingReader> Open(const std::string& path);
+
+    /**
+     * @brief 路径是否为录制文件（按扩展名）
+     */
+    static bool Is_Recording(const std::string& path);
+
+    const Recording_Header& Header() const { return *_header; }
+    const std::vector<Recording_Index>& Frames() const { return _frames; }
+    const std::vector<Recording_Index>& Uart_Rx() const { return _uart_rx; }
+    const std::vector<Recording_Index>& Uart_Tx() const { return _uart_tx; }
+    bool Recovered() const { return _recovered; }   //索引缺失，由顺序扫描重建
+
+    /**
+     * @brief 参数快照（JSON文本），没有时为空
+     */
+    std::string Config() const;
+
+    /**
+     * @brief 数据块的数据（映射内存，不拷贝）
+     */
+    const uint8_t* Payload(const Recording_Index& entry) const { return _base + entry.offset + sizeof(Recording_Chunk); }
+
+    const Recording_Frame& Frame_Info(size_t k) const { return *reinterpret_cast<const Recording_Frame*>(Payload(_frames[k])); }
+
+    /**
+     * @brief 第k帧的编码数据及字节数（不含Recording_Frame）
+     */
+    const uint8_t* Frame_Data(size_t k, size_t& size) const
+    {
+        size = _frames[k].size - sizeof(Recording_Frame);
+        return Payload(_frames[k]) + sizeof(Recording_Frame);
+    }
+
+    /**
+     * @brief 第一个时间戳不早于stamp_ns的帧，没有时返回帧数
+     */
+    size_t Find_Frame(int64_t stamp_ns) const;
+
+    /**
+     * @brief 回放时钟偏移：录制时间 + 偏移 = 回放时间
+     * @details 未设置时以当前时刻对齐录制开始时刻，摄像头与串口回放共用，保持两者的相对时序
+     */
+    int64_t Replay_Offset();
+
+    /**
+     * @brief 设置回放时钟偏移（不按录制时间等待时由摄像头逐帧设置，串口回放随之推进）
+     */
+    void Set_Replay_Offset(int64_t offset);
+
+private:
+    RecordingReader() = default;
+    bool Scan();
+
+    const uint8_t* _base = nullptr;
+    size_t _size = 0;
+    const Recording_Header* _header = nullptr;
+    std::vector<Recording_Index> _frames;
+    std::vector<Recording_Index> _uart_rx;
+    std::vector<Recording_Index> _uart_tx;
+    std::vector<Recording_Index> _config;
+    bool _recovered = false;
+    std::atomic<int64_t> _replay_offset {0};
+    std::atomic<int> _replay_state {0};         //0：未设置，1：设置中，2：已设置
+};
+
+}
@@ -23,87 +23,207 @@
  *
  */
 
-#include "common.hpp"
+#include "common/clock.hpp"
+#include "common/lockfree.hpp"
+#include "common/protocol.hpp"
+#include "common/recording.hpp"
 #include <iostream>               // 输入输出类
-#include <libserial/SerialPort.h> // 串口通信
 #include <math.h>                 // 数学函数类
 #include <stdint.h>               // 整型数据类
 #include <string.h>
 #include <thread>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <map>
+#include <vector>
 
-using namespace LibSerial;
 using namespace std;
 
-// USB通信帧
-#define USB_FRAME_HEAD 0x42 // USB通信帧头
-#define USB_FRAME_LENMIN 4  // USB通信帧最短字节长度
-#define USB_FRAME_LENMAX 12 // USB通信帧最长字节长度
-
-// USB通信地址
-#define USB_ADDR_CARCTRL 1 // 智能车速度+方向控制
-#define USB_ADDR_BUZZER 4  // 蜂鸣器音效控制
-#define USB_ADDR_LED 5     // LED灯效控制
-#define USB_ADDR_KEY 6     // 按键信息
+// USB通信帧（帧头、地址及帧格式见common/protocol.hpp）
+#define USB_TX_BUFFER_MAX 4096 // 发送缓冲上限（字节），超过后丢弃新帧
+#define USB_RX_RING_SIZE 1024  // 接收环形缓冲大小（字节，2的幂）
+#define USB_RX_QUEUE_SIZE 64   // 接收消息队列容量（2的幂）
+#define USB_BAUD_RATE 115200   // 波特率
+#define USB_TX_SLOTS 2         // 状态类指令槽数（速度+方向、LED）
 
 // PWM舵机相关常量
 #define PWMSERVOMID 1500   // 舵机中位值
 
 class Uart {
+public:
+  /**
+   * @brief 校验通过的下位机消息
+   *
+   */
+  struct Message {
+    uint8_t addr = 0;                  // 地址
+    uint8_t length = 0;                // 帧长
+    uint8_t buff[USB_FRAME_LENMAX];    // 完整帧数据（含帧头和校验位）
+    int64_t stamp = 0;                 // 接收时间（common::Now_Ns）
+  };
+
+  /**
+   * @brief 下位机遥测状态（编码器测速、IMU）
+   *
+   */
+  struct Telemetry {
+    int64_t encoderStamp = 0; // 编码器数据接收时间（common::Now_Ns），0为未收到
+    float speed = 0;          // 实测车速（m/s）
+    int32_t pulses = 0;       // 累计脉冲数
+    int64_t imuStamp = 0;     // IMU数据接收时间（common::Now_Ns），0为未收到
+    float yawRate = 0;        // 偏航角速度（rad/s）
+    float accX = 0;           // 纵向加速度（m/s^2）
+    float accY = 0;           // 横向加速度（m/s^2）
+  };
+
 private:
   /**
-   * @brief 串口通信结构体
+   * @brief 接收解码状态
+   *
+   */
+  enum RxState {
+    RX_HEAD = 0, // 等待帧头
+    RX_ADDR,     // 地址
+    RX_LEN,      // 帧长
+    RX_BODY,     // 数据及校验位
+  };
+
+  /**
+   * @brief 状态类指令槽：同一地址只保留最新一帧，未发出的旧指令直接被覆盖
    *
    */
-  typedef struct {
-    bool start;                           // 开始接收标志
-    uint8_t index;                        // 接收序列
-    uint8_t buffRead[USB_FRAME_LENMAX];   // 临时缓冲数据
-    uint8_t buffFinish[USB_FRAME_LENMAX]; // 校验成功数据
-  } SerialStruct;
+  struct TxSlot {
+    uint8_t frame[USB_FRAME_LENMAX]; // 最新指令帧
+    uint8_t length = 0;              // 帧长，0表示尚无指令
+    bool dirty = false;              // 有未发出的新指令
+    int64_t lastSent = 0;            // 最近写出时间
+  };
 
-  std::unique_ptr<std::thread> threadRec; // 串口接收子线程
-  std::shared_ptr<SerialPort> serialPort = nullptr;
+  std::unique_ptr<std::thread> threadIo; // 串口IO子线程（独占文件描述符）
   std::string portName; // 端口名字
-  bool isOpen = false;
-  SerialStruct serialStr; // 串口通信数据结构体
+  int fd = -1;          // 串口文件描述符（非阻塞）
+  int epollFd = -1;     // epoll实例
+  int eventFd = -1;     // 唤醒IO线程
+  std::atomic<bool> isOpen{false};
+  std::atomic<bool> ioRunning{false}; // IO线程运行标志
+  std::atomic<bool> rxEnabled{false}; // 接收使能
+
+  // 接收环形缓冲（仅IO线程访问），位置为单调递增的绝对序号
+  uint8_t rxRing[USB_RX_RING_SIZE];
+  size_t rxHead = 0;        // 当前帧起始（之前的数据已丢弃）
+  size_t rxScan = 0;        // 下一个待解码字节
+  size_t rxTail = 0;        // 写入位置
+  RxState rxState = RX_HEAD;
+  uint8_t rxLength = 0;     // 当前帧长
+  uint8_t rxCheck = 0;      // 当前帧累加校验和
+  std::atomic<uint32_t> rxErrors{0};  // 帧错误（重同步）次数
+  std::atomic<uint32_t> rxDropped{0}; // 消息队列满时丢弃的消息数
+  std::atomic<bool> rxSubscribed{false}; // 已有消费者，接收消息才入队
+  common::Spsc_Queue<Message, USB_RX_QUEUE_SIZE> rxQueue; // 接收消息队列
+  Telemetry rxTelemetry;                        // 遥测状态（仅写线程访问）
+  common::Mailbox<Telemetry> telemetryBox;      // 遥测状态信箱
+  std::shared_ptr<common::RecordingWriter> recording; // 运行录制（收发数据）
+  std::shared_ptr<common::RecordingReader> replay;    // 回放的录制文件，非空时为回放模式（无串口）
+  std::atomic<uint32_t> replayCompared{0};   // 回放时与录制比较的指令帧数
+  std::atomic<uint32_t> replayMismatches{0}; // 回放时与录制不一致的指令帧数
+  std::atomic<int64_t> txStamp{0}; // 最近一次控制指令写出时间（common::Now_Ns）
+  std::atomic<uint32_t> txDropped{0}; // 发送缓冲满时丢弃的帧数
+
+  std::atomic<uint32_t> txCoalesced{0}; // 未发出即被新指令覆盖的帧数
+  std::atomic<uint32_t> txUnchanged{0}; // 与上次发送相同而省略的帧数
+  std::atomic<uint32_t> txHeartbeats{0}; // 心跳帧数
+  std::atomic<int64_t> txMinInterval{5000000}; // 同一地址最小发送间隔（纳秒）
+  std::atomic<int64_t> txHeartbeat{100000000}; // 控制指令心跳周期（纳秒），0为关闭
+  std::atomic<float> txUtilisation{0};  // 链路占用率（最近一秒）
+
+  std::mutex txMutex;             // 保护txBuffer及txSlots
+  std::vector<uint8_t> txBuffer;  // 事件类待发送数据（如蜂鸣器，按顺序全部发送）
+  TxSlot txSlots[USB_TX_SLOTS];   // 状态类指令槽
+  std::vector<uint8_t> txWriting; // 正在写出的数据（仅IO线程访问）
+  size_t txOffset = 0;            // txWriting已写出字节数
+  bool writingControl = false;    // txWriting中包含新的控制指令
+  int64_t txDeadline = INT64_MAX; // 下一次限速到期或心跳时间（仅IO线程访问）
+  int64_t txWindowStart = 0;      // 链路占用统计窗口起点
+  uint64_t txWindowBytes = 0;     // 窗口内写出字节数
 
   /**
-   * @brief 32位数据内存对齐/联合体
+   * @brief 提交一帧数据，必要时唤醒IO线程
    *
+   * 状态类指令写入对应地址的指令槽（与上次发送相同则省略），事件类指令追加到发送缓冲
+   *
+   * @param data 帧数据
+   * @param len 帧长
+   * @return int 0：成功；-1：串口未打开；-2：发送缓冲已满
    */
-  typedef union {
-    uint8_t buff[4];
-    float float32;
-    int int32;
-  } Bit32Union;
+  int submit(const uint8_t *data, size_t len);
 
   /**
-   * @brief 16位数据内存对齐/联合体
+   * @brief 地址对应的状态类指令槽
    *
+   * @param addr 通信地址
+   * @return int 槽序号，事件类指令返回-1
    */
-  typedef union {
-    uint8_t buff[2];
-    int int16;
-    uint16_t uint16;
-  } Bit16Union;
+  static int slotIndex(uint8_t addr);
 
   /**
-   * @brief 串口接收字节数据
+   * @brief 组装下一批待写出数据：事件类指令、到期的新指令及心跳（持有txMutex时调用）
    *
-   * @param charBuffer
-   * @param msTimeout
-   * @return int
+   * @param now 当前时间
    */
-  int receiveBytes(unsigned char &charBuffer, size_t msTimeout = 0);
+  void collectTx(int64_t now);
 
   /**
-   * @brief 串口发送字节数据
+   * @brief 唤醒IO线程
    *
-   * @param data
-   * @return int
    */
-  int transmitByte(unsigned char data);
+  void wakeup(void);
+
+  /**
+   * @brief IO线程主循环：epoll等待可读、可写及唤醒事件
+   *
+   */
+  void ioLoop(void);
+
+  /**
+   * @brief 写出待发送数据，每批数据一次write
+   *
+   * @return true 已全部写出
+   * @return false 内核缓冲已满，等待可写事件
+   */
+  bool flushTx(void);
+
+  /**
+   * @brief 回放线程主循环：按录制时间注入接收消息，发送数据与录制比较而不写出
+   *
+   */
+  void replayLoop(void);
+
+  /**
+   * @brief 批量读取全部可用字节到环形缓冲并解码
+   *
+   */
+  void readAvailable(void);
+
+  /**
+   * @brief 增量解码环形缓冲中的数据
+   *
+   */
+  void decode(void);
+
+  /**
+   * @brief 当前帧校验失败，从帧头的下一字节重新搜索帧头
+   *
+   */
+  void resync(void);
+
+  /**
+   * @brief 串口通信协议数据转换
+   *
+   * @param msg 校验通过的消息
+   */
+  void dataTransform(const Message &msg);
 
 public:
   // 定义构造函数
@@ -111,7 +231,7 @@ public:
   // 定义析构函数
   ~Uart();
   
-  bool keypress = false; // 按键
+  std::atomic<bool> keypress{false}; // 按键
 
   /**
    * @brief 蜂鸣器音效
@@ -134,7 +254,25 @@ public:
   int open(void);
 
   /**
-   * @brief 启动接收子线程
+   * @brief 以录制文件代替串口（回放）
+   *
+   * 录制的接收消息按录制时间（与摄像头回放共用时钟偏移）注入，startReceive之前的消息暂缓；
+   * 发送的指令照常限速、合并后与录制的指令比较（同一地址只比较变化的帧），不一致时计数
+   *
+   * @param reader 录制文件
+   * @return int 0：成功；-1：录制文件为空；-4：eventfd创建失败
+   */
+  int openReplay(std::shared_ptr<common::RecordingReader> reader);
+
+  /**
+   * @brief 录制收发数据到运行录制文件（在open之前调用）
+   *
+   * @param writer 录制文件
+   */
+  void attachRecording(std::shared_ptr<common::RecordingWriter> writer) { recording = writer; }
+
+  /**
+   * @brief 启动接收（由IO线程处理可读事件）
    *
    */
   void startReceive(void);
@@ -146,15 +284,56 @@ public:
   void close(void);
 
   /**
-   * @brief 串口接收校验
+   * @brief 订阅下位机消息：之后接收到的消息进入队列，需由消费者持续popMessage取出
    *
+   * 未订阅时只更新遥测状态与按键，消息不入队（避免无人取用时队列满）。
    */
-  void receiveCheck(void);
+  void subscribeMessages(void) { rxSubscribed.store(true, std::memory_order_release); }
 
   /**
-   * @brief 串口通信协议数据转换
+   * @brief 取出一条下位机消息（单一消费线程调用，需先subscribeMessages）
+   *
+   * @param msg 输出消息
+   * @return true 取到消息
+   * @return false 队列为空
+   */
+  bool popMessage(Message &msg) { return rxQueue.Pop(msg); }
+
+  /**
+   * @brief 读取最新遥测状态（任意线程，不阻塞）
+   *
+   * @param telemetry 输出状态
+   * @return true 已收到过遥测数据
+   * @return false 尚未收到
+   */
+  bool telemetry(Telemetry &telemetry) const { return telemetryBox.Load(telemetry); }
+
+  /**
+   * @brief 接收帧错误（重同步）次数
+   *
+   * @return uint32_t
+   */
+  uint32_t frameErrors(void) const { return rxErrors.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 消息队列满时丢弃的下位机消息数（仅订阅后计数）
+   *
+   * @return uint32_t
+   */
+  uint32_t droppedMessages(void) const { return rxDropped.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 按帧描述编码并发送
+   *
+   * @tparam M 帧描述（common::protocol::Message）
+   * @param fields 字段值
+   * @return int 0：成功；-1：串口未打开；-2：发送缓冲已满
    */
-  void dataTransform(void);
+  template <typename M, typename... Args> int send(const Args &...fields) {
+    uint8_t frame[M::LENGTH];
+    M::Encode(frame, fields...);
+    return submit(frame, M::LENGTH);
+  }
 
   /**
    * @brief 速度+方向控制
@@ -164,6 +343,76 @@ public:
    */
   void carControl(float speed, uint16_t servo);
 
+  /**
+   * @brief 最近一次控制指令写出时间
+   *
+   * @return int64_t 时间戳（common::Now_Ns），未发送过时为0
+   */
+  int64_t lastTxNs(void) const { return txStamp.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 发送缓冲满时丢弃的帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t droppedFrames(void) const { return txDropped.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 设置状态类指令的最大发送频率
+   *
+   * @param hz 频率，0为不限速
+   */
+  void setMaxRate(int hz) { txMinInterval = hz > 0 ? 1000000000LL / hz : 0; }
+
+  /**
+   * @brief 设置控制指令心跳周期：指令未变化时按该周期重发，供下位机看门狗使用
+   *
+   * @param ms 周期（毫秒），0为关闭
+   */
+  void setHeartbeat(int ms) { txHeartbeat = ms > 0 ? ms * 1000000LL : 0; }
+
+  /**
+   * @brief 链路占用率（最近一秒写出比特数 / 波特率）
+   *
+   * @return float 0~1
+   */
+  float linkUtilisation(void) const { return txUtilisation.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 未发出即被新指令覆盖的帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t coalescedFrames(void) const { return txCoalesced.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 与上次发送相同而省略的帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t unchangedFrames(void) const { return txUnchanged.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 心跳帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t heartbeatFrames(void) const { return txHeartbeats.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 回放时与录制比较的指令帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t comparedFrames(void) const { return replayCompared.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 回放时与录制不一致的指令帧数
+   *
+   * @return uint32_t
+   */
+  uint32_t mismatchedFrames(void) const { return replayMismatches.load(std::memory_order_relaxed); }
+
   /**
    * @brief 蜂鸣器音效控制
    *
@@ -2,4 +2,8 @@
 
 #include "control/controlcenter.hpp"
 
-#include "control/motion.hpp"
\ No newline at end of file
+#include "control/speedplanner.hpp"
+
+#include "control/motion.hpp"
+
+#include "control/controlloop.hpp"
\ No newline at end of file
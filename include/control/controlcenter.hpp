@@ -15,18 +15,49 @@ class ControlCenter
 
 public:
     int _control_center;  //控制中心坐标
-    std::vector<common::POINT> _center_edge;  //控制中心线
+    std::vector<common::POINT> _center_edge;  //控制中心线（拟合曲线按行采样）
     uint16_t _left_valid_row = 0;  //左边有效行数
     uint16_t _right_valid_row = 0;  //右边有效行数
-    double _sigma_center = 0;       //中心线方差
+    double _sigma_center = 0;       //中心线拟合残差（加权均方，像素^2）
+
+    double _lateral_offset = 0;     //前瞻处横向偏差（像素，右为正）
+    double _heading = 0;            //前瞻处航向 dx/ds（s为距图像底部的行数）
+    double _curvature = 0;          //前瞻处曲率（1/像素）
+    int _look_ahead = 60;           //前瞻距离（距图像底部的行数）
+
+    ControlCenter();
 
     void Fitting(recognition::Tracking& tracking,recognition::Element& element);
 
+    // 拟合曲线求值，s为距图像底部的行数
+    double Fit_X(double s) const;
+    double Fit_Slope(double s) const;
+    double Fit_Curvature(double s) const;
+
+    // 拟合结果是否有效
+    bool Fit_Valid() const { return _fit_valid; }
+    // 拟合系数（归一化自变量u = s / 图像高度）
+    const double* Fit_Coef() const { return _fit_coef; }
+    int Fit_Order() const { return _fit_order; }
+    double Fit_Scale() const { return _fit_scale; }
+    double Fit_Range() const { return _fit_s_max; }
+    // 参与拟合的最近行（底部丢线时大于0，其下为外推）
+    double Fit_S_Min() const { return _fit_s_min; }
+
 
 private:
     std::string _style = " "; 
 
+    common::Parameter _parameter;
+    int _fit_order = 2;             //拟合阶数（2或3）
+    int _border = 2;                //边框宽度，用于判断丢线
+    bool _fit_valid = false;        //拟合是否成功
+    double _fit_coef[4] = {0, 0, 0, 0};  //x(u) = Σ a_k u^k
+    double _fit_scale = 1;          //自变量归一化系数（图像高度）
+    double _fit_s_min = 0;          //参与拟合的最近行
+    double _fit_s_max = 0;          //参与拟合的最远行
 
+    bool Solve_Fit(const double* sum_u, const double* sum_xu, int order);
 
 };
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "common.hpp"
+#include "common/histogram.hpp"
+#include "control/motion.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace control{
+
+/**
+ * @brief 视觉线程发布给控制线程的目标
+ */
+struct Vision_Target
+{
+    uint64_t frame_id = 0;  //帧序号
+    int64_t stamp_ns = 0;   //结果时间戳（common::Now_Ns）
+    int64_t capture_ns = 0; //图像采集时间戳（common::Now_Ns）
+    float error = 0;        //控制中心相对图像中心的偏差（像素）
+    float speed = 0;        //目标速度
+    int width = 0;          //图像宽度
+
+    // 中心线拟合结果，用于延迟补偿时沿路径向前预测
+    bool fit_valid = false;         //拟合是否有效
+    float fit_coef[4] = {0, 0, 0, 0};   //x(u) = Σ a_k u^k，u = s / fit_scale
+    float fit_scale = 1;            //自变量归一化系数
+    float fit_s_min = 0;            //拟合观测到的最近行
+    float fit_range = 0;            //拟合观测到的最远行
+    float look_ahead = 0;           //前瞻行
+};
+
+/**
+ * @brief 定频控制线程
+ *
+ * 以固定频率运行姿态控制并下发串口指令，与视觉帧率解耦。
+ * 视觉线程通过无锁信箱发布最新目标，控制线程按两帧结果线性外推当前偏差。
+ * PD控制状态保存在线程独占的Motion对象中。
+ *
+ * 延迟补偿：按“采集时刻 → 预计执行时刻”的实测延迟，以匀速运动模型估算车辆
+ * 前进距离，把前瞻点沿拟合中心线向前推移后再计算偏差。
+ * 车速优先使用下位机编码器实测值，遥测超时时退回指令速度。
+ */
+class ControlLoop
+{
+public:
+    ControlLoop(std::shared_ptr<Uart> uart);
+    ~ControlLoop();
+
+    void Start();
+    void Stop();
+
+    // 发布视觉结果（视觉线程调用，不阻塞）
+    void Publish(const Vision_Target& target);
+
+    // 输出采集到执行的延迟分布到性能日志
+    void Log_Latency();
+
+    // 执行一个控制周期（控制线程调用；离线回放不启动线程，由调用方按帧时间驱动）
+    void Control_Step(int64_t now);
+
+    // 最近一次下发的指令（用于显示）
+    uint16_t Get_Servo_Pwm() const { return _servo_pwm.load(std::memory_order_relaxed); }
+    float Get_Speed() const { return _speed.load(std::memory_order_relaxed); }
+
+    int _control_rate = 200;    //控制频率（Hz）
+    int _control_timeout = 200; //视觉结果超时（毫秒），超时后停车
+    bool _latency_compensation = true;  //延迟补偿使能
+    float _pixels_per_meter = 100;      //前瞻区域每米对应的图像行数
+    int _telemetry_timeout = 50;        //编码器测速有效期（毫秒），超时使用指令速度
+
+private:
+    void Loop();
+    float Predict_Error(int64_t now, float speed) const;
+    void Record_Latency(int64_t now);
+    float Measured_Speed(int64_t now, float command) const;
+
+    std::shared_ptr<Uart> _uart;
+    common::Mailbox<Vision_Target> _mailbox;    //视觉结果信箱
+    Motion _motion;                             //控制线程独占，保存PD状态
+
+    Vision_Target _target_last;     //最近一帧视觉结果
+    Vision_Target _target_prev;     //上一帧视觉结果
+    uint32_t _version = 0;          //已读取的信箱版本
+
+    common::Histogram _latency;     //采集到执行延迟分布（纳秒）
+    std::atomic<int64_t> _tx_delay_ns {0};  //串口写出耗时估计（指数平均）
+    int64_t _issue_ns = 0;          //最近一次下发指令的时间
+    int64_t _issue_capture_ns = 0;  //最近一次下发指令对应的采集时间
+    int64_t _tx_seen_ns = 0;        //已统计的最近写出时间
+
+    std::atomic<bool> _running {false};
+    std::atomic<uint16_t> _servo_pwm {PWMSERVOMID};
+    std::atomic<float> _speed {0};
+    std::thread _thread;
+    common::Parameter _parameter;
+};
+
+}
@@ -3,6 +3,7 @@
 #include "common.hpp"
 #include "recognition.hpp"
 #include "control/controlcenter.hpp"
+#include "control/speedplanner.hpp"
 
 namespace control{
 
@@ -20,8 +21,12 @@ public:
     ~Motion();
 
     void Pose_Control(int control_center,recognition::Tracking& tracking);
+    void Pose_Control(float error,int width);
 
-    void Speed_Control(bool enable,bool slow_down,ControlCenter& control_center,recognition::Tracking& tracking);
+    void Speed_Control(bool enable,bool slow_down,ControlCenter& control_center,float speed_cap);
+
+    // 场景限速
+    float Speed_Cap(const std::string& scene) const;
 
     float _speed_low; //最低速
     float _speed_high; //最高速
@@ -38,8 +43,10 @@ public:
     float _turn_p; //一阶比例系数：转向控制量
     float _turn_d; //一阶微分系数：转向控制量
 
+    SpeedPlanner _planner;  //基于曲率的速度规划
+
 private:
-    int _count_shift = 0;   //变速计数器,实现赛道平滑过渡
+    float _error_last = 0;  //上次偏差（PD控制微分项）
 
 
     // ========================================================== 参数 ==========================================================
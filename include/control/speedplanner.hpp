@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common.hpp"
+#include "control/controlcenter.hpp"
+
+namespace control{
+
+// 速度规划沿中心线的采样点数（固定，保证每帧耗时恒定）
+#define SPEED_PLAN_SAMPLES 16
+
+/**
+ * @brief 基于曲率的速度规划
+ *
+ * 沿拟合中心线在观测范围（参与拟合的最近行至最远行）内等距取固定数量的采样点，按横向加速度上限
+ * 求各点限速 v = sqrt(a_lat / |κ|)；可见范围末端视为未知路况，限速为最低速。
+ * 再由远及近按制动加速度反向递推 v_i ≤ sqrt(v_{i+1}^2 + 2·a_brake·Δs)，
+ * 保证车辆能在进入弯道前减速到位，首个采样点的速度即为当前目标速度。
+ */
+class SpeedPlanner
+{
+public:
+    SpeedPlanner();
+
+    // 规划目标速度，结果限制在[speed_min, speed_max]
+    float Plan(const ControlCenter& control_center, float speed_min, float speed_max);
+
+    float _lateral_acc_max = 4.0;   //横向加速度上限（m/s^2）
+    float _brake_acc_max = 3.0;     //制动加速度上限（m/s^2）
+    float _pixels_per_meter = 100;  //前瞻区域每米对应的图像行数
+
+    float _curvature_max = 0;       //可见范围内最大曲率（1/m，显示用）
+    float _profile[SPEED_PLAN_SAMPLES];  //速度曲线（由近及远）
+
+private:
+    common::Parameter _parameter;
+};
+
+}
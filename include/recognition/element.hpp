@@ -60,6 +60,10 @@ private:
     bool Apply_Supplement_Line(int current_y, const std::vector<common::POINT>& supplement_line, int& supplement_index);
 
     Scene scene;    // 场景
+    // 跨帧的环岛识别状态（每个Element对象独立，多条流水线可并行）
+    uint8_t _ring_left_cnt[2] = {0,0};  // 环岛左计数
+    uint8_t _ring_right_cnt[2] = {0,0}; // 环岛右计数
+    uint8_t _ring_frame_cnt = 0;        // 环岛帧计数
     std::vector<common::POINT> _crossroad_left_line;   // 十字左补线
     std::vector<common::POINT> _crossroad_right_line;  // 十字右补线
     std::vector<common::POINT> _obstacle_left_line;   // 障碍物左补线
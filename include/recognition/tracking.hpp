@@ -23,7 +23,7 @@ public:
     Tracking();
     ~Tracking();
 
-    void Picture_Process();
+    bool Picture_Process();     // 采集并预处理一帧，采集失败（如视频结束）返回false
     bool Find_Start_Point(int scan_start_y = 3, int scan_height = 10);
     void Track_Recognition();
     void Edge_Extract();
@@ -75,6 +75,13 @@ private:
     common::POINT _corner_left_down {0,0};  //左下角点
     common::POINT _corner_right_up {0,0};  //右上角点
     common::POINT _corner_right_down {0,0};  //右下角点
+
+    double _corner_left_up_slope1_min = 0;  //左上角点斜率1最小值
+    double _corner_left_up_slope1_max = 0;  //左上角点斜率1最大值
+    double _corner_left_up_slope2 = 0;      //左上角点斜率2
+    double _corner_right_up_slope1_min = 0; //右上角点斜率1最小值
+    double _corner_right_up_slope1_max = 0; //右上角点斜率1最大值
+    double _corner_right_up_slope2 = 0;     //右上角点斜率2
 };
     
 }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.hpp"
+#include "recognition.hpp"
+#include "control.hpp"
+#include <string>
+
+namespace task{
+
+/**
+ * @brief 单帧视觉处理流水线：采集 → 巡线 → 元素识别 → 中线拟合 → 速度规划
+ *
+ * 主程序与离线回放（ns_replay）共用同一套处理流程。不含绘制、显示、串口和控制线程，
+ * 控制指令由调用方把Target()发布给ControlLoop得到。
+ */
+class Pipeline
+{
+public:
+    recognition::Tracking _tracker;         //巡线（含摄像头）
+    recognition::Element _element;          //元素识别
+    control::ControlCenter _control_center; //控制中心
+    control::Motion _motion;                //速度规划
+
+    std::string _scene = "ZebraScene";      //当前场景
+    recognition::Scene _detected = recognition::Scene::NolmalScene;  //本帧元素识别结果
+    float _middle_error = 0;                //中线误差
+    uint32_t _frame_id = 0;                 //已处理帧数
+
+    /**
+     * @brief 处理一帧：采集、巡线、元素识别、补线及中心线拟合
+     * @return 是否处理成功，采集失败（视频或图片目录读完）时返回false
+     */
+    bool Process();
+
+    /**
+     * @brief 按当前场景限速和拟合中心线曲率规划速度
+     */
+    void Speed_Control();
+
+    /**
+     * @brief 本帧视觉结果，采集及发布时间为当前时钟
+     */
+    control::Vision_Target Target() const;
+
+private:
+    void Update_Scene(recognition::Scene detected);
+};
+
+}
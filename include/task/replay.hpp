@@ -0,0 +1,197 @@
+#pragma once
+
+#include "common/framecache.hpp"
+#include "common/recording.hpp"
+#include "task/pipeline.hpp"
+#include <nlohmann/json.hpp>
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace task{
+
+#define REPLAY_MAGIC "NSRP1\0\0"        //回放结果文件头（8字节，含结尾0）
+#define REPLAY_SCENE_LENGTH 16
+
+// 帧标志位
+#define REPLAY_FIT_VALID 0x01           //中心线拟合有效
+#define REPLAY_START_FOUND 0x02         //找到赛道起点
+
+/**
+ * @brief 回放结果文件头
+ */
+struct Replay_Header
+{
+    char magic[8];
+    uint32_t frame_size;        //Replay_Frame大小
+    uint16_t width;             //处理图像尺寸
+    uint16_t height;
+};
+
+/**
+ * @brief 边线点
+ */
+struct Replay_Point
+{
+    int16_t x;
+    int16_t y;
+};
+
+/**
+ * @brief 单帧处理结果（定长部分，其后紧跟left_count个左边线点和right_count个右边线点）
+ */
+struct Replay_Frame
+{
+    uint32_t frame_id;                  //帧序号（从1开始）
+    uint32_t process_ns;                //本帧处理耗时，比较时忽略
+    uint16_t servo_pwm;                 //舵机PWM
+    uint8_t flags;                      //REPLAY_*标志
+    uint8_t detected;                   //本帧元素识别结果（recognition::Scene）
+    char scene[REPLAY_SCENE_LENGTH];    //当前场景
+    int16_t start_left_x;               //赛道起点
+    int16_t start_right_x;
+    int16_t start_y;
+    int16_t control_center;             //控制中心x坐标
+    int16_t corners[4][2];              //左下、右下、左上、右上角点
+    uint16_t valid_row;                 //有效行数
+    uint16_t left_count;                //左边线点数
+    uint16_t right_count;               //右边线点数
+    uint16_t reserved;
+    float middle_error;                 //中线误差
+    float speed;                        //规划速度
+    float sigma;                        //中心线拟合残差
+};
+static_assert(sizeof(Replay_Frame) == 72, "Replay_Frame布局变化时需同步修改结果文件版本");
+
+/**
+ * @brief 读出的一帧结果
+ */
+struct Replay_Entry
+{
+    Replay_Frame frame;
+    std::vector<Replay_Point> left;     //左边线
+    std::vector<Replay_Point> right;    //右边线
+};
+
+/**
+ * @brief 两次回放结果的差异
+ */
+struct Replay_Diff
+{
+    size_t frames = 0;              //比较的帧数
+    size_t frame_count_delta = 0;   //帧数之差
+    size_t scene_mismatch = 0;      //场景或元素识别不同的帧数
+    size_t edge_mismatch = 0;       //边线点超出容差的帧数
+    size_t control_mismatch = 0;    //控制中心或PWM超出容差的帧数
+    int max_center_delta = 0;       //控制中心最大偏差（像素）
+    int max_pwm_delta = 0;          //PWM最大偏差
+    int max_edge_delta = 0;         //边线点x最大偏差（像素）
+    uint32_t first_mismatch = 0;    //第一个不一致的帧，0表示一致
+
+    bool Same() const { return frame_count_delta == 0 && first_mismatch == 0; }
+};
+
+/**
+ * @brief 回放结果写出
+ *
+ * 文件为Replay_Header后接逐帧记录，每帧一次fwrite，带1MB缓冲，不影响回放速度。
+ */
+class Replay_Writer
+{
+public:
+    ~Replay_Writer() { Close(); }
+
+    bool Open(const std::string& path, int width, int height);
+
+    /**
+     * @brief 写出流水线当前帧的结果
+     * @param servo_pwm 控制周期计算的舵机PWM
+     * @param process_ns 本帧处理耗时
+     */
+    void Write(const Pipeline& pipeline, uint16_t servo_pwm, uint32_t process_ns);
+
+    void Close();
+    bool Is_Open() const { return _file != nullptr; }
+
+private:
+    FILE* _file = nullptr;
+    std::vector<char> _buffer;
+    std::vector<Replay_Point> _points;  //本帧边线点（复用）
+};
+
+/**
+ * @brief 一次回放任务：一个输入及一组参数
+ */
+struct Replay_Job
+{
+    std::string source;             //视频文件、录制文件(.nsrec)或图片目录
+    std::string output;             //结果文件，为空不写出
+    std::string baseline;           //基准结果文件，为空不比较
+    nlohmann::json params = nlohmann::json::object();   //本任务覆盖的参数
+    std::shared_ptr<const std::vector<cv::Mat>> frames; //预先解码的帧，非空时不再读取source
+    std::shared_ptr<const common::FrameCache> cache;    //预处理帧缓存，非空时优先使用，尺寸或阈值与参数不符时不使用
+    double fps = 0;                 //生成控制周期时间的帧率，0为取视频帧率（录制文件取采集时间），仍取不到时为30
+    uint32_t max_frames = 0;        //最多回放帧数，0为全部
+    int tolerance = 0;              //与基准比较的容差
+    bool snapshot = true;           //录制文件输入时先应用其中的参数快照（params仍优先）
+    std::function<void(const Pipeline&, uint16_t servo_pwm)> on_frame;   //每帧处理完成后调用（评分等），可为空
+};
+
+/**
+ * @brief 回放任务的结果及汇总指标
+ */
+struct Replay_Result
+{
+    bool ok = false;                //输入可用且至少处理了一帧
+    std::string error;              //失败原因
+    uint32_t frames = 0;            //处理帧数
+    double elapsed = 0;             //用时（秒）
+    double fps = 0;                 //生成控制周期时间所用的帧率
+    uint64_t frame_p50_ns = 0;      //单帧处理耗时P50
+    uint64_t frame_p99_ns = 0;      //单帧处理耗时P99
+    uint32_t fit_valid = 0;         //中心线拟合有效的帧数
+    double abs_error_sum = 0;       //|中线误差|累计
+    double servo_delta_sum = 0;     //相邻帧舵机PWM变化量累计（转向平顺性）
+    bool compared = false;          //是否与基准比较
+    Replay_Diff diff;               //与基准的差异
+};
+
+/**
+ * @brief 在当前线程回放一个任务
+ * @details 参数覆盖只作用于当前线程，流水线对象只属于本任务，不依赖全局状态，
+ *          多个任务可在不同线程同时执行；分阶段耗时记录到当前线程绑定的Profiler。
+ *          录制文件输入时帧时间取录制的采集时间，与实车运行时控制周期看到的时序一致。
+ * @return 是否成功（同result.ok）
+ */
+bool Run_Replay(const Replay_Job& job, Replay_Result& result);
+
+/**
+ * @brief 预先解码视频、录制文件或图片目录，并缩放到处理尺寸
+ * @param budget 最多占用的内存（字节），超出时放弃并返回false
+ * @param fps 视频帧率，图片目录及录制文件为0（录制文件回放时取采集时间）
+ * @return 是否成功
+ */
+bool Load_Frames(const std::string& source, int width, int height, size_t budget, std::vector<cv::Mat>& frames, double& fps);
+
+/**
+ * @brief 用threads个线程执行fn(0) ~ fn(count-1)，各线程按序号领取，当前线程也参与
+ */
+void Parallel_For(size_t count, int threads, const std::function<void(size_t)>& fn);
+
+/**
+ * @brief 读取回放结果文件
+ * @return 是否成功
+ */
+bool Load_Replay(const std::string& path, std::vector<Replay_Entry>& entries);
+
+/**
+ * @brief 逐帧比较两次回放结果，处理耗时不参与比较
+ * @param tolerance 控制中心、边线x坐标和PWM允许的偏差
+ */
+Replay_Diff Compare_Replay(const std::vector<Replay_Entry>& baseline, const std::vector<Replay_Entry>& current, int tolerance = 0);
+
+}
@@ -1,9 +1,14 @@
 #include "common/camera.hpp"
+#include "common/clock.hpp"
+#include "common/profiler.hpp"
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
+#include <cctype>
 #include <cstdlib>
 #include <string>
+#include <chrono>
+#include <thread>
 
 using namespace std;
 using namespace cv;
@@ -80,6 +85,16 @@ bool Camera::Init()
             _input_mode = InputMode::VIDEO;
             return Init_Video();
         }
+        else if(_debug_mode == "folder")
+        {
+            _input_mode = InputMode::FOLDER;
+            return Init_Folder();
+        }
+        else if(_debug_mode == "recording")
+        {
+            _input_mode = InputMode::RECORDING;
+            return Init_Recording();
+        }
         else
         {
             _input_mode = InputMode::CAMERA;
@@ -253,6 +268,106 @@ bool Camera::Init_Picture()
     return true;
 }
 
+bool Camera::Init_Folder()
+{
+    std::string folder_path = _parameter.Get_Parameter("Debug_Folder_Path").get<std::string>();
+    _folder_files = List_Images(folder_path);
+    if(_folder_files.empty())
+    {
+        std::cerr << "图片目录为空: " << folder_path << std::endl;
+        return false;
+    }
+    _folder_index = 0;
+    return true;
+}
+
+bool Camera::Init_Recording()
+{
+    std::string recording_path = _parameter.Get_Parameter("Debug_Recording_Path").get<std::string>();
+    _recording_realtime = _parameter.Get_Parameter("Recording_Realtime").get<bool>();
+    _recording = RecordingReader::Open(recording_path);
+    if(!_recording || _recording->Frames().empty())
+    {
+        std::cerr << "无法打开录制文件或其中没有图像: " << recording_path << std::endl;
+        _recording = nullptr;
+        return false;
+    }
+    if(_recording->Recovered())
+        std::cout << "录制文件未正常关闭，已重建索引: " << recording_path << std::endl;
+    _folder_index = 0;
+    return true;
+}
+
+std::vector<std::string> Camera::List_Images(const std::string& folder_path)
+{
+    std::vector<std::string> files, images;
+    cv::glob(folder_path, files, false);    // 结果按文件名排序
+    for(const std::string& file : files)
+    {
+        std::string ext = file.substr(file.find_last_of('.') + 1);
+        for(char& c : ext)
+            c = tolower(c);
+        if(ext == "png" || ext == "jpg" || ext == "jpeg" || ext == "bmp")
+            images.push_back(file);
+    }
+    return images;
+}
+
+void Camera::Use_Frames(std::shared_ptr<const std::vector<cv::Mat>> frames)
+{
+    if(_cap.isOpened())
+        _cap.release();
+    _frames = std::move(frames);
+    _folder_index = 0;
+    _input_mode = InputMode::FRAMES;
+    _initialized = _frames != nullptr;
+}
+
+bool Camera::Use_Cache(std::shared_ptr<const FrameCache> cache)
+{
+    if(!cache || cache->Width() != _cached_size.width || cache->Height() != _cached_size.height ||
+       (cache->Format() == Frame_Format::BINARY && cache->Threshold() != Get_Threshold_Value()))
+        return false;
+    if(_cap.isOpened())
+        _cap.release();
+    _cache = std::move(cache);
+    _frame.release();
+    _folder_index = 0;
+    _input_mode = InputMode::CACHE;
+    _initialized = true;
+    return true;
+}
+
+bool Camera::Decode_Recorded(const RecordingReader& recording, size_t k, cv::Mat& frame)
+{
+    if(k >= recording.Frames().size())
+        return false;
+    const Recording_Frame& info = recording.Frame_Info(k);
+    size_t size;
+    uint8_t* data = const_cast<uint8_t*>(recording.Frame_Data(k, size));
+    if(info.codec == RECORDING_CODEC_MJPG)
+    {
+        frame = cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, data), cv::IMREAD_COLOR);  // 与V4L2后端解码MJPEG相同
+        return !frame.empty();
+    }
+    if(info.codec == RECORDING_CODEC_BGR && size == (size_t)info.width * info.height * 3)
+    {
+        cv::Mat(info.height, info.width, CV_8UC3, data).copyTo(frame);
+        return true;
+    }
+    return false;
+}
+
+void Camera::Attach_Recording(std::shared_ptr<RecordingWriter> writer)
+{
+    _record = std::move(writer);
+    _record_frame_id = 0;
+    _raw_mjpeg = false;
+    int fourcc = static_cast<int>(_cap.get(cv::CAP_PROP_FOURCC));
+    if(_record && _input_mode == InputMode::CAMERA && _cap.isOpened() && fourcc == cv::VideoWriter::fourcc('M', 'J', 'P', 'G'))
+        _raw_mjpeg = _cap.set(cv::CAP_PROP_CONVERT_RGB, 0);     // 不由后端解码，取得原始MJPEG数据
+}
+
 void Camera::Load_Config()
 {
     if(!_config_loaded)
@@ -289,6 +404,19 @@ int Camera::Get_Threshold_Value() const
  * @return 是否捕获成功
  */
 bool Camera::Capture()
+{
+    NS_PROFILE(Capture);
+    if (!Capture_Frame())
+        return false;
+    if (_record)
+        Record_Frame();
+    return true;
+}
+
+/**
+ * @brief 按输入模式取得一帧图像及采集时间
+ */
+bool Camera::Capture_Frame()
 {
     if (!_initialized) {
         std::cerr << "Camera not initialized" << std::endl;
@@ -297,14 +425,87 @@ bool Camera::Capture()
     
     if (_input_mode == InputMode::PICTURE) {
         // 图片模式不需要捕获
+        _capture_ns = Now_Ns();
+        return true;
+    }
+
+    if (_input_mode == InputMode::FOLDER) {
+        // 跳过无法读取的文件，全部读完返回false
+        while (_folder_index < _folder_files.size()) {
+            _frame = imread(_folder_files[_folder_index++]);
+            if (!_frame.empty()) {
+                _capture_ns = Now_Ns();
+                return true;
+            }
+            std::cerr << "Failed to load picture: " << _folder_files[_folder_index - 1] << std::endl;
+        }
+        return false;
+    }
+
+    if (_input_mode == InputMode::FRAMES) {
+        if (_folder_index >= _frames->size())
+            return false;
+        (*_frames)[_folder_index++].copyTo(_frame);    // 复制，后续缩放不改动共享帧
+        _capture_ns = Now_Ns();
+        return true;
+    }
+
+    if (_input_mode == InputMode::CACHE) {
+        if (_folder_index >= _cache->Frame_Count())
+            return false;
+        if (_cache->Format() == Frame_Format::GRAY)
+            _gray_frame = _cache->Gray(_folder_index++);   // 只读映射，不拷贝
+        else
+            _cache->Unpack(_folder_index++, _binary_frame);
+        _capture_ns = Now_Ns();
         return true;
     }
     
+    if (_input_mode == InputMode::RECORDING) {
+        // 跳过无法解码的帧，全部读完返回false
+        // 采集时间换算到当前时钟（录制时间 + 偏移），与延迟统计及串口回放一致；录制时间另存供离线回放使用
+        const std::vector<Recording_Index>& frames = _recording->Frames();
+        while (_folder_index < frames.size()) {
+            const Recording_Index& entry = frames[_folder_index];
+            if (_recording_realtime) {
+                int64_t wait = entry.stamp_ns + _recording->Replay_Offset() - Now_Ns();
+                if (wait > 0)
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(wait));   // 按录制时的帧间隔到达
+            }
+            if (Decode_Recorded(*_recording, _folder_index++, _frame)) {
+                if (!_recording_realtime)
+                    _recording->Set_Replay_Offset(Now_Ns() - entry.stamp_ns);   // 不等待时回放时钟随帧推进
+                _capture_ns = entry.stamp_ns + _recording->Replay_Offset();
+                _recorded_ns = entry.stamp_ns;
+                return true;
+            }
+            std::cerr << "Failed to decode recorded frame " << _folder_index << std::endl;
+        }
+        return false;
+    }
+    
     if (!_cap.isOpened()) {
         std::cerr << "Video capture not available" << std::endl;
         return false;
     }
-    _cap >> _frame;
+    // 先抓取再解码，时间戳取抓取完成时刻，不计入解码耗时
+    if (!_cap.grab()) {
+        std::cerr << "Failed to capture frame" << std::endl;
+        return false;
+    }
+    _capture_ns = Now_Ns();
+    if (_raw_mjpeg) {
+        // 原始MJPEG数据（1行字节），原样录制后解码；后端仍输出解码图像时直接使用
+        _cap.retrieve(_packet);
+        if (_packet.rows == 1 && _packet.type() == CV_8UC1)
+            _frame = cv::imdecode(_packet, cv::IMREAD_COLOR);
+        else {
+            _frame = _packet;
+            _packet.release();
+        }
+    }
+    else
+        _cap.retrieve(_frame);
     if (_frame.empty()) {
         std::cerr << "Failed to capture frame" << std::endl;
         return false;
@@ -312,8 +513,34 @@ bool Camera::Capture()
     return true;
 }
 
+/**
+ * @brief 当前帧写入录制文件：有原始MJPEG数据时原样写入，否则写入BGR图像
+ */
+void Camera::Record_Frame()
+{
+    if (_frame.empty())
+        return;     // 预处理缓存没有原始帧
+    _record_frame_id++;
+    if (!_packet.empty()) {
+        _record->Write_Frame(_capture_ns, _record_frame_id, RECORDING_CODEC_MJPG, _frame.cols, _frame.rows,
+                             _packet.data, _packet.total());
+        _packet.release();
+        return;
+    }
+    cv::Mat bgr = _frame.isContinuous() ? _frame : _frame.clone();
+    _record->Write_Frame(_capture_ns, _record_frame_id, RECORDING_CODEC_BGR, bgr.cols, bgr.rows,
+                         bgr.data, bgr.total() * bgr.elemSize());
+}
+
 bool Camera::Frame_Process()
 {
+    // 预处理缓存：灰度帧只需二值化，二值帧已可直接使用
+    if (_input_mode == InputMode::CACHE) {
+        if (_cache->Format() == Frame_Format::GRAY)
+            cv::threshold(_gray_frame, _binary_frame, Get_Threshold_Value(), 255, cv::THRESH_BINARY);
+        return !_binary_frame.empty();
+    }
+
     // 检查原始图像是否为空
     if (_frame.empty()) {
         std::cerr << "错误：原始图像为空，无法进行处理" << std::endl;
@@ -402,6 +629,15 @@ bool Camera::Is_Initialized() const
 
 void Camera::Print_Camera_Info() const
 {
+    if(_initialized && _input_mode == InputMode::FOLDER) {
+        std::cout << "图片目录: " << _folder_files.size() << " 张" << std::endl;
+        return;
+    }
+    if(_initialized && _input_mode == InputMode::RECORDING) {
+        std::cout << "录制文件: " << _recording->Frames().size() << " 帧，串口接收 " << _recording->Uart_Rx().size()
+                  << " 条，发送 " << _recording->Uart_Tx().size() << " 次" << std::endl;
+        return;
+    }
     if(!_initialized || !_cap.isOpened()) {
         std::cout << "摄像头未初始化" << std::endl;
         return;
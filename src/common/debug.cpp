@@ -1,4 +1,5 @@
 #include "common/debug.hpp"
+#include "common/log.hpp"
 
 namespace common {
 
@@ -15,6 +16,7 @@ Debug::Debug(const std::string& config_file_path) {
     
     // 加载配置文件
     print_enabled = load_print_mode(config_file_path);
+    set_print_mode(print_enabled);
     
     // 创建性能日志文件
     auto now = std::chrono::system_clock::now();
@@ -83,11 +85,13 @@ bool Debug::load_print_mode(const std::string& config_file_path) {
 }
 
 void Debug::reload_config(const std::string& config_file_path) {
-    print_enabled = load_print_mode(config_file_path);
+    set_print_mode(load_print_mode(config_file_path));
 }
 
 void Debug::set_print_mode(bool enabled) {
     print_enabled = enabled;
+    // 日志宏运行期级别同步：启用打印时输出DEBUG级，否则只输出INFO及以上
+    Logger::Instance().Set_Level(enabled ? NS_LOG_LEVEL_DEBUG : NS_LOG_LEVEL_INFO);
 }
 
 bool Debug::is_print_enabled() const {
@@ -241,6 +245,12 @@ void Debug::log_final_report() {
     std::cout << "性能日志已保存到: " << log_filename << std::endl;
 }
 
+void Debug::log_text(const std::string& text) {
+    if (!log_file.is_open()) return;
+    log_file << text << std::endl;
+    log_file.flush();
+}
+
 std::string Debug::get_log_filename() const {
     return log_filename;
 }
@@ -1,4 +1,5 @@
 #include "common/display.hpp"
+#include "common/parameter.hpp"
 #include <unistd.h>
 #include <opencv2/highgui.hpp>
 
@@ -13,6 +14,18 @@ const uint16_t ROWSIMAGE = 240;
 const uint16_t COLSIMAGEIPM = 320;
 const uint16_t ROWSIMAGEIPM = 240;    
 
+#define FRESH_BIT 4     //中间缓冲有新帧标志
+
+#ifndef NS_HEADLESS
+bool Is_Headless()
+{
+    // 发布到共享内存时由外部查看器显示，本进程同样不调用HighGUI
+    static const bool headless = Parameter().Get_Parameter("Headless").get<bool>() ||
+                                 Parameter().Get_Parameter("Shm_Publish").get<bool>();
+    return headless;
+}
+#endif
+
 
 /**
  * @brief 创建一个空窗口
@@ -28,54 +41,99 @@ Mat empty_window(Size2i wnd_size,const string& text)
     return img;
 }
 
-void display_loop(Display::Frame_Queue *fq,Display::WndMap *wm,bool *flag)
+/**
+ * @brief 显示线程：等待新帧通知，取出各窗口最新一帧显示
+ */
+void Display::display_loop()
 {
-    while(!*flag)
-    {
-        usleep(1e6);
-    }
-    while(*flag)
+    auto period = chrono::milliseconds(1000 / TARGET_FPS);
+    auto next = chrono::steady_clock::now();
+    while(thread_flag)
     {
-        while(! fq->empty())
         {
-            auto item = fq->front();
-            fq->pop();
-            auto wm_iter = wm->find(item.first);
-            if(wm_iter == wm->end())
-            {
-                printf("错误的窗口序号%d\n",item.first);
+            unique_lock<mutex> lock(wake_mutex);
+            wake_cv.wait(lock, [this]{ return wake_pending || !thread_flag; });
+            wake_pending = false;
+        }
+        for(auto& wnd : windows)
+        {
+            if(!wnd.active.load(memory_order_acquire))
                 continue;
-            }
-            imshow(wm_iter->second,item.second);
+            if(!(wnd.middle.load(memory_order_acquire) & FRESH_BIT))
+                continue;
+            // 取走中间缓冲，旧的前缓冲作为新的中间缓冲
+            uint8_t old = wnd.middle.exchange(wnd.front, memory_order_acq_rel);
+            wnd.front = old & 3;
+            imshow(wnd.name, wnd.buffers[wnd.front]);
+            wnd.shown.fetch_add(1, memory_order_relaxed);
         }
+        // 限制刷新频率，期间到达的帧只保留最新一帧
+        next += period;
+        auto now = chrono::steady_clock::now();
+        if(next < now)
+            next = now;
+        this_thread::sleep_until(next);
     }
-    auto key = (1000/TARGET_FPS);
+}
+
+/**
+ * @brief 唤醒显示线程
+ */
+void Display::notify()
+{
+    {
+        lock_guard<mutex> lock(wake_mutex);
+        wake_pending = true;
+    }
+    wake_cv.notify_one();
 }
 
 
 Display::Display()
-    :loop{display_loop,&frame_queue,&wnd_map,&thread_flag}
+    :loop{&Display::display_loop,this}
 {
-    thread_flag = true;
 }
 
 Display::~Display()
 {
     thread_flag = false;
+    notify();
     loop.join();
+    for(auto& wnd : windows)
+    {
+        if(wnd.active && wnd.dropped > 0)
+            printf("窗口[%s] 显示%lu帧，丢弃%lu帧\n", wnd.name.c_str(),
+                (unsigned long)wnd.shown.load(), (unsigned long)wnd.dropped.load());
+    }
 }
 
 void Display::add_window(uint8_t series,const string& wnd_name)
 {
-    wnd_map[series] = wnd_name;
-    auto mat = empty_window(wnd_size,wnd_name);
-    frame_queue.push({series,mat});
+    if(Is_Headless())
+        return;
+    if(series >= DISPLAY_MAX_WINDOWS)
+    {
+        printf("错误的窗口序号%d\n",series);
+        return;
+    }
+    Window& wnd = windows[series];
+    if(wnd.active)
+        return;
+    wnd.name = wnd_name;
+    wnd.active.store(true, memory_order_release);
+    show_image(series, empty_window(wnd_size,wnd_name));
 }
 
+/**
+ * @brief 等待所有窗口的新帧被显示
+ */
 void Display::sync()
 {
-    while(!frame_queue.empty())
-        usleep(1);
+    for(auto& wnd : windows)
+    {
+        while(wnd.active && (wnd.middle.load(memory_order_acquire) & FRESH_BIT))
+            usleep(100);
+    }
 }
 
 void Display::putText(cv::Mat& img,const std::string& text,
@@ -84,9 +142,37 @@ void Display::putText(cv::Mat& img,const std::string& text,
     cv::putText(img,text,org,cv::FONT_HERSHEY_SIMPLEX,fontHeight,color);
 }
 
-void Display::show_image(uint8_t series,cv::Mat frame)
+/**
+ * @brief 提交显示图像（仅处理线程调用，不阻塞）
+ * @param series 窗口序号
+ * @param frame 图像，拷贝到窗口后缓冲，调用方可立即复用
+ */
+void Display::show_image(uint8_t series,const cv::Mat& frame)
+{
+    if(Is_Headless())
+        return;
+    if(series >= DISPLAY_MAX_WINDOWS || !windows[series].active)
+    {
+        printf("错误的窗口序号%d\n",series);
+        return;
+    }
+    Window& wnd = windows[series];
+    frame.copyTo(wnd.buffers[wnd.back]);    // 缓冲尺寸不变时不重新分配
+    uint8_t old = wnd.middle.exchange(wnd.back | FRESH_BIT, memory_order_acq_rel);
+    if(old & FRESH_BIT)
+        wnd.dropped.fetch_add(1, memory_order_relaxed);
+    wnd.back = old & 3;
+    notify();
+}
+
+uint64_t Display::shown_frames(uint8_t series) const
 {
-    frame_queue.push({series,frame});
+    return series < DISPLAY_MAX_WINDOWS ? windows[series].shown.load(memory_order_relaxed) : 0;
 }
 
-}
\ No newline at end of file
+uint64_t Display::dropped_frames(uint8_t series) const
+{
+    return series < DISPLAY_MAX_WINDOWS ? windows[series].dropped.load(memory_order_relaxed) : 0;
+}
+
+}
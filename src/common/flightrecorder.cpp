@@ -0,0 +1,136 @@
+#include "common/flightrecorder.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace common{
+
+static FlightRecorder* signal_recorder = nullptr;    //信号处理中保存的记录仪
+
+/**
+ * @brief 写满len字节（信号安全）
+ */
+static bool Write_All(int fd, const void* data, size_t len)
+{
+    const char* p = (const char*)data;
+    while(len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief 信号处理：保存记录后以默认方式重新触发信号
+ */
+static void Flight_Signal_Handler(int sig)
+{
+    if(signal_recorder)
+    {
+        static const char message[] = "\n收到信号，保存飞行记录\n";
+        Write_All(STDERR_FILENO, message, sizeof(message) - 1);
+        signal_recorder->Dump();
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+FlightRecorder::FlightRecorder(size_t capacity)
+    : _records(capacity > 0 ? capacity : 1)
+{
+    time_t now = time(nullptr);
+    tm local;
+    localtime_r(&now, &local);
+    strftime(_path, sizeof(_path), "flight_%Y%m%d_%H%M%S.nsfr", &local);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    if(signal_recorder == this)
+        signal_recorder = nullptr;
+}
+
+bool FlightRecorder::Dump(const char* path) const
+{
+    int fd = open(path ? path : _path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+
+    // 正在填写的槽可能是最旧的一条，环形已满时跳过它
+    uint64_t count = _count.load(memory_order_acquire);
+    uint64_t size = _records.size();
+    uint64_t first = count >= size ? count - size + 1 : 0;
+
+    Flight_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FLIGHT_MAGIC, sizeof(header.magic));
+    header.record_size = sizeof(Flight_Record);
+    header.count = (uint32_t)(count - first);
+    header.dump_ns = Now_Ns();
+    header.stages = FLIGHT_STAGES;
+    bool ok = Write_All(fd, &header, sizeof(header));
+
+    // 按时间顺序写出，最多分两段
+    uint64_t begin = first % size;
+    uint64_t n = count - first;
+    uint64_t part = n < size - begin ? n : size - begin;
+    ok = ok && Write_All(fd, &_records[begin], part * sizeof(Flight_Record));
+    ok = ok && Write_All(fd, &_records[0], (n - part) * sizeof(Flight_Record));
+    close(fd);
+    return ok;
+}
+
+bool FlightRecorder::Snapshot(string& path)
+{
+    time_t now = time(nullptr);
+    tm local;
+    localtime_r(&now, &local);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local);
+    path = string("flight_") + stamp + "_" + to_string(++_snapshots) + ".nsfr";
+    return Dump(path.c_str());
+}
+
+void FlightRecorder::Install_Signal_Handlers()
+{
+    signal_recorder = this;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = Flight_Signal_Handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND;
+    for(int sig : {SIGINT, SIGTERM, SIGHUP, SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+        sigaction(sig, &action, nullptr);
+}
+
+bool FlightRecorder::Load(const string& path, vector<Flight_Record>& records)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+        return false;
+    Flight_Header header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, FLIGHT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.record_size == sizeof(Flight_Record) && header.stages == FLIGHT_STAGES;
+    if(ok)
+    {
+        records.resize(header.count);
+        ok = fread(records.data(), sizeof(Flight_Record), header.count, file) == header.count;
+    }
+    fclose(file);
+    return ok;
+}
+
+}
@@ -0,0 +1,285 @@
+#include "common/framecache.hpp"
+#include "common/camera.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace common{
+
+static_assert(sizeof(Frame_Cache_Header) == 72, "Frame_Cache_Header布局变化时需同步修改缓存文件版本");
+
+/**
+ * @brief 按align向上取整
+ */
+static inline uint64_t Align_Up(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+/**
+ * @brief 每帧数据字节数（不含对齐）
+ */
+static inline size_t Frame_Bytes(int width, int height, Frame_Format format)
+{
+    return format == Frame_Format::GRAY ? (size_t)width * height : (size_t)(width + 7) / 8 * height;
+}
+
+/**
+ * @brief FNV-1a
+ */
+static inline uint64_t Hash(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * 1099511628211ull;
+    return hash;
+}
+
+FrameCache::~FrameCache()
+{
+    if(_base)
+        munmap(const_cast<uint8_t*>(_base), _size);
+}
+
+shared_ptr<const FrameCache> FrameCache::Open(const string& path, uint64_t key)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return nullptr;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Frame_Cache_Header))
+    {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return nullptr;
+
+    shared_ptr<FrameCache> cache(new FrameCache());
+    cache->_base = static_cast<const uint8_t*>(addr);
+    cache->_size = st.st_size;
+    cache->_header = reinterpret_cast<const Frame_Cache_Header*>(cache->_base);
+    const Frame_Cache_Header& h = *cache->_header;
+    bool ok = memcmp(h.magic, FRAME_CACHE_MAGIC, sizeof(h.magic)) == 0 &&
+              h.header_size == sizeof(Frame_Cache_Header) &&
+              h.format <= (uint8_t)Frame_Format::BINARY && h.width > 0 && h.height > 0 &&
+              h.frame_stride >= Frame_Bytes(h.width, h.height, cache->Format()) &&
+              h.data_offset % FRAME_CACHE_DATA_ALIGN == 0 &&
+              h.data_offset + (uint64_t)h.frame_count * h.frame_stride <= h.index_offset &&
+              h.index_offset + (uint64_t)h.frame_count * sizeof(Frame_Cache_Index) <= cache->_size &&
+              (key == 0 || h.key == key);
+    if(!ok)
+        return nullptr;
+    cache->_index = reinterpret_cast<const Frame_Cache_Index*>(cache->_base + h.index_offset);
+    madvise(addr, cache->_size, MADV_WILLNEED);
+    return cache;
+}
+
+bool FrameCache::Build(const string& source, const string& path, int width, int height, Frame_Format format, int threshold)
+{
+    struct stat st;
+    bool folder = stat(source.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    vector<string> files;
+    cv::VideoCapture cap;
+    shared_ptr<RecordingReader> recording;
+    if(folder)
+        files = Camera::List_Images(source);
+    else if(RecordingReader::Is_Recording(source))
+    {
+        if(!(recording = RecordingReader::Open(source)))
+            return false;
+    }
+    else if(!cap.open(source))
+        return false;
+
+    // 临时文件名含进程号和线程号，多个生成者互不干扰，改名是原子的
+    string temp = path + ".tmp." + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id()));
+    FILE* file = fopen(temp.c_str(), "wb");
+    if(!file)
+        return false;
+
+    Frame_Cache_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FRAME_CACHE_MAGIC, sizeof(header.magic));
+    header.header_size = sizeof(header);
+    header.format = (uint8_t)format;
+    header.width = width;
+    header.height = height;
+    header.threshold = format == Frame_Format::BINARY ? threshold : -1;
+    header.frame_stride = Align_Up(Frame_Bytes(width, height, format), FRAME_CACHE_FRAME_ALIGN);
+    header.key = Key(source, width, height, format, threshold);
+    header.data_offset = FRAME_CACHE_DATA_ALIGN;
+    header.fps = folder ? 0 : cap.get(cv::CAP_PROP_FPS);
+    if(recording && recording->Frames().size() > 1)
+    {
+        const vector<Recording_Index>& frames = recording->Frames();
+        header.fps = (frames.size() - 1) * 1e9 / (frames.back().stamp_ns - frames.front().stamp_ns);
+    }
+
+    vector<Frame_Cache_Index> index;
+    vector<uint8_t> data(header.frame_stride, 0);
+    const size_t row_bytes = (width + 7) / 8;
+    cv::Mat frame, resized, gray, binary;
+    bool ok = fseek(file, header.data_offset, SEEK_SET) == 0;
+    for(uint32_t source_index = 0; ok; source_index++)
+    {
+        // 与Camera采集及Tracking::Picture_Process相同的处理：缩放 → 灰度化 → 二值化
+        if(folder)
+        {
+            if(source_index >= files.size())
+                break;
+            frame = cv::imread(files[source_index]);
+            if(frame.empty())
+                continue;
+        }
+        else if(recording)
+        {
+            if(source_index >= recording->Frames().size())
+                break;
+            if(!Camera::Decode_Recorded(*recording, source_index, frame))
+                continue;
+        }
+        else if(!cap.read(frame))
+            break;
+        cv::resize(frame, resized, cv::Size(width, height));
+        cv::cvtColor(resized, gray, cv::COLOR_BGR2GRAY);
+        if(format == Frame_Format::GRAY)
+        {
+            for(int r = 0; r < height; r++)
+                memcpy(data.data() + (size_t)r * width, gray.ptr(r), width);
+        }
+        else
+        {
+            cv::threshold(gray, binary, threshold, 255, cv::THRESH_BINARY);
+            memset(data.data(), 0, data.size());
+            for(int r = 0; r < height; r++)
+            {
+                const uint8_t* src = binary.ptr(r);
+                uint8_t* dst = data.data() + r * row_bytes;
+                for(int c = 0; c < width; c++)
+                    if(src[c])
+                        dst[c >> 3] |= 0x80 >> (c & 7);
+            }
+        }
+        ok = fwrite(data.data(), data.size(), 1, file) == 1;
+        index.push_back({source_index, 0});
+    }
+
+    header.frame_count = index.size();
+    header.index_offset = header.data_offset + (uint64_t)header.frame_count * header.frame_stride;
+    ok = ok && !index.empty() &&
+         fwrite(index.data(), sizeof(Frame_Cache_Index), index.size(), file) == index.size() &&
+         fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    if(ok)
+        ok = rename(temp.c_str(), path.c_str()) == 0;
+    if(!ok)
+        remove(temp.c_str());
+    return ok;
+}
+
+shared_ptr<const FrameCache> FrameCache::Open_Or_Build(const string& source, const string& dir,
+                                                       int width, int height, Frame_Format format, int threshold)
+{
+    uint64_t key = Key(source, width, height, format, threshold);
+    if(key == 0)
+        return nullptr;
+    mkdir(dir.c_str(), 0755);
+    string path = Path(dir, source, key);
+    shared_ptr<const FrameCache> cache = Open(path, key);
+    if(cache)
+        return cache;
+    cout << "生成预处理缓存: " << source << " → " << path << endl;
+    if(!Build(source, path, width, height, format, threshold))
+    {
+        cerr << "预处理缓存生成失败: " << path << endl;
+        return nullptr;
+    }
+    return Open(path, key);
+}
+
+uint64_t FrameCache::Key(const string& source, int width, int height, Frame_Format format, int threshold)
+{
+    struct stat st;
+    if(stat(source.c_str(), &st) != 0)
+        return 0;
+    uint64_t hash = 14695981039346656037ull;
+    hash = Hash(hash, FRAME_CACHE_MAGIC, sizeof(FRAME_CACHE_MAGIC));
+    hash = Hash(hash, source.data(), source.size());
+    int32_t params[4] = {width, height, (int32_t)format, format == Frame_Format::BINARY ? threshold : -1};
+    hash = Hash(hash, params, sizeof(params));
+    // 输入文件大小及修改时间，图片目录逐个文件计入
+    vector<string> files = S_ISDIR(st.st_mode) ? Camera::List_Images(source) : vector<string>{source};
+    for(const string& file : files)
+    {
+        if(stat(file.c_str(), &st) != 0)
+            continue;
+        int64_t stamp[3] = {(int64_t)st.st_size, (int64_t)st.st_mtim.tv_sec, (int64_t)st.st_mtim.tv_nsec};
+        hash = Hash(hash, file.data(), file.size());
+        hash = Hash(hash, stamp, sizeof(stamp));
+    }
+    return hash ? hash : 1;
+}
+
+string FrameCache::Path(const string& dir, const string& source, uint64_t key)
+{
+    string name = source;
+    while(name.size() > 1 && name.back() == '/')
+        name.pop_back();
+    name = name.substr(name.find_last_of('/') + 1);
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), "_%016llx.nsfc", (unsigned long long)key);
+    return dir + "/" + name + suffix;
+}
+
+cv::Mat FrameCache::Gray(size_t k) const
+{
+    return cv::Mat(Height(), Width(), CV_8UC1, const_cast<uint8_t*>(Frame_Data(k)));
+}
+
+void FrameCache::Unpack(size_t k, cv::Mat& binary) const
+{
+    // 每字节对应8个像素，查表展开
+    static const auto table = []()
+    {
+        vector<uint64_t> t(256);
+        for(int b = 0; b < 256; b++)
+        {
+            uint8_t bytes[8];
+            for(int i = 0; i < 8; i++)
+                bytes[i] = (b & (0x80 >> i)) ? 255 : 0;
+            memcpy(&t[b], bytes, 8);
+        }
+        return t;
+    }();
+
+    const int width = Width(), height = Height();
+    const size_t row_bytes = (width + 7) / 8;
+    binary.create(height, width, CV_8UC1);
+    const uint8_t* src = Frame_Data(k);
+    uint8_t pixels[8];
+    for(int r = 0; r < height; r++, src += row_bytes)
+    {
+        uint8_t* dst = binary.ptr(r);
+        int c = 0;
+        for(; c + 8 <= width; c += 8)
+            memcpy(dst + c, &table[src[c >> 3]], 8);
+        if(c < width)
+        {
+            memcpy(pixels, &table[src[c >> 3]], 8);
+            memcpy(dst + c, pixels, width - c);
+        }
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+#include "common/log.hpp"
+#include "common/clock.hpp"
+#include <cstdarg>
+#include <cstdio>
+
+using namespace std;
+
+namespace common{
+
+static const char LEVEL_NAME[] = "TDIWE";
+
+Logger& Logger::Instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+{
+    _start_ns = Now_Ns();
+    _writer = thread(&Logger::writer_loop, this);
+}
+
+Logger::~Logger()
+{
+    _running.store(false, memory_order_release);
+    _wake_cv.notify_one();
+    if(_writer.joinable())
+        _writer.join();
+    if(_dropped.load(memory_order_relaxed) > 0)
+        fprintf(stderr, "日志队列满，丢弃 %llu 条\n", (unsigned long long)_dropped.load(memory_order_relaxed));
+}
+
+void Logger::Write(int level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bool ok = _queue.Emplace([&](Log_Record& record)
+    {
+        record.stamp_ns = Now_Ns();
+        record.level = level;
+        int n = vsnprintf(record.text, LOG_RECORD_TEXT, format, args);
+        record.length = n < 0 ? 0 : min(n, LOG_RECORD_TEXT - 1);
+    });
+    va_end(args);
+    if(ok)
+    {
+        // 积压超过半队列时提前唤醒写线程（条件变量通知不需要持锁）
+        uint64_t pushed = _pushed.fetch_add(1, memory_order_relaxed) + 1;
+        if(pushed - _written.load(memory_order_relaxed) == LOG_QUEUE_SIZE / 2)
+            _wake_cv.notify_one();
+    }
+    else
+        _dropped.fetch_add(1, memory_order_relaxed);
+}
+
+void Logger::Flush()
+{
+    uint64_t target = _pushed.load(memory_order_relaxed);
+    while(_written.load(memory_order_acquire) < target && _running.load(memory_order_relaxed))
+    {
+        _wake_cv.notify_one();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+/**
+ * @brief 写线程：批量取出日志写到标准输出，队空时等待
+ *
+ * 生产者平时不通知，写线程最多等待5ms再检查队列；积压到半队列时由生产者唤醒。
+ */
+void Logger::writer_loop()
+{
+    Log_Record record;
+    while(true)
+    {
+        bool running = _running.load(memory_order_acquire);
+        uint64_t count = 0;
+        while(_queue.Pop(record))
+        {
+            double t = (record.stamp_ns - _start_ns) / 1e9;
+            char level = record.level < sizeof(LEVEL_NAME) - 1 ? LEVEL_NAME[record.level] : '?';
+            fprintf(stdout, "[%10.6f] %c %.*s\n", t, level, (int)record.length, record.text);
+            count++;
+        }
+        if(count > 0)
+        {
+            fflush(stdout);
+            _written.fetch_add(count, memory_order_release);
+        }
+        if(!running)
+            break;      // 退出前已写完队列中的日志
+        unique_lock<mutex> lock(_wake_mutex);
+        _wake_cv.wait_for(lock, chrono::milliseconds(5));
+    }
+}
+
+}
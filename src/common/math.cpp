@@ -2,6 +2,7 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <map>
 #include <opencv2/opencv.hpp>
 
 namespace common{
@@ -69,98 +70,187 @@ inline int Combination(int n, int k)
     return result;
 }
 
+/**
+ * @brief 根据步长计算采样点数
+ * @param dt 步长
+ * @return 采样点数（含首尾，至少2个）
+ */
+static int Bezier_Samples(double dt)
+{
+    if (!(dt > 0.0) || !std::isfinite(dt) || dt >= 1.0) {
+        return 2;
+    }
+    return static_cast<int>(std::ceil(1.0 / dt - 1e-9)) + 1;
+}
+
+/**
+ * @brief 获取伯恩斯坦系数表
+ * @param degree 曲线次数
+ * @param samples 采样点数
+ * @return 系数表引用（在下一次调用前有效）
+ *
+ * 每个线程维护独立缓存，同一(次数,采样数)只计算一次，运行期不再调用pow。
+ */
+const Bernstein_Table& Get_Bernstein_Table(int degree, int samples)
+{
+    thread_local std::map<std::pair<int,int>, Bernstein_Table> cache;
+
+    auto key = std::make_pair(degree, samples);
+    auto iter = cache.find(key);
+    if (iter != cache.end()) {
+        return iter->second;
+    }
+    // 缓存上限，避免步长频繁变化时无限增长
+    if (cache.size() >= 256) {
+        cache.clear();
+    }
+
+    Bernstein_Table& table = cache[key];
+    table.degree = degree;
+    table.samples = samples;
+    table.weights.resize(static_cast<size_t>(samples) * (degree + 1));
+
+    for (int k = 0; k < samples; ++k) {
+        double t = static_cast<double>(k) / (samples - 1);
+        double* row = &table.weights[static_cast<size_t>(k) * (degree + 1)];
+        for (int i = 0; i <= degree; ++i) {
+            row[i] = Combination(degree, i) * pow(t, i) * pow(1.0 - t, degree - i);
+        }
+    }
+    return table;
+}
+
 /**
  * @brief 优化的贝塞尔曲线生成算法
  * @param dt 基础步长
  * @param points 控制点
- * @return 贝塞尔曲线点集
+ * @param count 控制点数量
+ * @param output 输出点集（由调用方提供，函数内清空后写入）
+ *
+ * 次数不超过3时，用系数表求出前n+1个点后以前向差分递推，每点只需n次加法；
+ * 更高次数直接按系数表加权求和，避免前向差分的误差累积。
  */
-std::vector<POINT> Bazier(double dt, std::vector<POINT> points)
+void Bazier(double dt, const POINT* points, size_t count, std::vector<POINT>& output)
 {
-    std::vector<POINT> output;
+    output.clear();
     
-    if (points.size() < 2) {
-        return output;  // 至少需要2个控制点
+    if (count < 2) {
+        return;  // 至少需要2个控制点
     }
 
-    int n = points.size() - 1;  // 曲线次数
-    
-    // 预计算组合数，避免重复计算
-    std::vector<int> combinations(n + 1);
-    for (int i = 0; i <= n; ++i) {
-        combinations[i] = Combination(n, i);
-    }
+    int n = static_cast<int>(count) - 1;  // 曲线次数
     
     // 自适应步长：根据控制点距离调整
     double total_length = 0;
-    for (size_t i = 1; i < points.size(); ++i) {
+    for (size_t i = 1; i < count; ++i) {
         total_length += Distance_Point_To_Point(points[i-1], points[i]);
     }
     
     // 根据总长度调整步长，确保生成足够多的点
-    double adaptive_dt = std::min(dt, 1.0 / (total_length * 0.1));
+    double adaptive_dt = dt;
+    if (total_length > 0) {
+        adaptive_dt = std::min(dt, 1.0 / (total_length * 0.1));
+    }
     adaptive_dt = std::max(adaptive_dt, 0.001);  // 最小步长限制
-    
-    double t = 0.0;
-    while (t <= 1.0) {
-        POINT p = {0, 0};
-        
-        // 使用预计算的组合数计算伯恩斯坦多项式
+
+    int samples = Bezier_Samples(adaptive_dt);
+    const Bernstein_Table& table = Get_Bernstein_Table(n, samples);
+    output.reserve(samples);
+
+    // 按系数表直接求第k个点
+    auto evaluate = [&](int k, double& x, double& y) {
+        const double* row = &table.weights[static_cast<size_t>(k) * (n + 1)];
+        x = 0.0;
+        y = 0.0;
         for (int i = 0; i <= n; ++i) {
-            double bernstein = combinations[i] * pow(t, i) * pow(1.0 - t, n - i);
-            p.x += static_cast<int>(points[i].x * bernstein);
-            p.y += static_cast<int>(points[i].y * bernstein);
+            x += points[i].x * row[i];
+            y += points[i].y * row[i];
         }
-        
-        output.push_back(p);
-        t += adaptive_dt;
+    };
+
+    if (n > 3 || samples <= n + 1) {
+        for (int k = 0; k < samples; ++k) {
+            double x, y;
+            evaluate(k, x, y);
+            output.emplace_back(static_cast<int>(std::lround(x)), static_cast<int>(std::lround(y)));
+        }
+        return;
     }
-    
-    // 确保包含终点
-    if (output.empty() || (output.back().x != points.back().x || output.back().y != points.back().y)) {
-        output.push_back(points.back());
+
+    // 前向差分：dx[j]为第j阶差分，由前n+1个点得到初值
+    double dx[4] = {0, 0, 0, 0};
+    double dy[4] = {0, 0, 0, 0};
+    for (int k = 0; k <= n; ++k) {
+        evaluate(k, dx[k], dy[k]);
     }
-    
-    return output;
+    for (int j = 1; j <= n; ++j) {
+        for (int k = n; k >= j; --k) {
+            dx[k] -= dx[k - 1];
+            dy[k] -= dy[k - 1];
+        }
+    }
+
+    for (int k = 0; k < samples; ++k) {
+        output.emplace_back(static_cast<int>(std::lround(dx[0])), static_cast<int>(std::lround(dy[0])));
+        for (int j = 0; j < n; ++j) {
+            dx[j] += dx[j + 1];
+            dy[j] += dy[j + 1];
+        }
+    }
+
+    // 消除递推误差，保证终点精确
+    output.back().x = points[n].x;
+    output.back().y = points[n].y;
 }
 
 /**
- * @brief 使用德卡斯特茹算法的贝塞尔曲线（更高效）
+ * @brief 使用德卡斯特茹算法的贝塞尔曲线
  * @param dt 步长
  * @param points 控制点
- * @return 贝塞尔曲线点集
+ * @param count 控制点数量
+ * @param output 输出点集（由调用方提供，函数内清空后写入）
+ *
+ * 控制点不超过BEZIER_MAX_POINTS时中间结果保存在栈上的固定数组中，超过时使用堆上缓冲。
  */
-std::vector<POINT> Bazier_DeCasteljau(double dt, std::vector<POINT> points)
+void Bazier_DeCasteljau(double dt, const POINT* points, size_t count, std::vector<POINT>& output)
 {
-    std::vector<POINT> output;
+    output.clear();
     
-    if (points.size() < 2) {
-        return output;
+    if (count < 2) {
+        return;
+    }
+
+    int samples = Bezier_Samples(dt);
+    output.reserve(samples);
+
+    double stack_x[BEZIER_MAX_POINTS];
+    double stack_y[BEZIER_MAX_POINTS];
+    std::vector<double> heap;
+    double* temp_x = stack_x;
+    double* temp_y = stack_y;
+    if (count > BEZIER_MAX_POINTS) {
+        heap.resize(count * 2);
+        temp_x = heap.data();
+        temp_y = heap.data() + count;
     }
     
-    double t = 0.0;
-    while (t <= 1.0) {
-        // 使用德卡斯特茹算法计算贝塞尔曲线上的点
-        std::vector<POINT> temp_points = points;
+    for (int k = 0; k < samples; ++k) {
+        double t = static_cast<double>(k) / (samples - 1);
+        for (size_t i = 0; i < count; ++i) {
+            temp_x[i] = points[i].x;
+            temp_y[i] = points[i].y;
+        }
         
         // 递推计算
-        for (int level = 1; level < static_cast<int>(points.size()); ++level) {
-            for (int i = 0; i < static_cast<int>(points.size()) - level; ++i) {
-                temp_points[i].x = static_cast<int>((1 - t) * temp_points[i].x + t * temp_points[i + 1].x);
-                temp_points[i].y = static_cast<int>((1 - t) * temp_points[i].y + t * temp_points[i + 1].y);
+        for (size_t level = 1; level < count; ++level) {
+            for (size_t i = 0; i < count - level; ++i) {
+                temp_x[i] = (1 - t) * temp_x[i] + t * temp_x[i + 1];
+                temp_y[i] = (1 - t) * temp_y[i] + t * temp_y[i + 1];
             }
         }
         
-        output.push_back(temp_points[0]);
-        t += dt;
+        output.emplace_back(static_cast<int>(std::lround(temp_x[0])), static_cast<int>(std::lround(temp_y[0])));
     }
-    
-    // 确保包含终点
-    if (output.empty() || (output.back().x != points.back().x || output.back().y != points.back().y)) {
-        output.push_back(points.back());
-    }
-    
-    return output;
 }
 
 /**
@@ -7,6 +7,9 @@ using json = nlohmann::json;
 
 namespace common{
 
+json Parameter::_overrides = json::object();
+thread_local json Parameter::_thread_overrides = json::object();
+
 Parameter::Parameter()
 {
     _config_path = "../../config/config.json";
@@ -67,8 +70,29 @@ void Parameter::Add_Parameter(const std::string& key, const nlohmann::json& valu
 
 nlohmann::json Parameter::Get_Parameter(const std::string& key)
 {
+    auto it = _thread_overrides.find(key);
+    if(it != _thread_overrides.end())
+        return *it;
+    it = _overrides.find(key);
+    if(it != _overrides.end())
+        return *it;
     return _config[key];
 }
 
+void Parameter::Override(const std::string& key, const nlohmann::json& value)
+{
+    _overrides[key] = value;
+}
+
+void Parameter::Override_Thread(const std::string& key, const nlohmann::json& value)
+{
+    _thread_overrides[key] = value;
+}
+
+void Parameter::Clear_Thread_Overrides()
+{
+    _thread_overrides = json::object();
+}
+
 
 }
\ No newline at end of file
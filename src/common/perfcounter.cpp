@@ -0,0 +1,120 @@
+#include "common/perfcounter.hpp"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+namespace common{
+
+atomic<bool> Perf_Counters::_enabled {false};
+
+static const char* COUNTER_NAME[PERF_COUNTERS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+static const uint64_t COUNTER_CONFIG[PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ * @brief 线程的计数器组
+ *
+ * 第一个成功打开的计数器作为组长，读组长即可一次读出全组；
+ * 不支持的计数器跳过，slot记录组内第k个值对应哪个计数器。
+ */
+struct Perf_Group
+{
+    int state = 0;      // 0未打开，1可用，-1不可用
+    int leader = -1;
+    int fds[PERF_COUNTERS];
+    int slot[PERF_COUNTERS];
+    int members = 0;
+    uint8_t valid = 0;
+
+    bool Open()
+    {
+        for(int i = 0; i < PERF_COUNTERS; i++)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = COUNTER_CONFIG[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.disabled = leader < 0 ? 1 : 0;     // 组长先关闭，全组打开后再启动
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            fds[i] = fd;
+            if(fd < 0)
+                continue;
+            if(leader < 0)
+                leader = fd;
+            slot[members++] = i;
+            valid |= 1 << i;
+        }
+        if(leader < 0)
+        {
+            state = -1;
+            return false;
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        state = 1;
+        return true;
+    }
+
+    ~Perf_Group()
+    {
+        for(int i = 0; i < PERF_COUNTERS && state != 0; i++)
+            if(fds[i] >= 0)
+                close(fds[i]);
+    }
+};
+
+static thread_local Perf_Group group;
+
+bool Perf_Counters::Enable(bool enable)
+{
+    if(!enable)
+    {
+        _enabled.store(false, memory_order_relaxed);
+        return true;
+    }
+    if(group.state == 0)
+        group.Open();
+    if(group.state < 0)
+    {
+        cerr << "硬件计数器不可用（" << strerror(errno) << "），可调低/proc/sys/kernel/perf_event_paranoid" << endl;
+        return false;
+    }
+    _enabled.store(true, memory_order_relaxed);
+    return true;
+}
+
+bool Perf_Counters::Read(Perf_Sample& sample)
+{
+    if(!Enabled())
+        return false;
+    if(group.state == 0)
+        group.Open();
+    if(group.state < 0)
+        return false;
+    uint64_t buffer[1 + PERF_COUNTERS];
+    if(read(group.leader, buffer, sizeof(buffer)) < (ssize_t)sizeof(uint64_t))
+        return false;
+    memset(sample.value, 0, sizeof(sample.value));
+    for(uint64_t k = 0; k < buffer[0] && k < (uint64_t)group.members; k++)
+        sample.value[group.slot[k]] = buffer[1 + k];
+    sample.valid = group.valid;
+    return true;
+}
+
+const char* Perf_Counters::Name(int counter)
+{
+    return counter >= 0 && counter < PERF_COUNTERS ? COUNTER_NAME[counter] : "unknown";
+}
+
+}
@@ -0,0 +1,205 @@
+#include "common/profiler.hpp"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace common{
+
+static const char* STAGE_NAME[] = {
+    "Frame", "Capture", "Preprocess", "Track_Recognition", "Edge_Extract",
+    "Recognition_Element", "Middle_Error", "Fitting", "Speed_Control", "Control", "Uart_Tx"
+};
+static_assert(sizeof(STAGE_NAME) / sizeof(STAGE_NAME[0]) == (size_t)Stage::COUNT, "阶段名与Stage不一致");
+
+static thread_local Profiler* current_profiler = nullptr;
+
+/**
+ * @brief 当前线程编号（追踪文件中的tid）
+ */
+static uint32_t Thread_Id()
+{
+    static atomic<uint32_t> next {1};
+    static thread_local uint32_t id = next.fetch_add(1, memory_order_relaxed);
+    return id;
+}
+
+Profiler::~Profiler()
+{
+    Stop_Trace();
+}
+
+Profiler& Profiler::Global()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler& Profiler::Current()
+{
+    return current_profiler ? *current_profiler : Global();
+}
+
+void Profiler::Bind(Profiler* profiler)
+{
+    current_profiler = profiler;
+}
+
+const char* Profiler::Name(Stage stage)
+{
+    return (int)stage < (int)Stage::COUNT ? STAGE_NAME[(int)stage] : "Unknown";
+}
+
+void Profiler::Record(Stage stage, int64_t start_ns, int64_t end_ns)
+{
+    _stages[(int)stage].Record(end_ns - start_ns);
+    int64_t duration = end_ns - start_ns;
+    _last_ns[(int)stage].store(duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration, memory_order_relaxed);
+    if(!_tracing.load(memory_order_relaxed))
+        return;
+    bool ok = _events.Emplace([&](Trace_Event& event)
+    {
+        event.start_ns = start_ns;
+        event.duration_ns = end_ns - start_ns;
+        event.thread = Thread_Id();
+        event.stage = stage;
+    });
+    if(!ok)
+        _dropped.fetch_add(1, memory_order_relaxed);
+}
+
+void Profiler::Record_Counters(Stage stage, const Perf_Sample& begin, const Perf_Sample& end)
+{
+    for(int k = 0; k < PERF_COUNTERS; k++)
+        _counters[(int)stage][k].fetch_add(end.value[k] - begin.value[k], memory_order_relaxed);
+    _counted[(int)stage].fetch_add(1, memory_order_relaxed);
+    _counter_valid.fetch_or(end.valid, memory_order_relaxed);
+}
+
+void Profiler::Merge(const Profiler& other)
+{
+    for(int i = 0; i < (int)Stage::COUNT; i++)
+    {
+        _stages[i].Merge(other._stages[i]);
+        for(int k = 0; k < PERF_COUNTERS; k++)
+            _counters[i][k].fetch_add(other._counters[i][k].load(memory_order_relaxed), memory_order_relaxed);
+        _counted[i].fetch_add(other._counted[i].load(memory_order_relaxed), memory_order_relaxed);
+    }
+    _counter_valid.fetch_or(other._counter_valid.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+uint64_t Profiler::Counters(Stage stage, uint64_t value[PERF_COUNTERS]) const
+{
+    for(int k = 0; k < PERF_COUNTERS; k++)
+        value[k] = _counters[(int)stage][k].load(memory_order_relaxed);
+    return _counted[(int)stage].load(memory_order_relaxed);
+}
+
+string Profiler::Report() const
+{
+    ostringstream ss;
+    ss << fixed << setprecision(3);
+    ss << "=== 分阶段耗时 (ms) ===" << endl;
+    ss << left << setw(20) << "Stage" << right      // 表头用英文，保证按字节宽度对齐
+       << setw(10) << "Count" << setw(10) << "Mean" << setw(10) << "P50"
+       << setw(10) << "P90" << setw(10) << "P99" << setw(10) << "Max" << endl;
+    for(int i = 0; i < (int)Stage::COUNT; i++)
+    {
+        const Histogram& h = _stages[i];
+        if(h.Count() == 0)
+            continue;
+        ss << left << setw(20) << STAGE_NAME[i] << right
+           << setw(10) << h.Count() << setw(10) << h.Mean() / 1e6
+           << setw(10) << h.Percentile(50) / 1e6 << setw(10) << h.Percentile(90) / 1e6
+           << setw(10) << h.Percentile(99) / 1e6 << setw(10) << h.Max() / 1e6 << endl;
+    }
+    // 硬件计数器：每次调用的平均值
+    uint8_t valid = _counter_valid.load(memory_order_relaxed);
+    if(valid)
+    {
+        ss << "--- 硬件计数器 (每次平均) ---" << endl;
+        ss << left << setw(20) << "Stage" << right << setw(10) << "Count" << setw(8) << "IPC";
+        for(int k = 0; k < PERF_COUNTERS; k++)
+            if(valid & (1 << k))
+                ss << setw(15) << Perf_Counters::Name(k);
+        ss << endl;
+        for(int i = 0; i < (int)Stage::COUNT; i++)
+        {
+            uint64_t value[PERF_COUNTERS];
+            uint64_t n = Counters((Stage)i, value);
+            if(n == 0)
+                continue;
+            double ipc = value[PERF_CYCLES] ? (double)value[PERF_INSTRUCTIONS] / value[PERF_CYCLES] : 0;
+            ss << left << setw(20) << STAGE_NAME[i] << right << setw(10) << n
+               << setw(8) << setprecision(2) << ipc << setprecision(0);
+            for(int k = 0; k < PERF_COUNTERS; k++)
+                if(valid & (1 << k))
+                    ss << setw(15) << (double)value[k] / n;
+            ss << setprecision(3) << endl;
+        }
+    }
+    if(_dropped.load(memory_order_relaxed) > 0)
+        ss << "追踪事件丢弃: " << _dropped.load(memory_order_relaxed) << endl;
+    ss << "=================================" << endl;
+    return ss.str();
+}
+
+void Profiler::Reset()
+{
+    for(auto& h : _stages)
+        h.Reset();
+    for(int i = 0; i < (int)Stage::COUNT; i++)
+    {
+        for(auto& c : _counters[i])
+            c.store(0, memory_order_relaxed);
+        _counted[i].store(0, memory_order_relaxed);
+        _last_ns[i].store(0, memory_order_relaxed);
+    }
+    _counter_valid.store(0, memory_order_relaxed);
+}
+
+bool Profiler::Start_Trace(const string& path)
+{
+    lock_guard<mutex> lock(_trace_mutex);
+    if(_trace.is_open())
+        return true;
+    _trace.open(path);
+    if(!_trace.is_open())
+        return false;
+    _trace << "{\"traceEvents\":[\n";
+    _first_event = true;
+    _trace_start_ns = Now_Ns();
+    _tracing.store(true, memory_order_release);
+    return true;
+}
+
+void Profiler::Flush_Trace()
+{
+    lock_guard<mutex> lock(_trace_mutex);
+    if(!_trace.is_open())
+        return;
+    Trace_Event event;
+    char line[160];
+    while(_events.Pop(event))
+    {
+        // 时间单位为微秒
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                 _first_event ? "" : ",\n", Name(event.stage), event.thread,
+                 (event.start_ns - _trace_start_ns) / 1e3, event.duration_ns / 1e3);
+        _trace << line;
+        _first_event = false;
+    }
+    _trace.flush();
+}
+
+void Profiler::Stop_Trace()
+{
+    if(!_tracing.exchange(false))
+        return;
+    Flush_Trace();
+    lock_guard<mutex> lock(_trace_mutex);
+    _trace << "\n]}\n";
+    _trace.close();
+}
+
+}
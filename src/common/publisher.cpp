@@ -0,0 +1,232 @@
+#include "common/publisher.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+using namespace std;
+
+namespace common{
+
+static_assert(sizeof(Shm_Header) % 64 == 0, "槽须按缓存行对齐");
+
+/**
+ * @brief 槽头部（第index个槽）
+ */
+static inline uint8_t* Slot_Base(const Shm_Header* header, uint64_t index)
+{
+    return (uint8_t*)header + sizeof(Shm_Header) + (index % header->slots) * header->slot_size;
+}
+
+/**
+ * @brief 图像拷入共享内存
+ * @return 图像字节数，超出容量时返回0
+ */
+static size_t Copy_Image(uint8_t* dst, size_t capacity, const cv::Mat& image)
+{
+    size_t row_bytes = image.cols * image.elemSize();
+    size_t bytes = row_bytes * image.rows;
+    if(image.empty() || bytes > capacity)
+        return 0;
+    if(image.isContinuous())
+        memcpy(dst, image.data, bytes);
+    else
+        for(int r = 0; r < image.rows; r++)
+            memcpy(dst + r * row_bytes, image.ptr(r), row_bytes);
+    return bytes;
+}
+
+/**
+ * @brief 尺寸与类型是否为发布端可能写入的值
+ */
+static inline bool Valid_Image(int rows, int cols, int type)
+{
+    return rows >= 0 && cols >= 0 && rows <= 4096 && cols <= 4096 &&
+           (type == CV_8UC1 || type == CV_8UC3);
+}
+
+FramePublisher::~FramePublisher()
+{
+    if(_header)
+    {
+        munmap(_header, _size);
+        shm_unlink(_name.c_str());     //已连接的查看器仍保有映射
+    }
+}
+
+bool FramePublisher::Open(int width, int height, const string& name)
+{
+    uint32_t capacity = (uint32_t)(width * height * 3 + 63) & ~63u;
+    uint32_t slot_size = (uint32_t)((sizeof(Shm_Slot) + 2 * capacity + 63) & ~size_t(63));
+    size_t size = sizeof(Shm_Header) + (size_t)SHM_SLOTS * slot_size;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if(fd < 0)
+    {
+        cerr << "共享内存创建失败: " << name << endl;
+        return false;
+    }
+    if(ftruncate(fd, size) != 0)
+    {
+        cerr << "共享内存大小设置失败: " << name << endl;
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+    {
+        cerr << "共享内存映射失败: " << name << endl;
+        return false;
+    }
+
+    // 先清零再写入布局，最后写magic，查看器见到magic才认为布局有效
+    Shm_Header* header = (Shm_Header*)addr;
+    header->magic = 0;
+    atomic_thread_fence(memory_order_release);
+    memset((uint8_t*)addr + sizeof(uint32_t), 0, size - sizeof(uint32_t));
+    header->slots = SHM_SLOTS;
+    header->slot_size = slot_size;
+    header->image_capacity = capacity;
+    header->latest.store(0, memory_order_relaxed);
+    for(uint32_t i = 0; i < SHM_SLOTS; i++)
+        ((Shm_Slot*)Slot_Base(header, i))->seq.store(0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    header->magic = SHM_MAGIC;
+
+    _name = name;
+    _header = header;
+    _size = size;
+    _count = 0;
+    return true;
+}
+
+void FramePublisher::Publish(const cv::Mat& raw, const cv::Mat& binary, const Shm_Overlay& overlay)
+{
+    if(!_header)
+        return;
+    uint64_t id = ++_count;
+    uint8_t* base = Slot_Base(_header, id);
+    Shm_Slot* slot = (Shm_Slot*)base;
+    uint8_t* raw_data = base + sizeof(Shm_Slot);
+    uint8_t* binary_data = raw_data + _header->image_capacity;
+
+    uint32_t seq = slot->seq.load(memory_order_relaxed);
+    slot->seq.store(seq + 1, memory_order_relaxed);     // 奇数：写入中
+    atomic_thread_fence(memory_order_release);
+
+    bool raw_ok = Copy_Image(raw_data, _header->image_capacity, raw) > 0;
+    slot->raw_rows = raw_ok ? raw.rows : 0;
+    slot->raw_cols = raw_ok ? raw.cols : 0;
+    slot->raw_type = raw.type();
+    bool binary_ok = Copy_Image(binary_data, _header->image_capacity, binary) > 0;
+    slot->binary_rows = binary_ok ? binary.rows : 0;
+    slot->binary_cols = binary_ok ? binary.cols : 0;
+    slot->binary_type = binary.type();
+    memcpy(&slot->overlay, &overlay, sizeof(Shm_Overlay));
+
+    slot->seq.store(seq + 2, memory_order_release);     // 偶数：写入完成
+    _header->latest.store(id, memory_order_release);
+}
+
+FrameSubscriber::~FrameSubscriber()
+{
+    Detach();
+}
+
+bool FrameSubscriber::Attach(const string& path)
+{
+    Detach();
+    // 形如"/name"的按POSIX共享内存打开，其余按普通文件打开（如挂载的/dev/shm）
+    bool is_shm = path.size() > 1 && path[0] == '/' && path.find('/', 1) == string::npos;
+    int fd = is_shm ? shm_open(path.c_str(), O_RDONLY, 0) : open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Shm_Header))
+    {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return false;
+
+    const Shm_Header* header = (const Shm_Header*)addr;
+    atomic_thread_fence(memory_order_acquire);
+    if(header->magic != SHM_MAGIC ||
+       sizeof(Shm_Header) + (size_t)header->slots * header->slot_size > (size_t)st.st_size)
+    {
+        munmap(addr, st.st_size);
+        return false;
+    }
+    _header = header;
+    _size = st.st_size;
+    _last = 0;
+    return true;
+}
+
+void FrameSubscriber::Detach()
+{
+    if(_header)
+        munmap((void*)_header, _size);
+    _header = nullptr;
+    _size = 0;
+}
+
+bool FrameSubscriber::Read(Shm_Frame& frame)
+{
+    if(!_header)
+        return false;
+    for(int attempt = 0; attempt < 4; attempt++)
+    {
+        uint64_t id = _header->latest.load(memory_order_acquire);
+        if(id == 0 || id == _last)
+            return false;
+        const uint8_t* base = Slot_Base(_header, id);
+        const Shm_Slot* slot = (const Shm_Slot*)base;
+        const uint8_t* raw_data = base + sizeof(Shm_Slot);
+        const uint8_t* binary_data = raw_data + _header->image_capacity;
+
+        uint32_t seq1 = slot->seq.load(memory_order_acquire);
+        if(seq1 & 1)
+        {
+            _retries++;
+            continue;
+        }
+        int raw_rows = slot->raw_rows, raw_cols = slot->raw_cols, raw_type = slot->raw_type;
+        int binary_rows = slot->binary_rows, binary_cols = slot->binary_cols, binary_type = slot->binary_type;
+        memcpy(&frame.overlay, &slot->overlay, sizeof(Shm_Overlay));
+        // 尺寸在校验前可能已被改写，先确认不越界再拷贝
+        if(!Valid_Image(raw_rows, raw_cols, raw_type) || !Valid_Image(binary_rows, binary_cols, binary_type))
+        {
+            _retries++;
+            continue;
+        }
+        frame.raw.create(raw_rows, raw_cols, raw_type);
+        frame.binary.create(binary_rows, binary_cols, binary_type);
+        size_t raw_bytes = frame.raw.total() * frame.raw.elemSize();
+        size_t binary_bytes = frame.binary.total() * frame.binary.elemSize();
+        if(raw_bytes > _header->image_capacity || binary_bytes > _header->image_capacity)
+        {
+            _retries++;
+            continue;
+        }
+        memcpy(frame.raw.data, raw_data, raw_bytes);
+        memcpy(frame.binary.data, binary_data, binary_bytes);
+        atomic_thread_fence(memory_order_acquire);
+        if(slot->seq.load(memory_order_relaxed) != seq1)
+        {
+            _retries++;     // 读取期间被整圈覆盖
+            continue;
+        }
+        _last = id;
+        return true;
+    }
+    return false;
+}
+
+}
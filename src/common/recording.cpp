@@ -0,0 +1,292 @@
+#include "common/recording.hpp"
+#include "common/clock.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+using namespace std;
+
+namespace common{
+
+static_assert(sizeof(Recording_Header) == 48, "Recording_Header布局变化时需同步修改录制文件版本");
+static_assert(sizeof(Recording_Chunk) == 16, "Recording_Chunk布局变化时需同步修改录制文件版本");
+static_assert(sizeof(Recording_Frame) == 16, "Recording_Frame布局变化时需同步修改录制文件版本");
+static_assert(sizeof(Recording_Index) == 24, "Recording_Index布局变化时需同步修改录制文件版本");
+
+/**
+ * @brief 数据块总长（块头 + 数据 + 对齐）
+ */
+static inline size_t Chunk_Bytes(size_t size)
+{
+    return sizeof(Recording_Chunk) + (size + RECORDING_ALIGN - 1) / RECORDING_ALIGN * RECORDING_ALIGN;
+}
+
+//----------------------------------------写出----------------------------------------
+
+RecordingWriter::RecordingWriter(size_t queue_limit)
+    : _queue_limit(queue_limit)
+{
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    Close();
+}
+
+bool RecordingWriter::Open(const string& path, const string& config)
+{
+    Close();
+    _file = fopen(path.c_str(), "wb");
+    if(!_file)
+    {
+        cerr << "录制文件创建失败: " << path << endl;
+        return false;
+    }
+    setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+    _path = path;
+    memset(&_header, 0, sizeof(_header));
+    memcpy(_header.magic, RECORDING_MAGIC, sizeof(_header.magic));
+    _header.header_size = sizeof(Recording_Header);
+    _header.chunk_header_size = sizeof(Recording_Chunk);
+    _header.start_ns = Now_Ns();
+    _header.wall_time = time(nullptr);
+    fwrite(&_header, sizeof(_header), 1, _file);
+    _offset = sizeof(_header);
+    _index.clear();
+    _queue.clear();
+    _queued = 0;
+    _dropped = 0;
+    _chunks = 0;
+
+    _running = true;
+    _thread = thread(&RecordingWriter::Writer_Loop, this);
+    _open.store(true, memory_order_release);
+    Append(Chunk_Type::CONFIG, _header.start_ns, nullptr, 0, config.data(), config.size());
+    return true;
+}
+
+void RecordingWriter::Close()
+{
+    if(!_file)
+        return;
+    _open.store(false, memory_order_release);
+    {
+        lock_guard<mutex> lock(_mutex);
+        _running = false;
+    }
+    _cv.notify_one();
+    if(_thread.joinable())
+        _thread.join();
+
+    // 写出索引并回填文件头
+    fseek(_file, _offset, SEEK_SET);
+    fwrite(_index.data(), sizeof(Recording_Index), _index.size(), _file);
+    _header.index_offset = _offset;
+    _header.index_count = _index.size();
+    fseek(_file, 0, SEEK_SET);
+    fwrite(&_header, sizeof(_header), 1, _file);
+    fclose(_file);
+    _file = nullptr;
+}
+
+void RecordingWriter::Write_Frame(int64_t stamp_ns, uint32_t frame_id, uint32_t codec, int width, int height, const void* data, size_t size)
+{
+    Recording_Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.frame_id = frame_id;
+    frame.codec = codec;
+    frame.width = width;
+    frame.height = height;
+    Append(Chunk_Type::FRAME, stamp_ns, &frame, sizeof(frame), data, size);
+}
+
+void RecordingWriter::Write_Uart(Chunk_Type type, int64_t stamp_ns, const void* data, size_t size)
+{
+    Append(type, stamp_ns, nullptr, 0, data, size);
+}
+
+void RecordingWriter::Append(Chunk_Type type, int64_t stamp_ns, const void* head, size_t head_size, const void* data, size_t size)
+{
+    if(!Is_Open())
+        return;
+    Recording_Chunk chunk {(uint32_t)type, (uint32_t)(head_size + size), stamp_ns};
+    vector<uint8_t> block(Chunk_Bytes(chunk.size), 0);
+    memcpy(block.data(), &chunk, sizeof(chunk));
+    if(head_size)
+        memcpy(block.data() + sizeof(chunk), head, head_size);
+    if(size)
+        memcpy(block.data() + sizeof(chunk) + head_size, data, size);
+    {
+        lock_guard<mutex> lock(_mutex);
+        if(_queued + block.size() > _queue_limit)
+        {
+            _dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        _queued += block.size();
+        _queue.push_back(move(block));
+    }
+    _cv.notify_one();
+}
+
+void RecordingWriter::Writer_Loop()
+{
+    deque<vector<uint8_t>> batch;
+    while(true)
+    {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _cv.wait(lock, [this]() { return !_queue.empty() || !_running; });
+            if(_queue.empty() && !_running)
+                break;
+            batch.swap(_queue);
+            _queued = 0;
+        }
+        for(const vector<uint8_t>& block : batch)
+        {
+            const Recording_Chunk* chunk = reinterpret_cast<const Recording_Chunk*>(block.data());
+            if(fwrite(block.data(), block.size(), 1, _file) != 1)
+            {
+                _dropped.fetch_add(1, memory_order_relaxed);
+                continue;
+            }
+            _index.push_back({_offset, chunk->stamp_ns, chunk->type, chunk->size});
+            _offset += block.size();
+            _chunks.fetch_add(1, memory_order_relaxed);
+        }
+        batch.clear();
+    }
+}
+
+//----------------------------------------读取----------------------------------------
+
+RecordingReader::~RecordingReader()
+{
+    if(_base)
+        munmap(const_cast<uint8_t*>(_base), _size);
+}
+
+shared_ptr<RecordingReader> RecordingReader::Open(const string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return nullptr;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Recording_Header))
+    {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        return nullptr;
+
+    shared_ptr<RecordingReader> reader(new RecordingReader());
+    reader->_base = static_cast<const uint8_t*>(addr);
+    reader->_size = st.st_size;
+    reader->_header = reinterpret_cast<const Recording_Header*>(addr);
+    const Recording_Header& h = *reader->_header;
+    if(memcmp(h.magic, RECORDING_MAGIC, sizeof(h.magic)) != 0 || h.header_size != sizeof(Recording_Header) ||
+       h.chunk_header_size != sizeof(Recording_Chunk) || !reader->Scan())
+        return nullptr;
+    return reader;
+}
+
+bool RecordingReader::Is_Recording(const string& path)
+{
+    const string extension = RECORDING_EXTENSION;
+    return path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**
+ * @brief 读取索引（未正常关闭时顺序扫描数据块重建），按类型整理
+ */
+bool RecordingReader::Scan()
+{
+    vector<Recording_Index> index;
+    const Recording_Header& h = *_header;
+    if(h.index_offset && h.index_offset + h.index_count * sizeof(Recording_Index) <= _size)
+    {
+        const Recording_Index* entries = reinterpret_cast<const Recording_Index*>(_base + h.index_offset);
+        index.assign(entries, entries + h.index_count);
+    }
+    else
+    {
+        // 逐块扫描到文件结束或第一个不完整的数据块
+        _recovered = true;
+        uint64_t offset = sizeof(Recording_Header);
+        while(offset + sizeof(Recording_Chunk) <= _size)
+        {
+            const Recording_Chunk* chunk = reinterpret_cast<const Recording_Chunk*>(_base + offset);
+            if(chunk->type < (uint32_t)Chunk_Type::CONFIG || chunk->type > (uint32_t)Chunk_Type::UART_TX ||
+               offset + Chunk_Bytes(chunk->size) > _size)
+                break;
+            index.push_back({offset, chunk->stamp_ns, chunk->type, chunk->size});
+            offset += Chunk_Bytes(chunk->size);
+        }
+    }
+
+    for(const Recording_Index& entry : index)
+    {
+        if(entry.offset + Chunk_Bytes(entry.size) > _size)
+            return false;
+        switch(static_cast<Chunk_Type>(entry.type))
+        {
+        case Chunk_Type::CONFIG:
+            _config.push_back(entry);
+            break;
+        case Chunk_Type::FRAME:
+            if(entry.size >= sizeof(Recording_Frame))
+                _frames.push_back(entry);
+            break;
+        case Chunk_Type::UART_RX:
+            _uart_rx.push_back(entry);
+            break;
+        case Chunk_Type::UART_TX:
+            _uart_tx.push_back(entry);
+            break;
+        }
+    }
+    return true;
+}
+
+string RecordingReader::Config() const
+{
+    if(_config.empty())
+        return string();
+    return string(reinterpret_cast<const char*>(Payload(_config[0])), _config[0].size);
+}
+
+size_t RecordingReader::Find_Frame(int64_t stamp_ns) const
+{
+    return lower_bound(_frames.begin(), _frames.end(), stamp_ns,
+                       [](const Recording_Index& entry, int64_t stamp) { return entry.stamp_ns < stamp; }) - _frames.begin();
+}
+
+int64_t RecordingReader::Replay_Offset()
+{
+    int state = 0;
+    if(_replay_state.compare_exchange_strong(state, 1))
+    {
+        _replay_offset.store(Now_Ns() - _header->start_ns, memory_order_release);
+        _replay_state.store(2, memory_order_release);
+    }
+    else
+        while(_replay_state.load(memory_order_acquire) != 2)
+            this_thread::yield();   // 另一线程正在设置
+    return _replay_offset.load(memory_order_acquire);
+}
+
+void RecordingReader::Set_Replay_Offset(int64_t offset)
+{
+    _replay_offset.store(offset, memory_order_release);
+    _replay_state.store(2, memory_order_release);
+}
+
+}
@@ -1,6 +1,13 @@
 #include "common/uart.hpp"
+#include "common/profiler.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
 
-using namespace LibSerial;
 using namespace std;
 
 // 构造函数
@@ -12,115 +19,112 @@ Uart::~Uart() {
 }
 
 /**
- * @brief 串口接收字节数据
+ * @brief 启动串口通信
  *
- * @param charBuffer
- * @param msTimeout
+ * @param port 串口号
  * @return int
  */
-int Uart::receiveBytes(unsigned char &charBuffer, size_t msTimeout) {
-    /*try检测语句块有没有异常。如果没有发生异常,就检测不到。
-    如果发生异常，則交给 catch 处理，执行 catch 中的语句* */
-    try {
-        /*从串口读取一个数据,指定msTimeout时长内,没有收到数据，抛出异常。
-        如果msTimeout为0，则该方法将阻塞，直到数据可用为止。*/
-        serialPort->ReadByte(charBuffer, msTimeout); // 可能出现异常的代码段
-    } catch (const ReadTimeout &) // catch捕获并处理 try 检测到的异常。
-    {
-        // std::cerr << "The ReadByte() call has timed out." << std::endl;
+int Uart::open(void) {
+    // 非阻塞打开，读写均由IO线程通过epoll调度
+    fd = ::open(portName.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Serial port: " << portName << "open failed ..."
+                  << std::endl;
         return -2;
-    } catch (const NotOpen &) // catch()中指明了当前 catch 可以处理的异常类型
-    {
-        std::cerr << "Port Not Open ..." << std::endl;
-        return -1;
     }
-    return 0;
-}
 
-/**
- * @brief 串口发送字节数据
- *
- * @param data
- * @return int
- */
-int Uart::transmitByte(unsigned char data) {
-    // try检测语句块有没有异常
-    try {
-        serialPort->WriteByte(data); // 写数据到串口
-    } catch (const std::runtime_error &) // catch捕获并处理 try 检测到的异常。
-    {
-        std::cerr << "The Write() runtime_error." << std::endl;
-        return -2;
-    } catch (const NotOpen &) // catch捕获并处理 try 检测到的异常。
-    {
-        std::cerr << "Port Not Open ..." << std::endl;
-        return -1;
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        std::cerr << "Serial port: " << portName << " is not a tty ..."
+                  << std::endl;
+        ::close(fd);
+        fd = -1;
+        return -3;
+    }
+    cfmakeraw(&tty);                  // 原始模式
+    cfsetispeed(&tty, B115200);       // 设置波特率
+    cfsetospeed(&tty, B115200);
+    tty.c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS); // 无校验，1个停止位，无流控
+    tty.c_cflag |= CS8 | CLOCAL | CREAD;                 // 8位数据位
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        std::cerr << "Serial port: " << portName << " config failed ..."
+                  << std::endl;
+        ::close(fd);
+        fd = -1;
+        return -3;
     }
-    serialPort->DrainWriteBuffer(); // 等待，直到写缓冲区耗尽，然后返回。
+    tcflush(fd, TCIOFLUSH);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = eventFd;
+    epoll_event evPort{};
+    evPort.events = 0;
+    evPort.data.fd = fd;
+    if (epollFd < 0 || eventFd < 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, eventFd, &ev) != 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &evPort) != 0) {
+        std::cerr << "Serial port: " << portName << " epoll init failed ..."
+                  << std::endl;
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (eventFd >= 0)
+            ::close(eventFd);
+        ::close(fd);
+        fd = epollFd = eventFd = -1;
+        return -4;
+    }
+
+    rxHead = rxScan = rxTail = 0;
+    rxState = RX_HEAD;
+    txBuffer.reserve(USB_TX_BUFFER_MAX);
+    txWriting.reserve(USB_TX_BUFFER_MAX);
+    isOpen = true;
+
+    // 启动IO子线程
+    ioRunning = true;
+    threadIo = std::make_unique<std::thread>(&Uart::ioLoop, this);
+
     return 0;
 }
 
 /**
- * @brief 启动串口通信
+ * @brief 以录制文件代替串口（回放）
  *
- * @param port 串口号
- * @return int
+ * @param reader 录制文件
+ * @return int 0：成功；-1：录制文件为空；-4：eventfd创建失败
  */
-int Uart::open(void) {
-    serialPort = std::make_shared<SerialPort>();
-    if (serialPort == nullptr) {
-        std::cerr << "Serial Create Failed ." << std::endl;
+int Uart::openReplay(std::shared_ptr<common::RecordingReader> reader) {
+    if (!reader)
         return -1;
-    }
-    // try检测语句块有没有异常
-    try {
-        serialPort->Open(portName);                     // 打开串口
-        serialPort->SetBaudRate(BaudRate::BAUD_115200); // 设置波特率
-        serialPort->SetCharacterSize(CharacterSize::CHAR_SIZE_8); // 8位数据位
-        serialPort->SetFlowControl(FlowControl::FLOW_CONTROL_NONE); // 设置流控
-        serialPort->SetParity(Parity::PARITY_NONE);                 // 无校验
-        serialPort->SetStopBits(StopBits::STOP_BITS_1); // 1个停止位
-    } catch (const OpenFailed &) // catch捕获并处理 try 检测到的异常。
-    {
-        std::cerr << "Serial port: " << portName << "open failed ..."
-                  << std::endl;
-        isOpen = false;
-        return -2;
-    } catch (const AlreadyOpen &) // catch捕获并处理 try 检测到的异常。
-    {
-        std::cerr << "Serial port: " << portName << "open failed ..."
-                  << std::endl;
-        isOpen = false;
-        return -3;
-    } catch (...) // catch捕获并处理 try 检测到的异常。
-    {
-        std::cerr << "Serial port: " << portName << " recv exception ..."
-                  << std::endl;
-        isOpen = false;
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd < 0) {
+        std::cerr << "Replay: eventfd init failed ..." << std::endl;
         return -4;
     }
-
-    serialStr.start = false;
-    serialStr.index = 0;
+    replay = reader;
+    txBuffer.reserve(USB_TX_BUFFER_MAX);
+    txWriting.reserve(USB_TX_BUFFER_MAX);
     isOpen = true;
 
+    ioRunning = true;
+    threadIo = std::make_unique<std::thread>(&Uart::replayLoop, this);
     return 0;
 }
 
 /**
- * @brief 启动接收子线程
+ * @brief 启动接收（由IO线程处理可读事件）
  *
  */
 void Uart::startReceive(void) {
     if (!isOpen) // 串口是否正常打开
         return;
-
-    // 启动串口接收子线程
-    threadRec = std::make_unique<std::thread>([this]() {
-        while (1) {
-            receiveCheck(); // 串口接收校验
-        }
-    });
+    rxEnabled = true;
+    wakeup();
 }
 
 /**
@@ -128,89 +132,480 @@ void Uart::startReceive(void) {
  *
  */
 void Uart::close(void) {
+    if (replay) {
+        printf(" uart replay exit: %u/%u frames mismatched\n",
+               replayMismatches.load(), replayCompared.load());
+        ioRunning = false;
+        wakeup();
+        if (threadIo && threadIo->joinable()) {
+            threadIo->join();
+        }
+        threadIo = nullptr;
+        isOpen = false;
+        ::close(eventFd);
+        eventFd = -1;
+        replay = nullptr;
+        return;
+    }
+    if (fd < 0)
+        return;
     printf(" uart thread exit!\n");
     carControl(0, PWMSERVOMID);
-    if (threadRec && threadRec->joinable()) {
-        threadRec->join();
+    ioRunning = false;
+    wakeup();
+    if (threadIo && threadIo->joinable()) {
+        threadIo->join();
     }
-    if (serialPort != nullptr) {
-        serialPort->Close();
-        serialPort = nullptr;
+    threadIo = nullptr;
+
+    // IO线程已退出，取消限速并尽量写出剩余数据（如停车指令）
+    txMinInterval = 0;
+    int64_t deadline = common::Now_Ns() + 100000000LL;
+    while (!flushTx() && common::Now_Ns() < deadline) {
+        pollfd pfd{fd, POLLOUT, 0};
+        poll(&pfd, 1, 10);
     }
+
     isOpen = false;
+    ::close(epollFd);
+    ::close(eventFd);
+    ::close(fd);
+    fd = epollFd = eventFd = -1;
 }
 
 /**
- * @brief 串口接收校验
+ * @brief 提交一帧数据，必要时唤醒IO线程
  *
+ * @param data 帧数据
+ * @param len 帧长
+ * @return int 0：成功；-1：串口未打开；-2：发送缓冲已满
  */
-void Uart::receiveCheck(void) {
-    if (!isOpen) // 串口是否正常打开
-        return;
+int Uart::submit(const uint8_t *data, size_t len) {
+    if (!isOpen)
+        return -1;
+    int slot = slotIndex(data[1]);
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(txMutex);
+        if (slot >= 0) {
+            // 状态类指令：只保留最新值
+            TxSlot &s = txSlots[slot];
+            if (s.dirty) {
+                txCoalesced.fetch_add(1, std::memory_order_relaxed); // 旧指令尚未发出，直接覆盖
+            } else if (s.length == len && memcmp(s.frame, data, len) == 0) {
+                txUnchanged.fetch_add(1, std::memory_order_relaxed); // 与上次发送相同，由心跳保活
+                return 0;
+            } else {
+                wake = true;
+            }
+            memcpy(s.frame, data, len);
+            s.length = len;
+            s.dirty = true;
+        } else {
+            // 事件类指令：按顺序全部发送
+            if (txBuffer.size() + len > USB_TX_BUFFER_MAX) {
+                txDropped.fetch_add(1, std::memory_order_relaxed);
+                return -2;
+            }
+            wake = txBuffer.empty(); // 已有待发送数据时IO线程必然会处理，无需重复唤醒
+            txBuffer.insert(txBuffer.end(), data, data + len);
+        }
+    }
+    if (wake)
+        wakeup();
+    return 0;
+}
 
-    uint8_t resByte = 0;
-    int ret = receiveBytes(resByte, 0);
-    if (ret == 0) {
-        if (resByte == USB_FRAME_HEAD && !serialStr.start) // 监听帧头
-        {
-            serialStr.start = true;                   // 开始接收数据
-            serialStr.buffRead[0] = resByte;          // 获取帧头
-            serialStr.buffRead[2] = USB_FRAME_LENMIN; // 初始化帧长
-            serialStr.index = 1;
-        } else if (serialStr.index == 2) // 接收帧的长度
-        {
-            serialStr.buffRead[serialStr.index] = resByte;
-            serialStr.index++;
-            if (resByte > USB_FRAME_LENMAX ||
-                resByte < USB_FRAME_LENMIN) // 帧长错误
-            {
-                serialStr.buffRead[2] = USB_FRAME_LENMIN; // 重置帧长
-                serialStr.index = 0;
-                serialStr.start = false; // 重新监听帧长
+/**
+ * @brief 地址对应的状态类指令槽
+ *
+ * @param addr 通信地址
+ * @return int 槽序号，事件类指令返回-1
+ */
+int Uart::slotIndex(uint8_t addr) {
+    switch (addr) {
+    case USB_ADDR_CARCTRL:
+        return 0;
+    case USB_ADDR_LED:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 组装下一批待写出数据：事件类指令、到期的新指令及心跳（持有txMutex时调用）
+ *
+ * @param now 当前时间
+ */
+void Uart::collectTx(int64_t now) {
+    txWriting.clear();
+    txWriting.swap(txBuffer);
+    txOffset = 0;
+    writingControl = false;
+    txDeadline = INT64_MAX;
+
+    int64_t interval = txMinInterval.load(std::memory_order_relaxed);
+    int64_t heartbeat = txHeartbeat.load(std::memory_order_relaxed);
+    for (int i = 0; i < USB_TX_SLOTS; i++) {
+        TxSlot &s = txSlots[i];
+        if (s.length == 0)
+            continue;
+        bool control = s.frame[1] == USB_ADDR_CARCTRL;
+        bool send = false;
+        if (s.dirty) {
+            if (now >= s.lastSent + interval) {
+                send = true;
+                s.dirty = false;
+                writingControl |= control;
+            } else {
+                txDeadline = std::min(txDeadline, s.lastSent + interval); // 限速，到期再发
             }
-        } else if (serialStr.start &&
-                   serialStr.index < USB_FRAME_LENMAX) // 开始接收数据
-        {
-            serialStr.buffRead[serialStr.index] = resByte; // 读取数据
-            serialStr.index++;                             // 索引下移
+        } else if (control && heartbeat > 0 && now >= s.lastSent + heartbeat) {
+            send = true; // 指令长时间未变化，重发保活
+            txHeartbeats.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (send) {
+            txWriting.insert(txWriting.end(), s.frame, s.frame + s.length);
+            s.lastSent = now;
+        }
+        if (control && heartbeat > 0 && !s.dirty)
+            txDeadline = std::min(txDeadline, s.lastSent + heartbeat);
+    }
+}
+
+/**
+ * @brief 唤醒IO线程
+ *
+ */
+void Uart::wakeup(void) {
+    uint64_t one = 1;
+    if (::write(eventFd, &one, sizeof(one)) < 0) {
+        // 计数器溢出时IO线程必然处于待唤醒状态，忽略
+    }
+}
+
+/**
+ * @brief 写出待发送数据，每批数据一次write
+ *
+ * @return true 已全部写出
+ * @return false 内核缓冲已满，等待可写事件
+ */
+bool Uart::flushTx(void) {
+    while (true) {
+        if (txOffset >= txWriting.size()) {
+            // 取出调用线程积累的数据
+            std::lock_guard<std::mutex> lock(txMutex);
+            collectTx(common::Now_Ns());
+            if (txWriting.empty())
+                return true;
+            if (recording)
+                recording->Write_Uart(common::Chunk_Type::UART_TX, common::Now_Ns(),
+                                      txWriting.data(), txWriting.size());
         }
 
-        // 帧长接收完毕
-        if ((serialStr.index >= USB_FRAME_LENMAX ||
-             serialStr.index >= serialStr.buffRead[2]) &&
-            serialStr.index > USB_FRAME_LENMIN) // 检测是否接收完数据
+        ssize_t n;
         {
-            uint8_t check = 0; // 初始化校验和
-            uint8_t length = USB_FRAME_LENMIN;
-            length = serialStr.buffRead[2]; // 读取本次数据的长度
-            for (int i = 0; i < length - 1; i++)
-                check += serialStr.buffRead[i]; // 累加校验和
+            NS_PROFILE(Uart_Tx);
+            n = ::write(fd, txWriting.data() + txOffset, txWriting.size() - txOffset);
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+            if (errno == EINTR)
+                continue;
+            std::cerr << "The write() error: " << strerror(errno) << std::endl;
+            txOffset = txWriting.size(); // 丢弃本批数据
+            continue;
+        }
+        txOffset += n;
+        txWindowBytes += n;
+        if (txOffset >= txWriting.size() && writingControl)
+            txStamp.store(common::Now_Ns(), std::memory_order_relaxed); // 记录执行时间
+    }
+}
+
+/**
+ * @brief 批量读取全部可用字节到环形缓冲并解码
+ *
+ */
+void Uart::readAvailable(void) {
+    while (true) {
+        size_t used = rxTail - rxHead;
+        if (used >= USB_RX_RING_SIZE) { // 缓冲已满仍未解出帧，丢弃最早的数据
+            resync();
+            continue;
+        }
+        size_t offset = rxTail & (USB_RX_RING_SIZE - 1);
+        size_t chunk = std::min(USB_RX_RING_SIZE - used, USB_RX_RING_SIZE - offset);
+        ssize_t n = ::read(fd, rxRing + offset, chunk);
+        if (n > 0) {
+            rxTail += n;
+            decode();
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        return; // 无数据（EAGAIN）或对端关闭
+    }
+}
+
+/**
+ * @brief 当前帧校验失败，从帧头的下一字节重新搜索帧头
+ *
+ */
+void Uart::resync(void) {
+    rxErrors.fetch_add(1, std::memory_order_relaxed);
+    rxHead++;
+    rxScan = rxHead;
+    rxState = RX_HEAD;
+}
 
-            if (check == serialStr.buffRead[length - 1]) // 校验和相等
+/**
+ * @brief 增量解码环形缓冲中的数据
+ *
+ * 每个字节只在状态机中推进一次；帧长或校验错误时回退到帧头之后重新搜索，
+ * 避免因一个错误字节丢失紧随其后的有效帧。
+ */
+void Uart::decode(void) {
+    const size_t mask = USB_RX_RING_SIZE - 1;
+    while (rxScan != rxTail) {
+        uint8_t data = rxRing[rxScan & mask];
+        switch (rxState) {
+        case RX_HEAD: // 监听帧头
+            rxScan++;
+            if (data == USB_FRAME_HEAD) {
+                rxCheck = data;
+                rxState = RX_ADDR;
+            } else {
+                rxHead = rxScan;
+            }
+            break;
+        case RX_ADDR: // 地址
+            rxScan++;
+            rxCheck += data;
+            rxState = RX_LEN;
+            break;
+        case RX_LEN: // 帧长
+            if (data < USB_FRAME_LENMIN || data > USB_FRAME_LENMAX) {
+                resync(); // 帧长错误
+                break;
+            }
+            rxScan++;
+            rxLength = data;
+            rxCheck += data;
+            rxState = RX_BODY;
+            break;
+        case RX_BODY: // 数据及校验位
+            rxScan++;
+            if (rxScan - rxHead < rxLength) {
+                rxCheck += data; // 累加校验和
+                break;
+            }
+            if (data != rxCheck) {
+                resync(); // 校验和错误
+                break;
+            }
             {
-                memcpy(serialStr.buffFinish, serialStr.buffRead,
-                       USB_FRAME_LENMAX); // 储存接收的数据
-                dataTransform();
+                Message msg;
+                msg.addr = rxRing[(rxHead + 1) & mask];
+                msg.length = rxLength;
+                for (size_t i = 0; i < rxLength; i++)
+                    msg.buff[i] = rxRing[(rxHead + i) & mask];
+                msg.stamp = common::Now_Ns();
+                dataTransform(msg);
             }
+            rxHead = rxScan; // 重新监听帧头
+            rxState = RX_HEAD;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief IO线程主循环：epoll等待可读、可写及唤醒事件
+ *
+ */
+void Uart::ioLoop(void) {
+    uint32_t events = 0; // 当前注册的串口事件
+    epoll_event ev[4];
+    txWindowStart = common::Now_Ns();
+    while (ioRunning) {
+        // 按接收使能及未写完数据更新关注的事件
+        uint32_t want = (rxEnabled ? (uint32_t)EPOLLIN : 0u) |
+                        (txOffset < txWriting.size() ? (uint32_t)EPOLLOUT : 0u);
+        if (want != events) {
+            epoll_event evPort{};
+            evPort.events = want;
+            evPort.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &evPort);
+            events = want;
+        }
 
-            serialStr.index = 0;     // 重新开始下一轮数据接收
-            serialStr.start = false; // 重新监听帧头
+        // 等待至限速到期或心跳时间，最长1秒（更新链路占用率）
+        int timeout = 1000;
+        if (txDeadline != INT64_MAX) {
+            int64_t wait = txDeadline - common::Now_Ns();
+            timeout = wait <= 0 ? 0 : (int)std::min<int64_t>(1000, (wait + 999999) / 1000000);
+        }
+        int n = epoll_wait(epollFd, ev, 4, timeout);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "epoll_wait error: " << strerror(errno) << std::endl;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (ev[i].data.fd == eventFd) {
+                uint64_t count;
+                if (::read(eventFd, &count, sizeof(count)) < 0) {
+                    // 已被读空，忽略
+                }
+                continue;
+            }
+            if (ev[i].events & (EPOLLERR | EPOLLHUP)) {
+                std::cerr << "Serial port: " << portName << " hang up ..."
+                          << std::endl;
+                isOpen = false;
+                ioRunning = false;
+                break;
+            }
+            if (ev[i].events & EPOLLIN)
+                readAvailable();
+        }
+        // 新提交、可写、限速到期或心跳时间到：继续写出
+        flushTx();
+
+        // 链路占用率 = 写出比特数（含起止位，每字节10位）/ 波特率
+        int64_t now = common::Now_Ns();
+        if (now - txWindowStart >= 1000000000LL) {
+            double seconds = (now - txWindowStart) * 1e-9;
+            txUtilisation.store(txWindowBytes * 10.0 / (USB_BAUD_RATE * seconds),
+                                std::memory_order_relaxed);
+            txWindowStart = now;
+            txWindowBytes = 0;
+        }
+    }
+}
+
+/**
+ * @brief 回放线程主循环：按录制时间注入接收消息，发送数据与录制比较而不写出
+ *
+ */
+void Uart::replayLoop(void) {
+    // 录制的指令按地址整理为变化序列（心跳及重复帧不计）
+    std::map<uint8_t, std::vector<std::vector<uint8_t>>> expected;
+    for (const common::Recording_Index &entry : replay->Uart_Tx()) {
+        const uint8_t *data = replay->Payload(entry);
+        for (size_t i = 0; i + USB_FRAME_LENMIN <= entry.size && data[i + 2] >= USB_FRAME_LENMIN &&
+                           i + data[i + 2] <= entry.size; i += data[i + 2]) {
+            std::vector<std::vector<uint8_t>> &frames = expected[data[i + 1]];
+            std::vector<uint8_t> frame(data + i, data + i + data[i + 2]);
+            if (frames.empty() || frames.back() != frame)
+                frames.push_back(std::move(frame));
+        }
+    }
+    std::map<uint8_t, size_t> matched;           // 各地址已比较的帧数
+    std::map<uint8_t, std::vector<uint8_t>> last; // 各地址最近一次发送的帧
+
+    const std::vector<common::Recording_Index> &rx = replay->Uart_Rx();
+    size_t next = 0;
+    while (ioRunning) {
+        // 回放时钟与摄像头共用：按录制时间回放时偏移固定，否则随摄像头读帧推进
+        const int64_t offset = replay->Replay_Offset();
+        int64_t now = common::Now_Ns();
+        // 注入已到时间的接收消息（接收未使能时暂缓）
+        while (rxEnabled && next < rx.size() && rx[next].stamp_ns + offset <= now) {
+            Message msg;
+            msg.length = std::min<uint32_t>(rx[next].size, USB_FRAME_LENMAX);
+            memcpy(msg.buff, replay->Payload(rx[next]), msg.length);
+            msg.addr = msg.buff[1];
+            msg.stamp = rx[next].stamp_ns + offset;
+            dataTransform(msg);
+            next++;
+        }
+
+        // 发送数据照常组装，与录制比较后丢弃
+        {
+            std::lock_guard<std::mutex> lock(txMutex);
+            collectTx(now);
+        }
+        if (!txWriting.empty() && recording)
+            recording->Write_Uart(common::Chunk_Type::UART_TX, now, txWriting.data(), txWriting.size());
+        for (size_t i = 0; i + USB_FRAME_LENMIN <= txWriting.size() && txWriting[i + 2] >= USB_FRAME_LENMIN &&
+                           i + txWriting[i + 2] <= txWriting.size(); i += txWriting[i + 2]) {
+            uint8_t addr = txWriting[i + 1];
+            std::vector<uint8_t> frame(txWriting.begin() + i, txWriting.begin() + i + txWriting[i + 2]);
+            if (last[addr] == frame)
+                continue;
+            const std::vector<std::vector<uint8_t>> &frames = expected[addr];
+            size_t &k = matched[addr];
+            replayCompared.fetch_add(1, std::memory_order_relaxed);
+            if (k >= frames.size() || frames[k] != frame)
+                replayMismatches.fetch_add(1, std::memory_order_relaxed);
+            k++;
+            last[addr] = std::move(frame);
+        }
+        if (writingControl)
+            txStamp.store(now, std::memory_order_relaxed);
+        txOffset = txWriting.size();
+
+        // 等待至下一条接收消息、限速到期或心跳时间，最长1秒
+        int64_t deadline = txDeadline;
+        if (rxEnabled && next < rx.size())
+            deadline = std::min(deadline, std::min<int64_t>(rx[next].stamp_ns + offset, now + 10000000LL)); // 偏移可能变化，最长10ms重新计算
+        int timeout = 1000;
+        if (deadline != INT64_MAX) {
+            int64_t wait = deadline - common::Now_Ns();
+            timeout = wait <= 0 ? 0 : (int)std::min<int64_t>(1000, (wait + 999999) / 1000000);
+        }
+        pollfd pfd{eventFd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout) > 0) {
+            uint64_t count;
+            if (::read(eventFd, &count, sizeof(count)) < 0) {
+                // 已被读空，忽略
+            }
         }
     }
 }
 
 /**
  * @brief 串口通信协议数据转换
+ *
+ * @param msg 校验通过的消息
  */
-void Uart::dataTransform(void) {
-    switch (serialStr.buffFinish[1]) {
+void Uart::dataTransform(const Message &msg) {
+    if (recording)
+        recording->Write_Uart(common::Chunk_Type::UART_RX, msg.stamp, msg.buff, msg.length);
+
+    switch (msg.addr) {
     case USB_ADDR_KEY: // 接收按键信息
         keypress = true;
         break;
 
+    case USB_ADDR_ENCODER: // 编码器测速
+        if (msg.length == common::protocol::Encoder::LENGTH &&
+            common::protocol::Encoder::Decode(msg.buff, rxTelemetry.speed,
+                                              rxTelemetry.pulses)) {
+            rxTelemetry.encoderStamp = msg.stamp;
+            telemetryBox.Store(rxTelemetry);
+        }
+        break;
+
+    case USB_ADDR_IMU: // IMU
+        if (msg.length == common::protocol::Imu::LENGTH &&
+            common::protocol::Imu::Decode(msg.buff, rxTelemetry.yawRate,
+                                          rxTelemetry.accX, rxTelemetry.accY)) {
+            rxTelemetry.imuStamp = msg.stamp;
+            telemetryBox.Store(rxTelemetry);
+        }
+        break;
+
     default:
         break;
     }
+    if (rxSubscribed.load(std::memory_order_acquire) && !rxQueue.Push(msg))
+        rxDropped.fetch_add(1, std::memory_order_relaxed);
 }
 
 /**
@@ -220,33 +615,8 @@ void Uart::dataTransform(void) {
  * @param servo 方向：PWM（500~2500）
  */
 void Uart::carControl(float speed, uint16_t servo) {
-    if (!isOpen)
-        return;
-
-    uint8_t buff[11];  // 多发送一个字节
-    uint8_t check = 0; // 校验位
-    Bit32Union bit32U;
-    Bit16Union bit16U;
-
-    buff[0] = USB_FRAME_HEAD;   // 通信帧头
-    buff[1] = USB_ADDR_CARCTRL; // 地址
-    buff[2] = 10;               // 帧长
-
-    bit32U.float32 = speed; // X轴线速度
-    for (int i = 0; i < 4; i++)
-        buff[i + 3] = bit32U.buff[i];
-
-    bit16U.uint16 = servo; // Y轴线速度
-    buff[7] = bit16U.buff[0];
-    buff[8] = bit16U.buff[1];
-
-    for (int i = 0; i < 9; i++)
-        check += buff[i];
-    buff[9] = check; // 校验位
-
-    // 循环发送数据
-    for (size_t i = 0; i < 11; i++)
-        transmitByte(buff[i]);
+    // 整帧提交，由IO线程一次写出
+    send<common::protocol::Car_Control>(speed, servo);
 }
 
 /**
@@ -255,37 +625,6 @@ void Uart::carControl(float speed, uint16_t servo) {
  * @param sound
  */
 void Uart::buzzerSound(Buzzer sound) {
-    if (!isOpen)
-        return;
-    uint8_t buff[6];   // 多发送一个字节
-    uint8_t check = 0; // 校验位
-
-    buff[0] = USB_FRAME_HEAD;  // 帧头
-    buff[1] = USB_ADDR_BUZZER; // 地址
-    buff[2] = 5;               // 帧长
-    switch (sound) {
-    case Buzzer::BUZZER_OK: // 确认
-        buff[3] = 1;
-        break;
-    case Buzzer::BUZZER_WARNNING: // 报警
-        buff[3] = 2;
-        break;
-    case Buzzer::BUZZER_FINISH: // 完成
-        buff[3] = 3;
-        break;
-    case Buzzer::BUZZER_DING: // 提示
-        buff[3] = 4;
-        break;
-    case Buzzer::BUZZER_START: // 开机
-        buff[3] = 5;
-        break;
-    }
-
-    for (size_t i = 0; i < 4; i++)
-        check += buff[i];
-    buff[4] = check;
-
-    // 循环发送数据
-    for (size_t i = 0; i < 6; i++)
-        transmitByte(buff[i]);
+    // 音效编号：确认1、报警2、完成3、提示4、开机5
+    send<common::protocol::Buzzer_Sound>(static_cast<uint8_t>(sound + 1));
 }
@@ -105,122 +105,193 @@ vector<POINT> Center_Compute(vector<POINT> points_edge,int side,Tracking& tracki
     return center_v;
 }
 
-void ControlCenter::Fitting(Tracking& tracking,Element& element)
+ControlCenter::ControlCenter()
 {
-    _sigma_center = 0;
-    _control_center = tracking.Get_Width() / 2;
-    _center_edge.clear();
-    vector<POINT> v_center(4);
-    _style = "STRAIGHT";
-
-    // ========================================================== 计算赛贝尔曲线控制点 ==========================================================
-    // 双边情况
-    if(tracking.Get_Edge_Left().size() > 20 && tracking.Get_Edge_Right().size() > 20
-        && tracking.Get_Lost_Left().size() < 15 && tracking.Get_Lost_Right().size() < 15)
+    _fit_order = _parameter.Get_Parameter("Fit_Order").get<int>();
+    _look_ahead = _parameter.Get_Parameter("Fit_Look_Ahead").get<int>();
+    _border = _parameter.Get_Parameter("Border").get<int>();
+    _fit_order = max(2, min(3, _fit_order));
+    _control_center = _parameter.Get_Parameter("Image_Width").get<int>() / 2;
+}
 
+/**
+ * @brief 求解加权最小二乘法方程
+ * @param sum_u Σw·u^k，k = 0..2*order
+ * @param sum_xu Σw·x·u^k，k = 0..order
+ * @param order 拟合阶数
+ * @return 是否求解成功（矩阵非奇异）
+ */
+bool ControlCenter::Solve_Fit(const double* sum_u, const double* sum_xu, int order)
+{
+    int n = order + 1;
+    double m[4][5];
+    for(int r = 0; r < n; r++)
     {
-        //起点位置中心点
-        v_center[0] = {
-            (element._left_line[0].x + element._right_line[0].x) / 2,
-            (element._left_line[0].y + element._right_line[0].y) / 2};
-        //1/3位置中心点
-        v_center[1] = {
-            (element._left_line[element._left_line.size() / 3].x + element._right_line[element._right_line.size() / 3].x) / 2,
-            (element._left_line[element._left_line.size() / 3].y + element._right_line[element._right_line.size() / 3].y) / 2};
-        //2/3位置中心点
-        v_center[2] = {
-            (element._left_line[element._left_line.size() * 2 / 3].x + element._right_line[element._right_line.size() * 2 / 3].x) / 2,
-            (element._left_line[element._left_line.size() * 2 / 3].y + element._right_line[element._right_line.size() * 2 / 3].y) / 2};
-        //90%位置中心点
-        v_center[3] = {
-            (element._left_line[element._left_line.size() * 9 / 10].x + element._right_line[element._right_line.size() * 9 / 10].x) / 2,
-            (element._left_line[element._left_line.size() * 9 / 10].y + element._right_line[element._right_line.size() * 9 / 10].y) / 2};
-        
-        //使用贝塞尔曲线拟合平滑中心线，步长0.03表示曲线平滑度
-        _center_edge = Bazier(0.03,v_center);
-        _style = "STRAIGHT";
-    }
-    // // 左单边情况
-    // else if(tracking.Get_Edge_Left().size() > 20 && tracking.Get_Lost_Left().size() < 10
-    //     && tracking.Get_Edge_Right().size() < 20 && tracking.Get_Lost_Right().size() > 10
-    // {
-    // }
-    //左单边情况
-    // else if(tracking.Get_Lost_Right() > 10 && tracking.Get_Lost_Left() < 10)
-    // {
-
-    // }
-    // //右单边情况
-    // else if()
-    // {
-
-    // }
-    else    //暂时都以双边策略
-    {
-        //起点位置中心点
-        v_center[0] = {
-            (element._left_line[0].x + element._right_line[0].x) / 2,
-            (element._left_line[0].y + element._right_line[0].y) / 2};
-        //1/3位置中心点
-        v_center[1] = {
-            (element._left_line[element._left_line.size() / 3].x + element._right_line[element._right_line.size() / 3].x) / 2,
-            (element._left_line[element._left_line.size() / 3].y + element._right_line[element._right_line.size() / 3].y) / 2};
-        //2/3位置中心点
-        v_center[2] = {
-            (element._left_line[element._left_line.size() * 2 / 3].x + element._right_line[element._right_line.size() * 2 / 3].x) / 2,
-            (element._left_line[element._left_line.size() * 2 / 3].y + element._right_line[element._right_line.size() * 2 / 3].y) / 2};
-        //90%位置中心点
-        v_center[3] = {
-            (element._left_line[element._left_line.size() * 9 / 10].x + element._right_line[element._right_line.size() * 9 / 10].x) / 2,
-            (element._left_line[element._left_line.size() * 9 / 10].y + element._right_line[element._right_line.size() * 9 / 10].y) / 2};
-        
-        //使用贝塞尔曲线拟合平滑中心线，步长0.03表示曲线平滑度
-        _center_edge = Bazier(0.03,v_center);
-        _style = "STRAIGHT";
+        for(int c = 0; c < n; c++)
+            m[r][c] = sum_u[r + c];
+        m[r][n] = sum_xu[r];
     }
-
-    // ========================================================== 加权控制中心算法 ==========================================================
-    int control_num = 1;    // 权重累加器(关注远端)
-    for(auto p:_center_edge)
+    // 列主元高斯消元
+    for(int c = 0; c < n; c++)
     {
-        if(p.y < tracking.Get_Height() / 2) //在图像上半部分
+        int pivot = c;
+        for(int r = c + 1; r < n; r++)
+        {
+            if(fabs(m[r][c]) > fabs(m[pivot][c]))
+                pivot = r;
+        }
+        if(fabs(m[pivot][c]) < 1e-9)
+            return false;
+        if(pivot != c)
         {
-            control_num += tracking.Get_Height() / 2;
-            _control_center += p.x * tracking.Get_Height() / 2;
+            for(int k = c; k <= n; k++)
+                swap(m[c][k], m[pivot][k]);
         }
-        else    //在图像下半部分
+        for(int r = c + 1; r < n; r++)
         {
-            control_num += tracking.Get_Height() - p.y; //权重为距底部的距离
-            _control_center += p.x * (tracking.Get_Height() - p.y);
+            double f = m[r][c] / m[c][c];
+            for(int k = c; k <= n; k++)
+                m[r][k] -= f * m[c][k];
         }
     }
-    //计算加权平均值
-    if(control_num > 0)
+    for(int r = n - 1; r >= 0; r--)
     {
-        _control_center = _control_center / control_num;
+        double v = m[r][n];
+        for(int k = r + 1; k < n; k++)
+            v -= m[r][k] * _fit_coef[k];
+        _fit_coef[r] = v / m[r][r];
     }
-    if(_control_center > tracking.Get_Width())
+    for(int k = n; k < 4; k++)
+        _fit_coef[k] = 0;
+    return true;
+}
+
+/**
+ * @brief 拟合曲线横坐标
+ * @param s 距图像底部的行数
+ */
+double ControlCenter::Fit_X(double s) const
+{
+    double u = s / _fit_scale;
+    return _fit_coef[0] + u * (_fit_coef[1] + u * (_fit_coef[2] + u * _fit_coef[3]));
+}
+
+/**
+ * @brief 拟合曲线斜率 dx/ds
+ * @param s 距图像底部的行数
+ */
+double ControlCenter::Fit_Slope(double s) const
+{
+    double u = s / _fit_scale;
+    return (_fit_coef[1] + u * (2 * _fit_coef[2] + u * 3 * _fit_coef[3])) / _fit_scale;
+}
+
+/**
+ * @brief 拟合曲线曲率（带符号，向右弯为正）
+ * @param s 距图像底部的行数
+ */
+double ControlCenter::Fit_Curvature(double s) const
+{
+    double u = s / _fit_scale;
+    double d1 = Fit_Slope(s);
+    double d2 = (2 * _fit_coef[2] + 6 * _fit_coef[3] * u) / (_fit_scale * _fit_scale);
+    double q = 1 + d1 * d1;
+    return d2 / (q * sqrt(q));
+}
+
+/**
+ * @brief 中心线拟合
+ *
+ * 对所有有效中心行做加权多项式最小二乘拟合 x = f(s)，s为距图像底部的行数。
+ * 一次遍历累加 Σw·u^k、Σw·x·u^k、Σw·x^2，闭式求解系数，
+ * 残差由 Σw·x^2 - a·b 直接得到，不再对曲线二次遍历求方差。
+ */
+void ControlCenter::Fitting(Tracking& tracking,Element& element)
+{
+    NS_PROFILE(Fitting);
+    int width = tracking.Get_Width();
+    int height = tracking.Get_Height();
+    _sigma_center = 1000;
+    _control_center = width / 2;
+    _lateral_offset = 0;
+    _heading = 0;
+    _curvature = 0;
+    _fit_valid = false;
+    _fit_scale = height;
+    _center_edge.clear();
+    _style = "STRAIGHT";
+
+    // ========================================================== 累加加权和 ==========================================================
+    double sum_u[7] = {0, 0, 0, 0, 0, 0, 0};   // Σw·u^k
+    double sum_xu[4] = {0, 0, 0, 0};           // Σw·x·u^k
+    double sum_xx = 0;                         // Σw·x^2
+    int count = 0;
+    _fit_s_min = height;
+    _fit_s_max = 0;
+
+    size_t rows = min(element._left_line.size(), element._right_line.size());
+    for(size_t i = 0; i < rows; i++)
     {
-        _control_center = tracking.Get_Width() - 1;
+        bool left_lost = element._left_line[i].x <= _border;
+        bool right_lost = element._right_line[i].x >= width - _border - 1;
+        if(left_lost && right_lost)     // 双边丢线，中心点不可信
+            continue;
+        // 单边丢线时中心点偏差较大，降低权重
+        double w = (left_lost || right_lost) ? 0.5 : 1.0;
+        double x = (element._left_line[i].x + element._right_line[i].x) * 0.5;
+        double s = height - 1 - element._left_line[i].y;
+        double u = s / _fit_scale;
+
+        double p = w;
+        for(int k = 0; k <= 2 * _fit_order; k++)
+        {
+            sum_u[k] += p;
+            if(k <= _fit_order)
+                sum_xu[k] += p * x;
+            p *= u;
+        }
+        sum_xx += w * x * x;
+        _fit_s_min = min(_fit_s_min, s);
+        _fit_s_max = max(_fit_s_max, s);
+        count++;
     }
-    else if(_control_center < 0)
+
+    // ========================================================== 闭式求解 ==========================================================
+    int order = _fit_order;
+    while(order >= 1 && (count <= order || !Solve_Fit(sum_u, sum_xu, order)))
+        order--;     // 点数不足或矩阵奇异，降阶
+    if(order < 1)
+        return;
+    _fit_valid = true;
+
+    // 残差：Σw(x - f)^2 = Σw·x^2 - a·b
+    double ssr = sum_xx;
+    for(int k = 0; k <= order; k++)
+        ssr -= _fit_coef[k] * sum_xu[k];
+    _sigma_center = max(0.0, ssr / sum_u[0]);
+
+    // ========================================================== 前瞻点输出 ==========================================================
+    // 不外推到观测范围之外
+    double s_look = max(_fit_s_min, min<double>(_look_ahead, _fit_s_max));
+    double x_look = Fit_X(s_look);
+    _lateral_offset = x_look - width / 2.0;
+    _heading = Fit_Slope(s_look);
+    _curvature = Fit_Curvature(s_look);
+    _style = fabs(_curvature) < 1e-3 ? "STRAIGHT" : "CURVE";
+    _control_center = static_cast<int>(lround(x_look));
+    if(_control_center >= width)
     {
-        _control_center = 0;
+        _control_center = width - 1;
     }
-    // 评估路径平滑度
-    if(_center_edge.size() > 20)
+    else if(_control_center < 0)
     {
-        vector<POINT> center_v;
-        int filt = _center_edge.size() / 5; //过滤前后1/5的点
-        for(size_t i = filt; i < _center_edge.size() - filt; i++)
-        {
-            center_v.push_back(_center_edge[i]);
-        }
-        _sigma_center = Variance<POINT,vector<POINT>>(center_v,Point_Avg,Point_Ddot);
+        _control_center = 0;
     }
-    else
+
+    // 按行采样拟合曲线，用于显示和速度决策
+    for(double s = _fit_s_min; s <= _fit_s_max; s += 4)
     {
-        _sigma_center = 1000;
+        _center_edge.emplace_back(static_cast<int>(lround(Fit_X(s))), static_cast<int>(height - 1 - s));
     }
 }
 
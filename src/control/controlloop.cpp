@@ -0,0 +1,228 @@
+#include "control/controlloop.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <iomanip>
+#include <sstream>
+
+using namespace common;
+using namespace std;
+
+namespace control{
+
+ControlLoop::ControlLoop(shared_ptr<Uart> uart)
+    : _uart(uart)
+{
+    _control_rate = _parameter.Get_Parameter("Control_Rate").get<int>();
+    _control_timeout = _parameter.Get_Parameter("Control_Timeout").get<int>();
+    _latency_compensation = _parameter.Get_Parameter("Latency_Compensation").get<bool>();
+    _pixels_per_meter = _parameter.Get_Parameter("Pixels_Per_Meter").get<float>();
+    _telemetry_timeout = _parameter.Get_Parameter("Telemetry_Timeout").get<int>();
+    if(_control_rate <= 0)
+        _control_rate = 200;
+    if(_uart)
+    {
+        _uart->setMaxRate(_parameter.Get_Parameter("Uart_Max_Rate").get<int>());
+        _uart->setHeartbeat(_parameter.Get_Parameter("Uart_Heartbeat").get<int>());
+    }
+}
+
+ControlLoop::~ControlLoop()
+{
+    Stop();
+}
+
+/**
+ * @brief 启动控制线程
+ */
+void ControlLoop::Start()
+{
+    if(_running.exchange(true))
+        return;
+    _thread = thread(&ControlLoop::Loop, this);
+
+    // 尝试提升为实时调度，权限不足时保持普通调度
+    sched_param param;
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    if(pthread_setschedparam(_thread.native_handle(), SCHED_FIFO, &param) != 0)
+    {
+        NS_LOG_WARN("控制线程实时调度设置失败，使用普通调度");
+    }
+}
+
+/**
+ * @brief 停止控制线程
+ */
+void ControlLoop::Stop()
+{
+    if(!_running.exchange(false))
+        return;
+    if(_thread.joinable())
+        _thread.join();
+    Log_Latency();
+}
+
+/**
+ * @brief 输出采集到执行的延迟分布
+ */
+void ControlLoop::Log_Latency()
+{
+    if(_latency.Count() == 0)
+        return;
+    ostringstream ss;
+    ss << fixed << setprecision(2);
+    ss << "=== 采集到执行延迟 (" << _latency.Count() << "次) ===" << endl;
+    ss << "平均: " << _latency.Mean() / 1e6 << " ms" << endl;
+    ss << "P50: " << _latency.Percentile(50) / 1e6 << " ms" << endl;
+    ss << "P90: " << _latency.Percentile(90) / 1e6 << " ms" << endl;
+    ss << "P99: " << _latency.Percentile(99) / 1e6 << " ms" << endl;
+    ss << "最大: " << _latency.Max() / 1e6 << " ms" << endl;
+    ss << "串口写出耗时估计: " << _tx_delay_ns.load(memory_order_relaxed) / 1e6 << " ms" << endl;
+    if(_uart)
+    {
+        ss << "串口链路占用: " << _uart->linkUtilisation() * 100 << " %" << endl;
+        ss << "串口指令 覆盖: " << _uart->coalescedFrames() << " 省略: " << _uart->unchangedFrames()
+           << " 心跳: " << _uart->heartbeatFrames() << " 丢弃: " << _uart->droppedFrames() << endl;
+        ss << "串口接收 错误帧: " << _uart->frameErrors() << " 丢弃消息: " << _uart->droppedMessages() << endl;
+    }
+    ss << "=================================" << endl;
+    debug.log_text(ss.str());
+}
+
+/**
+ * @brief 统计上一条指令的采集到执行延迟
+ * @param now 当前时间（纳秒）
+ *
+ * 串口写出时间由Uart记录；未启用串口时以指令计算完成时刻作为执行时间。
+ */
+void ControlLoop::Record_Latency(int64_t now)
+{
+    if(_issue_capture_ns == 0)
+        return;
+    int64_t tx_ns = _uart ? _uart->lastTxNs() : now;
+    if(tx_ns == 0 || tx_ns == _tx_seen_ns || tx_ns < _issue_ns)
+        return;
+    _tx_seen_ns = tx_ns;
+    _latency.Record(tx_ns - _issue_capture_ns);
+    // 写出耗时指数平均
+    int64_t delay = _tx_delay_ns.load(memory_order_relaxed);
+    _tx_delay_ns.store(delay + (tx_ns - _issue_ns - delay) / 8, memory_order_relaxed);
+}
+
+/**
+ * @brief 按实测延迟沿拟合中心线预测偏差
+ * @param now 当前时间（纳秒）
+ * @param speed 车速（m/s）
+ * @return 预测的执行时刻偏差（像素）
+ */
+float ControlLoop::Predict_Error(int64_t now, float speed) const
+{
+    const Vision_Target& t = _target_last;
+    // 预计执行时刻 = 当前时刻 + 串口写出耗时
+    double latency = (now + _tx_delay_ns.load(memory_order_relaxed) - t.capture_ns) * 1e-9;
+    double rows = max(0.0, speed * latency * _pixels_per_meter);
+    // 与ControlCenter::Fitting相同，不外推到观测范围之外
+    double s = max<double>(t.fit_s_min, min<double>(t.look_ahead + rows, t.fit_range));
+    double u = s / t.fit_scale;
+    double x = t.fit_coef[0] + u * (t.fit_coef[1] + u * (t.fit_coef[2] + u * t.fit_coef[3]));
+    return static_cast<float>(x - t.width / 2.0);
+}
+
+/**
+ * @brief 当前车速：编码器测速有效时取实测值，否则取指令速度
+ * @param now 当前时间（纳秒）
+ * @param command 指令速度（m/s）
+ * @return 车速（m/s）
+ */
+float ControlLoop::Measured_Speed(int64_t now, float command) const
+{
+    Uart::Telemetry telemetry;
+    if(_uart && _uart->telemetry(telemetry) && telemetry.encoderStamp != 0 &&
+       now - telemetry.encoderStamp < _telemetry_timeout * 1000000LL)
+        return telemetry.speed;
+    return command;
+}
+
+/**
+ * @brief 发布视觉结果
+ * @param target 视觉目标
+ */
+void ControlLoop::Publish(const Vision_Target& target)
+{
+    _mailbox.Store(target);
+}
+
+/**
+ * @brief 控制线程主循环，按绝对时间定时以避免累积漂移
+ */
+void ControlLoop::Loop()
+{
+    auto period = chrono::nanoseconds(1000000000LL / _control_rate);
+    auto next = chrono::steady_clock::now();
+    while(_running.load(memory_order_relaxed))
+    {
+        Control_Step(Now_Ns());
+        next += period;
+        auto now = chrono::steady_clock::now();
+        if(next < now)  // 超时，跳过错过的周期
+            next = now;
+        this_thread::sleep_until(next);
+    }
+}
+
+/**
+ * @brief 单个控制周期
+ * @param now 当前时间（纳秒）
+ */
+void ControlLoop::Control_Step(int64_t now)
+{
+    NS_PROFILE(Control);
+    // 读取新的视觉结果
+    uint32_t version = _mailbox.Version();
+    if(version != _version)
+    {
+        Vision_Target target;
+        if(_mailbox.Load(target))
+        {
+            _target_prev = _target_last;
+            _target_last = target;
+        }
+        _version = version;
+    }
+    Record_Latency(now);
+    if(_target_last.stamp_ns == 0)
+        return;
+
+    float speed = _target_last.speed;
+    float error = _target_last.error;
+    int64_t age = now - _target_last.stamp_ns;
+    if(age > _control_timeout * 1000000LL)
+    {
+        speed = 0;  // 视觉结果超时，停车
+    }
+    else if(_latency_compensation && _target_last.fit_valid && _target_last.capture_ns != 0)
+    {
+        error = Predict_Error(now, Measured_Speed(now, speed));
+    }
+    else if(_target_prev.stamp_ns != 0 && _target_last.frame_id == _target_prev.frame_id + 1)
+    {
+        // 用最近两帧线性外推，外推时长不超过一个帧间隔
+        int64_t interval = _target_last.stamp_ns - _target_prev.stamp_ns;
+        if(interval > 0)
+        {
+            int64_t horizon = min(age, interval);
+            error += (_target_last.error - _target_prev.error) * horizon / interval;
+        }
+    }
+
+    _motion.Pose_Control(error, _target_last.width);
+    _servo_pwm.store(_motion._servo_pwm, memory_order_relaxed);
+    _speed.store(speed, memory_order_relaxed);
+    _issue_ns = now;
+    _issue_capture_ns = _target_last.capture_ns;
+    if(_uart)
+    {
+        _uart->carControl(speed, _motion._servo_pwm);
+    }
+}
+
+}
@@ -39,19 +39,26 @@ Motion::~Motion()
 void Motion::Pose_Control(int control_center,Tracking& tracking)
 {
     int width = tracking.Get_Width();
-    //偏差计算
-    float error = control_center - width / 2; 
+    Pose_Control(control_center - width / 2.0f, width);
+}
+
+/**
+ * @brief 姿态控制
+ * @param error 控制中心相对图像中心的偏差（像素）
+ * @param width 图像宽度
+ */
+void Motion::Pose_Control(float error,int width)
+{
     //偏差平滑处理
-    static int error_last = 0;
-    if(abs(error - error_last) > width/10) //偏差过大,直接赋值
+    if(abs(error - _error_last) > width/10) //偏差过大,直接赋值
     {
-        error = error > error_last ? (error_last + width/10) : (error_last - width/10);
+        error = error > _error_last ? (_error_last + width/10) : (_error_last - width/10);
     }
     //自适应比例系数
     _turn_p = abs(error) * _run_p2 + _run_p3;
     //PD控制输出计算
-    int pwm_diff = (error * _turn_p) + (error - error_last) * _turn_d;
-    error_last = error;
+    int pwm_diff = (error * _turn_p) + (error - _error_last) * _turn_d;
+    _error_last = error;
     //PWM信号生成
     _servo_pwm = (uint16_t)(PWMSERVOMID + pwm_diff);
 }
@@ -62,65 +69,44 @@ void Motion::Pose_Control(int control_center,Tracking& tracking)
  * @param enable 是否启用加速摸索模式
  * @param slow_down 是否启用慢速模式
  * @param control_center 控制中心
- * @param tracking 跟踪器
+ * @param speed_cap 场景限速
  */
-void Motion::Speed_Control(bool enable,bool slow_down,ControlCenter& control_center,Tracking& tracking)
+void Motion::Speed_Control(bool enable,bool slow_down,ControlCenter& control_center,float speed_cap)
 {
-    uint8_t control_low = 0;    //速度控制下限
-    uint8_t control_mid = 5;    //速度控制中值
-    uint8_t control_high = 10;  //速度控制上限
-
-    // int width = tracking.Get_Width();  // 暂时注释掉未使用的变量
-    int height = tracking.Get_Height();
+    NS_PROFILE(Speed_Control);
     // =====================================慢速模式=====================================
     if(slow_down)
     {
-        _count_shift = control_low;
         _speed = _speed_down;
     }
     // =====================================正常模式=====================================
     else if(enable)
     {
-        if(control_center._center_edge.size() < 10) //赛道中心点数量过少,直接进入低速模式
-        {
-            _speed = _speed_low;
-            _count_shift = control_low;
-            return;
-        }
-        if(control_center._center_edge[control_center._center_edge.size() - 1].y > height / 2) //赛道中心点在图像下方,直接进入低速模式
-        {
-            _speed = _speed_low;
-            _count_shift = control_low;
-            return;
-        }
-        if(abs(control_center._sigma_center) < 100.0)   //路径平滑，加速
-        {
-            _count_shift ++;
-            if(_count_shift > control_high)
-            {
-                _count_shift = control_high;
-            }
-        }
-        else    //复杂路况减速
-        {
-            _count_shift --;
-            if(_count_shift < control_low)
-            {
-                _count_shift = control_low;
-            }
-        }
-
-        if(_count_shift > control_mid)
-            _speed = _speed_high;   //高速模式
-        else
-            _speed = _speed_low;   //低速模式
+        _speed = _planner.Plan(control_center, _speed_low, _speed_high);
     }
     // =====================================禁用加速摸索模式=====================================
     else
     {
-        _count_shift = control_low;
         _speed = _speed_low;
     }
+    _speed = min(_speed, speed_cap);
+}
+
+/**
+ * @brief 场景限速
+ * @param scene 场景名称
+ * @return 该场景允许的最高速度
+ */
+float Motion::Speed_Cap(const string& scene) const
+{
+    if(scene == "ZebraScene") return 0;
+    if(scene == "RingScene") return _speed_ring;
+    if(scene == "ObstacleScene") return _speed_obstacle;
+    if(scene == "BridgeScene") return _speed_bridge;
+    if(scene == "CateringScene") return _speed_catering;
+    if(scene == "LaybyScene") return _speed_layby;
+    if(scene == "ParkingScene") return _speed_parking;
+    return _speed_high;
 }
 
 
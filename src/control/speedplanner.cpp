@@ -0,0 +1,65 @@
+#include "control/speedplanner.hpp"
+
+using namespace common;
+using namespace std;
+
+namespace control{
+
+SpeedPlanner::SpeedPlanner()
+{
+    _lateral_acc_max = _parameter.Get_Parameter("Lateral_Acc_Max").get<float>();
+    _brake_acc_max = _parameter.Get_Parameter("Brake_Acc_Max").get<float>();
+    _pixels_per_meter = _parameter.Get_Parameter("Pixels_Per_Meter").get<float>();
+    if(_pixels_per_meter <= 0)
+        _pixels_per_meter = 100;
+    for(int i = 0; i < SPEED_PLAN_SAMPLES; i++)
+        _profile[i] = 0;
+}
+
+/**
+ * @brief 规划目标速度
+ * @param control_center 控制中心（提供中心线拟合结果）
+ * @param speed_min 最低速度
+ * @param speed_max 最高速度
+ * @return 目标速度
+ */
+float SpeedPlanner::Plan(const ControlCenter& control_center, float speed_min, float speed_max)
+{
+    const int n = SPEED_PLAN_SAMPLES;
+    _curvature_max = 0;
+    // 只在拟合观测到的范围内采样，底部丢线时不使用外推的曲率
+    double s_min = control_center.Fit_S_Min();
+    double range = control_center.Fit_Range() - s_min;
+    // 拟合无效或可见距离过短，直接低速
+    if(!control_center.Fit_Valid() || range < n)
+    {
+        for(int i = 0; i < n; i++)
+            _profile[i] = speed_min;
+        return speed_min;
+    }
+
+    double ds = range / (n - 1);                // 采样间距（行）
+    double ds_m = ds / _pixels_per_meter;       // 采样间距（米）
+    double brake = 2 * _brake_acc_max * ds_m;
+
+    // 各采样点的曲率限速
+    for(int i = 0; i < n; i++)
+    {
+        double k = fabs(control_center.Fit_Curvature(s_min + i * ds)) * _pixels_per_meter;
+        _curvature_max = max<float>(_curvature_max, k);
+        double v = k > 1e-6 ? sqrt(_lateral_acc_max / k) : speed_max;
+        _profile[i] = static_cast<float>(min<double>(v, speed_max));
+    }
+    // 可见范围之外路况未知，须能在末端降至最低速
+    _profile[n - 1] = min(_profile[n - 1], speed_min);
+
+    // 由远及近按制动能力反向递推
+    for(int i = n - 2; i >= 0; i--)
+    {
+        double v_next = _profile[i + 1];
+        _profile[i] = static_cast<float>(min<double>(_profile[i], sqrt(v_next * v_next + brake)));
+    }
+    return max(speed_min, min(speed_max, _profile[0]));
+}
+
+}
@@ -2,9 +2,12 @@
 #include "control.hpp"      //运动控制
 #include "common.hpp"       //通用库
 #include "task.hpp"
+#include "task/pipeline.hpp"
 #include "opencv2/opencv.hpp"
 #include <thread>   //多线程库，提供多线程支持
 #include <chrono>   //时间库，提供时间支持
+#include <fstream>
+#include <iterator>
 
 using namespace common;
 using namespace recognition;
@@ -18,25 +21,48 @@ int main()
     // ========================================== 构造对象 ==========================================
     // 创建对象
 
-    Tracking tracker;   //创建巡线对象
-    Element element;    //创建元素对象
+    Pipeline pipeline;  //视觉处理流水线（巡线、元素、控制中心、速度规划）
+    Tracking& tracker = pipeline._tracker;
+    Element& element = pipeline._element;
+    ControlCenter& control_center = pipeline._control_center;
+    Motion& motion = pipeline._motion;
     Display display;    //创建显示对象
-    ControlCenter control_center; //创建控制中心对象
-    Motion motion;       //创建运动对象
+    FramePublisher publisher;   //共享内存帧发布对象
+    FlightRecorder recorder(Parameter().Get_Parameter("Flight_Records").get<int>());  //飞行记录仪
     int motion_cnt = 0;  // 暂时注释掉未使用的变量
     
     shared_ptr<Uart> uart = nullptr;
+    shared_ptr<RecordingWriter> recording = nullptr;   //运行录制
     int ret;
 
     bool is_paused = false; //暂停状态
-    string scene = "ZebraScene";
-    float middle_error = 0;
+
+    // ========================================== 初始化录制 ==========================================
+    string recording_path = Parameter().Get_Parameter("Recording_Path").get<string>();
+    if(!recording_path.empty())
+    {
+        ifstream config_file(Parameter().Get_Config_Path());
+        string config((istreambuf_iterator<char>(config_file)), istreambuf_iterator<char>());
+        recording = make_shared<RecordingWriter>();
+        if(recording->Open(recording_path, config))
+        {
+            tracker._camera.Attach_Recording(recording);
+            debug.force_outputln("运行录制: " + recording_path);
+        }
+        else
+            recording = nullptr;
+    }
 
     // ========================================== 初始化串口 ==========================================
     if(motion._motion_enable)
     {
         uart = make_shared<Uart>("/dev/ttyUSB0");
-        ret = uart->open();
+        if(recording)
+            uart->attachRecording(recording);
+        if(tracker._camera._debug_mode == "recording")
+            ret = uart->openReplay(tracker._camera.Get_Recording());   //串口收发由录制代替
+        else
+            ret = uart->open();
         if(ret != 0)
         {
             debug.force_outputln("串口打开失败");
@@ -44,6 +70,12 @@ int main()
         }
         uart->startReceive();   //启动串口接收线程
     }
+    ControlLoop control_loop(uart);  //创建定频控制线程对象
+    if(Parameter().Get_Parameter("Perf_Counters").get<bool>() && Perf_Counters::Enable(true))
+        debug.force_outputln("硬件计数器已开启");
+    string trace = Parameter().Get_Parameter("Profile_Trace").get<string>();
+    if(!trace.empty() && !Profiler::Global().Start_Trace(trace))
+        debug.force_outputln("性能追踪文件打开失败: " + trace);
     // ========================================== 初始化摄像头及窗口 ==========================================
     // 检查摄像头初始化状态
     if(!tracker._camera.Is_Initialized())
@@ -56,27 +88,37 @@ int main()
     // 显示摄像头信息
     tracker._camera.Print_Camera_Info();
     // 创建多窗口显示系统
-    display.add_window(0, "原始图像");
-    display.add_window(1, "二值化图像");
-    display.add_window(2, "巡线路径");
+    if(Parameter().Get_Parameter("Shm_Publish").get<bool>())
+    {
+        Parameter parameter;
+        if(publisher.Open(parameter.Get_Parameter("Image_Width").get<int>(), parameter.Get_Parameter("Image_Height").get<int>()))
+            debug.force_outputln("图像发布到共享内存 " SHM_NAME "，使用ns_viewer查看");
+    }
+    if(Is_Headless())
+    {
+        debug.force_outputln("无界面模式：输入 空格(暂停/继续) s(保存) d(保存飞行记录) q(退出) 后回车");
+    }
+    else
+    {
+        display.add_window(0, "原始图像");
+        display.add_window(1, "二值化图像");
+        display.add_window(2, "巡线路径");
+    }
 
     // ========================================== 运动控制初始化 ==========================================
     if(motion._motion_enable)
     {
         debug.force_outputln("运动控制已启用,等待按键发车");
         uart -> buzzerSound(uart -> BUZZER_OK);
+        uart -> carControl(0,PWMSERVOMID);  //停车指令，由串口心跳保活
         while(!uart -> keypress)
-            waitKey(300);
-        while(ret < 10)
-        {
-            uart -> carControl(0,PWMSERVOMID);
-            waitKey(300);
-            ret ++;
-        }
+            this_thread::sleep_for(chrono::milliseconds(300));
         uart -> keypress = false;
         uart -> buzzerSound(uart -> BUZZER_START);
         debug.force_outputln("发车成功");
     }
+    recorder.Install_Signal_Handlers();    //异常退出时保存飞行记录
+    control_loop.Start();   //启动控制线程，姿态控制与串口下发在其中定频执行
 
     // ========================================== 主循环 ==========================================
     while(true)
@@ -86,49 +128,12 @@ int main()
         if(!is_paused)        // 只有在非暂停状态下才进行图像处理
         {
             debug.start_processing();   // 开始图像处理计时
-            if(!tracker._camera.Capture())   // 捕获图像
+            NS_PROFILE(Frame);          // 分阶段统计：整帧处理
+            if(!pipeline.Process())     // 采集、巡线、元素识别及中心线拟合
             {
-                debug.force_outputln("图像捕获失败，跳过此帧");
+                NS_LOG_WARN("图像捕获失败，跳过此帧");
                 continue;
             }
-            tracker.Picture_Process();   // 图像处理
-            tracker._camera.Get_Frame();
-            tracker._camera.Get_Binary_Frame();
-            // ========================================== 赛道巡线获取控制点信息 ==========================================
-            tracker.Track_Recognition(); // 巡线识别
-            tracker.Edge_Extract(); // 边缘提取
-            switch(element.Recognition_Element(tracker))    // 元素识别
-            {
-                case recognition::Scene::ZebraScene:
-                    element._zebra_cnt ++;
-                    if(element._zebra_cnt >= 5)//连着5帧为斑马线再确定
-                    {
-                        scene = "ZebraScene";
-                        element._zebra_cnt = 0;
-                        element._zebra_flag = true;
-                        debug.force_outputln("检测到场景：斑马线 "+to_string(debug.get_frame_count()));
-                    }
-                    break;
-                    scene = "RingScene";
-                    element._ring_flag = true;
-                    debug.force_outputln("检测到场景：环岛"+to_string(debug.get_frame_count()));
-                    break;
-                case recognition::Scene::ObstacleScene:
-                    scene = "ObstacleScene";
-                    element._obstaclee_flag = true;
-                    debug.force_outputln("检测到场景：障碍物 "+to_string(debug.get_frame_count()));
-                    break;
-                case recognition::Scene::BridgeScene:
-                case recognition::Scene::CateringScene:
-                case recognition::Scene::LaybyScene:
-                case recognition::Scene::ParkingScene:
-                case recognition::Scene::NolmalScene:
-                default: scene = "NormalScene";
-                    // 这些场景暂时不处理
-                    break;
-            }
-            middle_error = element.Get_Middle_Error(tracker);  // 补线及拟合中心线
-            control_center.Fitting(tracker,element); // 拟合中心线
             Show_Draw_Line_Task(tracker,element,control_center);
             debug.end_processing();   // 结束图像处理计时
         }
@@ -136,26 +141,55 @@ int main()
         // ========================================== 运动控制 ==========================================
         if(motion_cnt > 30)
         {
-            if(scene == "ZebraScene") motion._speed = 0;
-            else if(scene == "RingScene") motion._speed = motion._speed_ring;
-            else if(scene == "ObstacleScene") motion._speed = motion._speed_obstacle;
-            else motion.Speed_Control(true,false,control_center,tracker);
-            motion.Pose_Control(control_center._control_center,tracker);    // 姿态控制
-            if(motion._motion_enable)
-            {
-                uart -> carControl(motion._speed,motion._servo_pwm);    // 发送速度和舵机PWM
-            }
+            pipeline.Speed_Control();
+            // 发布视觉结果，由控制线程完成姿态控制并发送速度和舵机PWM
+            Vision_Target target = pipeline.Target();
+            target.frame_id = debug.get_frame_count();
+            control_loop.Publish(target);
+            motion._servo_pwm = control_loop.Get_Servo_Pwm();   // 显示用
         }
         else
             motion_cnt ++;
 
         // ========================================== 图像显示 ==========================================
-        char key = cv::waitKey(1);
-        Show_Windows_Task(tracker, scene, motion, control_center, display, key, is_paused);
+        char key = Is_Headless() ? Headless_Key_Task(uart) : static_cast<char>(cv::waitKey(1));
+        if(!is_paused)
+            Flight_Record_Task(recorder, tracker, control_center, motion, uart, pipeline._scene, pipeline._middle_error);
+        if(publisher.Is_Open() && !is_paused)
+            Publish_Frame_Task(publisher, tracker, element, control_center, motion, pipeline._scene);
+        Show_Windows_Task(tracker, pipeline._scene, motion, control_center, display, key, is_paused);
+        if(debug.should_log_performance())
+        {
+            control_loop.Log_Latency();
+            debug.log_text(Profiler::Global().Report());
+            Profiler::Global().Flush_Trace();
+        }
+        if(key == 'd' || key == 'D')
+        {
+            string path;
+            debug.force_outputln(string(recorder.Snapshot(path) ? "飞行记录已保存：" : "飞行记录保存失败：") + path);
+        }
+        if(key == 'q' || key == 'Q')
+            break;
     }
 
     //释放资源
-    cv::destroyAllWindows();
+    control_loop.Stop();
+    debug.log_text(Profiler::Global().Report());
+    Profiler::Global().Stop_Trace();
+    string flight_path;
+    if(recorder.Snapshot(flight_path))
+        debug.force_outputln("飞行记录已保存：" + flight_path);
+    if(recording)
+    {
+        if(uart)
+            uart->close();  //停车指令写入录制后再关闭
+        recording->Close();
+        debug.force_outputln("运行录制已保存：" + recording->Path() + "，" + to_string(recording->Chunks()) +
+                             " 个数据块，丢弃 " + to_string(recording->Dropped()) + " 个");
+    }
+    if(!Is_Headless())
+        cv::destroyAllWindows();
     return 0;
 }
 
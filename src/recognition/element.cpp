@@ -29,6 +29,7 @@ Element::~Element()
 
 Scene Element::Recognition_Element(Tracking &tracking)
 {   
+    NS_PROFILE(Recognition_Element);
     //清除标志位
     scene = Scene::NolmalScene;
 
@@ -42,9 +43,6 @@ Scene Element::Recognition_Element(Tracking &tracking)
     // uint8_t obstacle_flag = 0;//障碍物识别标志
 
     uint8_t ring_cnt[4] = {0,0,0,0};//环岛计数
-    static uint8_t ring_left_cnt[2] = {0,0};//环岛左计数
-    static uint8_t ring_right_cnt[2] = {0,0};//环岛右计数
-    static uint8_t ring_frame_cnt = 0;//环岛帧计数
 
     // 更新补线信息
     _crossroad_left_line.clear();
@@ -186,23 +184,23 @@ Scene Element::Recognition_Element(Tracking &tracking)
         if(obstacle_cnt[2] > 0) // 左障碍物
         {
             // 计算贝塞尔控制点
-            vector<POINT> left_bezier(3);
+            POINT left_bezier[3];
             left_bezier[0] = tracking.Get_Edge_Left()[2];   //起点
             left_bezier[1] = {
                 (tracking.Get_Edge_Left()[2].x + tracking.Get_Corner(LEFT_UP).x)* 2 / 3,   // 偏右1/3点
                 (tracking.Get_Edge_Left()[2].y + tracking.Get_Corner(LEFT_UP).y) / 2};
             left_bezier[2] = tracking.Get_Corner(LEFT_UP);  //终点
-            _obstacle_left_line = Bazier(1.0f / abs(left_bezier[0].y - left_bezier[2].y),left_bezier);
+            Bazier(1.0f / abs(left_bezier[0].y - left_bezier[2].y), left_bezier, 3, _obstacle_left_line);
         }
         if(obstacle_cnt[3] > 0) // 右障碍物
         {
-            vector<POINT> right_bezier(3);
+            POINT right_bezier[3];
             right_bezier[0] = tracking.Get_Edge_Right()[2];   //起点
             right_bezier[1] = {
                 (tracking.Get_Edge_Right()[2].x + tracking.Get_Corner(RIGHT_UP).x) / 3,   // 偏左1/3点
                 (tracking.Get_Edge_Right()[2].y + tracking.Get_Corner(RIGHT_UP).y) / 2};
             right_bezier[2] = tracking.Get_Corner(RIGHT_UP);  //终点
-            _obstacle_right_line = Bazier(1.0f / abs(right_bezier[0].y - right_bezier[2].y),right_bezier);
+            Bazier(1.0f / abs(right_bezier[0].y - right_bezier[2].y), right_bezier, 3, _obstacle_right_line);
         }
         // 如果任一边检测到障碍物，返回障碍物场景
         if(obstacle_cnt[2] > 0 || obstacle_cnt[3] > 0)
@@ -233,82 +231,82 @@ Scene Element::Recognition_Element(Tracking &tracking)
         {
             if(tracking.Get_Corner(LEFT_DOWN).y > 20 && tracking.Get_Corner(RIGHT_DOWN).y < 20)
             {
-                ring_left_cnt[0]++;
+                _ring_left_cnt[0]++;
             }
         }
         if(ring_cnt[2] > 0)
         {
             if(tracking.Get_Corner(RIGHT_DOWN).y > 20 && tracking.Get_Corner(LEFT_DOWN).y < 20)
             {
-                ring_right_cnt[0]++;
+                _ring_right_cnt[0]++;
             }
         }
-        if(ring_left_cnt[0] > 0 && tracking.Get_Corner(LEFT_UP).y > 20)
+        if(_ring_left_cnt[0] > 0 && tracking.Get_Corner(LEFT_UP).y > 20)
         {
-            vector<POINT> ring_bezier(3);
+            POINT ring_bezier[3];
             ring_bezier[0] = tracking.Get_Edge_Left()[2];
             ring_bezier[1] = {
                 (tracking.Get_Edge_Left()[2].x + tracking.Get_Corner(LEFT_UP).x) * 2 / 3,
                 (tracking.Get_Edge_Left()[2].y + tracking.Get_Corner(LEFT_UP).y) / 2};
             ring_bezier[2] = tracking.Get_Corner(LEFT_UP);
-            _ring_left_line_in = Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y),ring_bezier);
+            Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y), ring_bezier, 3, _ring_left_line_in);
             return Scene::RingScene;
         }
-        if(ring_right_cnt[0] > 0 && tracking.Get_Corner(RIGHT_UP).y > 20)
+        if(_ring_right_cnt[0] > 0 && tracking.Get_Corner(RIGHT_UP).y > 20)
         {
-            vector<POINT> ring_bezier(3);
+            POINT ring_bezier[3];
             ring_bezier[0] = tracking.Get_Edge_Right()[2];
             ring_bezier[1] = {
                 (tracking.Get_Edge_Right()[2].x + tracking.Get_Corner(RIGHT_UP).x) * 1 / 3,
                 (tracking.Get_Edge_Right()[2].y + tracking.Get_Corner(RIGHT_UP).y) / 2};
             ring_bezier[2] = tracking.Get_Corner(RIGHT_UP);
-            _ring_right_line_in = Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y),ring_bezier);
+            Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y), ring_bezier, 3, _ring_right_line_in);
             return Scene::RingScene;
         }
         // ========================================= 环岛出识别 ========================================
         // 环岛左出
-        if(ring_left_cnt[0] > 0 && tracking.Get_Edge_Left().size() < tracking.Get_Height() * 2/3)
+        if(_ring_left_cnt[0] > 0 && tracking.Get_Edge_Left().size() < tracking.Get_Height() * 2/3)
         {
-            ring_left_cnt[1]++;
+            _ring_left_cnt[1]++;
         }
-        if(ring_left_cnt[1] > 0 && tracking.Get_Corner(RIGHT_DOWN).y < 20 && tracking.Get_Width_Block()[i] > tracking.Get_Width() * 0.9)
+        if(_ring_left_cnt[1] > 0 && tracking.Get_Corner(RIGHT_DOWN).y < 20 && tracking.Get_Width_Block()[i] > tracking.Get_Width() * 0.9)
         {
-            vector<POINT> ring_bezier(3);
+            POINT ring_bezier[3];
             ring_bezier[0] = tracking.Get_Edge_Left()[2];
             ring_bezier[1] = {
                 (tracking.Get_Edge_Left()[2].x + tracking.Get_Corner(RIGHT_DOWN).x) * 2 / 3,
                 (tracking.Get_Edge_Left()[2].y + tracking.Get_Corner(RIGHT_DOWN).y) / 2};
             ring_bezier[2] = tracking.Get_Edge_Right()[tracking.Get_Valid_Row() - 1];
-            _ring_left_line_out = Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y),ring_bezier);
-            ring_frame_cnt++;
-            if(ring_frame_cnt > 20)
+            Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y), ring_bezier, 3, _ring_left_line_out);
+            _ring_frame_cnt++;
+            if(_ring_frame_cnt > 20)
             {
-                ring_left_cnt[0] = 0;
-                ring_left_cnt[1] = 0;
-                ring_frame_cnt = 0;
+                _ring_left_cnt[0] = 0;
+                _ring_left_cnt[1] = 0;
+                _ring_frame_cnt = 0;
                 return Scene::RingScene;
             }
         }
         // 环岛右出
-        if(ring_right_cnt[0] > 0 && tracking.Get_Edge_Right().size() < tracking.Get_Height() * 2/3)
+        if(_ring_right_cnt[0] > 0 && tracking.Get_Edge_Right().size() < tracking.Get_Height() * 2/3)
         {
-            ring_right_cnt[1]++;
+            _ring_right_cnt[1]++;
         }
-        if(ring_right_cnt[1] > 0 && tracking.Get_Corner(LEFT_DOWN).y < 20 && tracking.Get_Width_Block()[i] > tracking.Get_Width() * 0.9)
+        if(_ring_right_cnt[1] > 0 && tracking.Get_Corner(LEFT_DOWN).y < 20 && tracking.Get_Width_Block()[i] > tracking.Get_Width() * 0.9)
         {
-            vector<POINT> ring_bezier(3);
+            POINT ring_bezier[3];
             ring_bezier[0] = tracking.Get_Edge_Right()[2];
             ring_bezier[1] = {
                 (tracking.Get_Edge_Right()[2].x + tracking.Get_Corner(LEFT_DOWN).x) * 2 / 3,
                 (tracking.Get_Edge_Right()[2].y + tracking.Get_Corner(LEFT_DOWN).y) / 2};
             ring_bezier[2] = tracking.Get_Edge_Left()[tracking.Get_Valid_Row() - 1];
-            _ring_right_line_out = Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y),ring_bezier);
-            ring_frame_cnt++;
-            if(ring_frame_cnt > 2)
+            Bazier(1.0f / abs(ring_bezier[0].y - ring_bezier[2].y), ring_bezier, 3, _ring_right_line_out);
+            _ring_frame_cnt++;
+            if(_ring_frame_cnt > 2)
             {
-                ring_right_cnt[0] = 0;
-                ring_right_cnt[1] = 0;
-                ring_frame_cnt = 0;
+                _ring_right_cnt[0] = 0;
+                _ring_right_cnt[1] = 0;
+                _ring_frame_cnt = 0;
                 return Scene::RingScene;
             }
         }
@@ -350,6 +348,7 @@ bool Element::Apply_Supplement_Line(int current_y, const std::vector<common::POI
 
 float Element::Get_Middle_Error(Tracking &tracking)
 {
+    NS_PROFILE(Middle_Error);
     _left_line.clear();
     _right_line.clear();
     _middle_line.clear();
@@ -425,8 +424,8 @@ float Element::Get_Middle_Error(Tracking &tracking)
     // 计算平均误差
     float average_error = _middle_error / valid_rows;
     // 添加调试信息
-    debug << "中间线误差：" << _middle_error << "，平均误差：" << average_error << std::endl;
-    debug << "有效行数：" << valid_rows << "，图像中心：" << tracking.Get_Width() / 2 << std::endl;
+    NS_LOG_DEBUG("中间线误差：%f，平均误差：%f，有效行数：%d，图像中心：%d",
+                 _middle_error, average_error, valid_rows, tracking.Get_Width() / 2);
     return average_error;
 }
 
@@ -436,6 +435,8 @@ float Element::Get_Middle_Error(Tracking &tracking)
  */
 void Element::Draw_Edge(Tracking &tracking)
 {
+    if(tracking._draw_frame.empty())    // 无界面模式
+        return;
     // // 绘制左边缘点（蓝色）
     // for(size_t i = 0; i < tracking.Get_Edge_Left().size();i++)
     // {
@@ -523,8 +524,8 @@ void Element::Draw_Edge(Tracking &tracking)
                2,  // 圆圈半径
                cv::Scalar(0,255,255),  // 绿色 (B,G,R)
                -1);  // 实心圆
-    debug << "左边斜率：" << tracking.Get_Edge_Left()[tracking.Get_Height()/2].slope << std::endl;
-    debug << "右边斜率：" << tracking.Get_Edge_Right()[tracking.Get_Height()/2].slope << std::endl;
+    NS_LOG_DEBUG("左边斜率：%f 右边斜率：%f",
+                 tracking.Get_Edge_Left()[tracking.Get_Height()/2].slope, tracking.Get_Edge_Right()[tracking.Get_Height()/2].slope);
 }
 
 
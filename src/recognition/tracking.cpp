@@ -33,6 +33,13 @@ Tracking::Tracking()
     _width = _parameter.Get_Parameter("Image_Width").get<int>();    // 获取图像宽度
     _height = _parameter.Get_Parameter("Image_Height").get<int>();  // 获取图像高度
     _border = _parameter.Get_Parameter("Border").get<int>();        // 获取边框宽度
+    // 角点斜率阈值在逐行检测中使用，构造时读取一次
+    _corner_left_up_slope1_min = _parameter.Get_Parameter("Corner_Left_Up_Slope1_Min").get<double>();
+    _corner_left_up_slope1_max = _parameter.Get_Parameter("Corner_Left_Up_Slope1_Max").get<double>();
+    _corner_left_up_slope2 = _parameter.Get_Parameter("Corner_Left_Up_Slope2").get<double>();
+    _corner_right_up_slope1_min = _parameter.Get_Parameter("Corner_Right_Up_Slope1_Min").get<double>();
+    _corner_right_up_slope1_max = _parameter.Get_Parameter("Corner_Right_Up_Slope1_Max").get<double>();
+    _corner_right_up_slope2 = _parameter.Get_Parameter("Corner_Right_Up_Slope2").get<double>();
 }
 
 /**
@@ -58,36 +65,42 @@ Tracking::~Tracking()
  * - 减少噪声干扰
  * - 突出赛道边缘特征
  * - 为后续边缘检测做准备
+ *
+ * @return 是否得到可用的图像，采集失败（视频或图片目录读完）时返回false
  */
-void Tracking::Picture_Process()
+bool Tracking::Picture_Process()
 {
     // 步骤1：捕获图像
     if(!_camera.Capture())
     {
         std::cerr << "Failed to capture frame" << std::endl;
-        return;
+        return false;
     }
+    NS_PROFILE(Preprocess);     // 不含上面的采集
     
-    // 步骤2：图像处理
-    _camera.Resize_Frame(_width,_height);
+    // 步骤2：图像处理（预处理缓存的帧已缩放）
+    if(!_camera.Is_Preprocessed())
+        _camera.Resize_Frame(_width,_height);
     
     // 检查图像处理是否成功
     if(!_camera.Frame_Process())
     {
         std::cerr << "图像处理失败" << std::endl;
-        return;
+        return false;
     }
     
-    // 获取原始帧并检查是否为空
-    cv::Mat original_frame = _camera.Get_Frame();
-    if(original_frame.empty())
+    // 无界面模式不分配绘制图像，也不需要原始帧（预处理缓存不含原始帧）
+    if(!Is_Headless())
     {
-        std::cerr << "原始图像为空，无法创建绘制帧" << std::endl;
-        return;
+        cv::Mat original_frame = _camera.Get_Frame();
+        if(original_frame.empty())
+        {
+            std::cerr << "原始图像为空，无法创建绘制帧" << std::endl;
+            return false;
+        }
+        _draw_frame = original_frame.clone();
     }
     
-    _draw_frame = original_frame.clone();
-    
     // 步骤3：添加边框(_border个像素的黑色边框)
     // 边框的作用：防止边缘检测时越界，同时提供边界参考
     cv::Mat binary_frame = _camera.Get_Binary_Frame();
@@ -101,7 +114,9 @@ void Tracking::Picture_Process()
     else
     {
         std::cerr << "二值化图像为空，无法添加边框" << std::endl;
+        return false;
     }
+    return true;
 }
 
 
@@ -117,14 +132,14 @@ bool Tracking::Find_Start_Point(int scan_start_y, int scan_height)
     cv::Mat binary_frame = _camera.Get_Binary_Frame();
     if(binary_frame.empty())
     {
-        debug << "二值化图像为空，无法寻找起点" << std::endl;
+        NS_LOG_DEBUG("二值化图像为空，无法寻找起点");
         return false;
     }
     
     // 检查图像尺寸
     if(binary_frame.cols <= 0 || binary_frame.rows <= 0)
     {
-        debug << "二值化图像尺寸无效" << std::endl;
+        NS_LOG_DEBUG("二值化图像尺寸无效");
         return false;
     }
     
@@ -134,7 +149,7 @@ bool Tracking::Find_Start_Point(int scan_start_y, int scan_height)
     // 检查扫描范围是否有效
     if(y_base < 0 || y_base >= binary_frame.rows)
     {
-        debug << "扫描起始位置无效: y_base=" << y_base << ", rows=" << binary_frame.rows << std::endl;
+        NS_LOG_DEBUG("扫描起始位置无效: y_base=%d, rows=%d", y_base, binary_frame.rows);
         return false;
     }
 
@@ -192,7 +207,7 @@ bool Tracking::Find_Start_Point(int scan_start_y, int scan_height)
 
         return true;
     } else {
-        debug << "未找到有效的赛道起点！" << std::endl;
+        NS_LOG_DEBUG("未找到有效的赛道起点！");
         return false;
     }
 }
@@ -256,6 +271,7 @@ const POINT dir_frontright[4] = {
  */
 void Tracking::Track_Recognition()
 {
+    NS_PROFILE(Track_Recognition);
     _maze_edge_left.clear();
     _maze_edge_right.clear();
     // 获取起始行参数
@@ -263,7 +279,7 @@ void Tracking::Track_Recognition()
     // 寻找起点，如果失败则退出
     while(!Find_Start_Point(start_line))
     {
-        debug << "未找到起点， 重新寻找" << endl;
+        NS_LOG_DEBUG("未找到起点， 重新寻找");
         start_line += 5;
         if(start_line > _height / 2)
             return;
@@ -293,7 +309,7 @@ void Tracking::Track_Recognition()
            l_point.y <= 0 || l_point.y >= _camera.Get_Binary_Frame().rows - 1 ||
            r_point.x <= 0 || r_point.x >= _camera.Get_Binary_Frame().cols - 1 || 
            r_point.y <= 0 || r_point.y >= _camera.Get_Binary_Frame().rows - 1) {
-            debug << "越界，退出循环" << endl;
+            NS_LOG_TRACE("越界，退出循环");
             break;
         }
         
@@ -422,7 +438,7 @@ void Tracking::Track_Recognition()
         // 转向次数限制：防止在复杂路径中陷入循环
         if(l_turn > 3 || r_turn > 3)
         {
-            debug << "转向次数过多，退出循环" << endl;
+            NS_LOG_TRACE("转向次数过多，退出循环");
             break;
         }
         // 到达图像顶部，退出循环
@@ -430,19 +446,19 @@ void Tracking::Track_Recognition()
         {
             if(l_point.x == _width / 2 || r_point.x == _width / 2)
             {
-                debug << "中线，退出循环" << endl;
+                NS_LOG_TRACE("中线，退出循环");
                 break;
             }
         }
         // 两点相遇，退出循环
         if(l_point.x == r_point.x && l_point.y == r_point.y) 
         {
-            debug << "两点相遇，退出循环" << endl;
+            NS_LOG_TRACE("两点相遇，退出循环");
             break;
         }
         if(l_step > STEP_MAX || r_step > STEP_MAX)
         {
-            debug << "步数过多，退出循环" << endl;
+            NS_LOG_TRACE("步数过多，退出循环");
             break;
         }
     }
@@ -454,6 +470,7 @@ void Tracking::Track_Recognition()
  */
 void Tracking::Edge_Extract()
 {
+    NS_PROFILE(Edge_Extract);
     // 获取左右线的步数
     int l_step = _maze_edge_left.size();
     int r_step = _maze_edge_right.size();
@@ -587,16 +604,15 @@ void Tracking::Edge_Extract()
         if(_corner_left_up.x == 0) // 如果还没有找到左上角点
         {
             bool width_condition = (_width_block[i] <= _width_block[i - 2]*0.6);
-            if((_edge_left[i].slope < _parameter.Get_Parameter("Corner_Left_Up_Slope1_Min").get<double>() 
-                && _edge_left[i].slope > _parameter.Get_Parameter("Corner_Left_Up_Slope1_Max").get<double>())
-                && (_edge_left[i - 2].slope > _parameter.Get_Parameter("Corner_Left_Up_Slope2").get<double>() 
+            if((_edge_left[i].slope < _corner_left_up_slope1_min 
+                && _edge_left[i].slope > _corner_left_up_slope1_max)
+                && (_edge_left[i - 2].slope > _corner_left_up_slope2 
                 && (width_condition || abs(_edge_left[i].slope) != 255)
                 && (width_condition || abs(_edge_left[i - 2].slope) != 255)
                 && _edge_left[i - 2].slope != 0 
                 && _edge_left[i - 2].y < _height - 50))
             {
-                debug << "左上斜率" << to_string(_edge_left[i].slope) << endl;
-                debug << "左上-2斜率" << to_string(_edge_left[i - 2].slope) << endl;
+                NS_LOG_DEBUG("左上斜率%f 左上-2斜率%f", _edge_left[i].slope, _edge_left[i - 2].slope);
                 _corner_left_up = _edge_left[i - 2];
                 break;
             }
@@ -609,16 +625,15 @@ void Tracking::Edge_Extract()
         if(_corner_right_up.x == 0) // 如果还没有找到右上角点
         {
             bool width_condition_right = (_width_block[i] <= _width_block[i - 2]*0.6);
-            if(_edge_right[i].slope > _parameter.Get_Parameter("Corner_Right_Up_Slope1_Min").get<double>() 
-                && _edge_right[i].slope < _parameter.Get_Parameter("Corner_Right_Up_Slope1_Max").get<double>()
-                && (_edge_right[i - 2].slope < _parameter.Get_Parameter("Corner_Right_Up_Slope2").get<double>())
+            if(_edge_right[i].slope > _corner_right_up_slope1_min 
+                && _edge_right[i].slope < _corner_right_up_slope1_max
+                && (_edge_right[i - 2].slope < _corner_right_up_slope2)
                 && _edge_right[i - 2].slope != 0
                 && (width_condition_right || abs(_edge_right[i].slope) != 255)
                 && (width_condition_right || abs(_edge_right[i - 2].slope) != 255)
                 && _edge_right[i - 2].y < _height - 50)
             {
-                debug << "右上斜率" << to_string(_edge_right[i].slope) << endl;
-                debug << "右上-2斜率" << to_string(_edge_right[i - 2].slope) << endl;
+                NS_LOG_DEBUG("右上斜率%f 右上-2斜率%f", _edge_right[i].slope, _edge_right[i - 2].slope);
                 _corner_right_up = _edge_right[i - 2];
                 break;
             }
@@ -626,9 +641,7 @@ void Tracking::Edge_Extract()
     }
     stdev_edge_left = Variance<double, vector<double>>(l_slope);
     stdev_edge_right = Variance<double, vector<double>>(r_slope);
-    debug << "左边缘点方差：" << stdev_edge_left << std::endl;
-    debug << "右边缘点方差：" << stdev_edge_right << std::endl;
-    debug << "宽度：" << _width_block[_height/2] << std::endl;
+    NS_LOG_DEBUG("左边缘点方差：%f 右边缘点方差：%f 宽度：%d", stdev_edge_left, stdev_edge_right, _width_block[_height/2]);
 }
 
 
@@ -1,6 +1,8 @@
 #include "common.hpp"
 #include "recognition.hpp"
 #include "control.hpp"
+#include <poll.h>
+#include <unistd.h>
 
 
 using namespace std;
@@ -12,9 +14,35 @@ namespace task{
 
 
 
+/**
+ * @brief 无界面模式下读取按键（不阻塞）
+ * @param uart 串口，下位机按键映射为暂停/继续
+ * @return 按键字符，无按键时为0
+ *
+ * 标准输入为行缓冲，输入字符后回车生效。
+ */
+char Headless_Key_Task(const shared_ptr<Uart>& uart)
+{
+    if(uart && uart->keypress.exchange(false))
+        return ' ';
+    char key = 0;
+    pollfd pfd{STDIN_FILENO, POLLIN, 0};
+    while(poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+    {
+        char c;
+        if(read(STDIN_FILENO, &c, 1) != 1)
+            break;      // 标准输入已关闭
+        if(c != '\n' && c != '\r')
+            key = c;
+    }
+    return key;
+}
+
 void Show_Draw_Line_Task(Tracking& tracking, Element& element, ControlCenter& control_center)
 {
-    
+    if(Is_Headless())   // 无界面模式不绘制
+        return;
+
     // 绘制中线、左右边线
     for(size_t i = 0;i < element._middle_line.size();i++)
     {
@@ -75,6 +103,98 @@ void Show_Draw_Line_Task(Tracking& tracking, Element& element, ControlCenter& co
 
 
 
+/**
+ * @brief 把当前帧及叠加信息发布到共享内存，由外部查看器绘制显示
+ */
+void Publish_Frame_Task(FramePublisher& publisher, Tracking& tracking, Element& element, ControlCenter& control_center, Motion& motion, const string& scene)
+{
+    auto to_shm = [](const POINT& pt) { return Shm_Point{(int16_t)pt.x, (int16_t)pt.y}; };
+    Shm_Overlay overlay;
+    overlay.frame_id = debug.get_frame_count();
+    overlay.stamp_ns = Now_Ns();
+    snprintf(overlay.scene, sizeof(overlay.scene), "%s", scene.c_str());
+    overlay.fps = debug.get_average_fps();
+    overlay.control_center = control_center._control_center;
+    overlay.control_row = tracking.Get_Height() / 2;
+    overlay.sigma = control_center._sigma_center;
+    overlay.speed = motion._speed;
+    overlay.servo_pwm = motion._servo_pwm;
+    overlay.reserved = 0;
+
+    size_t lines = min({element._middle_line.size(), element._left_line.size(), element._right_line.size(), (size_t)SHM_MAX_POINTS});
+    for(size_t i = 0; i < lines; i++)
+    {
+        overlay.left[i] = to_shm(element._left_line[i]);
+        overlay.middle[i] = to_shm(element._middle_line[i]);
+        overlay.right[i] = to_shm(element._right_line[i]);
+    }
+    overlay.line_count = lines;
+    size_t centers = min(control_center._center_edge.size(), (size_t)SHM_MAX_POINTS);
+    for(size_t i = 0; i < centers; i++)
+        overlay.center[i] = to_shm(control_center._center_edge[i]);
+    overlay.center_count = centers;
+    overlay.corners[0] = to_shm(tracking.Get_Corner(LEFT_DOWN));
+    overlay.corners[1] = to_shm(tracking.Get_Corner(RIGHT_DOWN));
+    overlay.corners[2] = to_shm(tracking.Get_Corner(LEFT_UP));
+    overlay.corners[3] = to_shm(tracking.Get_Corner(RIGHT_UP));
+
+    publisher.Publish(tracking._camera.Get_Frame(), tracking._camera.Get_Binary_Frame(), overlay);
+}
+
+
+
+/**
+ * @brief 把本帧的处理状态写入飞行记录仪
+ */
+void Flight_Record_Task(FlightRecorder& recorder, Tracking& tracking, ControlCenter& control_center, Motion& motion,
+                        const shared_ptr<Uart>& uart, const string& scene, float middle_error)
+{
+    Flight_Record& record = recorder.Next();
+    record.frame_id = debug.get_frame_count();
+    record.servo_pwm = motion._servo_pwm;
+    record.capture_ns = tracking._camera.Get_Capture_Ns();
+    record.stamp_ns = Now_Ns();
+    for(int i = 0; i < FLIGHT_STAGES; i++)
+        record.stage_ns[i] = Profiler::Current().Last((Stage)i);
+    snprintf(record.scene, sizeof(record.scene), "%s", scene.c_str());
+    const vector<POINT>& left = tracking.Get_Maze_Edge_Left();
+    const vector<POINT>& right = tracking.Get_Maze_Edge_Right();
+    if(!left.empty() && !right.empty())
+    {
+        record.start_left_x = left[0].x;
+        record.start_right_x = right[0].x;
+        record.start_y = left[0].y;
+    }
+    record.control_center = control_center._control_center;
+    const Corner_Type corners[4] = {LEFT_DOWN, RIGHT_DOWN, LEFT_UP, RIGHT_UP};
+    for(int i = 0; i < 4; i++)
+    {
+        record.corners[i][0] = tracking.Get_Corner(corners[i]).x;
+        record.corners[i][1] = tracking.Get_Corner(corners[i]).y;
+    }
+    record.middle_error = middle_error;
+    record.speed = motion._speed;
+    record.sigma = control_center._sigma_center;
+    if(control_center.Fit_Valid())
+        record.flags |= FLIGHT_FIT_VALID;
+    if(uart)
+    {
+        record.flags |= FLIGHT_MOTION;
+        Uart::Telemetry telemetry;
+        if(uart->telemetry(telemetry))
+        {
+            record.flags |= FLIGHT_TELEMETRY;
+            record.measured_speed = telemetry.speed;
+        }
+        record.uart_rx_errors = uart->frameErrors();
+        record.uart_tx_dropped = uart->droppedFrames();
+        record.uart_coalesced = uart->coalescedFrames();
+    }
+    recorder.Commit();
+}
+
+
+
 void Show_Windows_Task(Tracking& tracking,string scene, Motion& motion, ControlCenter& control_center, Display& display, char& key,bool& is_paused)
 {
     int control_point = control_center._control_center; 
@@ -87,8 +207,8 @@ void Show_Windows_Task(Tracking& tracking,string scene, Motion& motion, ControlC
     cv::Mat binary_frame = tracking._camera.Get_Binary_Frame();
     cv::Mat draw_frame = tracking._draw_frame;
 
-    // 在图像上显示帧率信息
-    if (!draw_frame.empty()) {
+    // 在图像上显示帧率信息（无界面模式不绘制）
+    if (!Is_Headless() && !draw_frame.empty()) {
         // 设置文本参数
         int font_face = cv::FONT_HERSHEY_SIMPLEX;
         double font_scale = 0.5;
@@ -111,9 +231,12 @@ void Show_Windows_Task(Tracking& tracking,string scene, Motion& motion, ControlC
         cv::putText(draw_frame, uart, cv::Point(250, y_offset + 50), font_face, font_scale, text_color, thickness);
     }
     
-    display.show_image(0, original_frame);
-    display.show_image(1, binary_frame);
-    display.show_image(2, draw_frame);
+    if(!Is_Headless())
+    {
+        display.show_image(0, original_frame);
+        display.show_image(1, binary_frame);
+        display.show_image(2, draw_frame);
+    }
     
     // 根据暂停状态设置不同的延时
     if(!is_paused)
@@ -135,13 +258,16 @@ void Show_Windows_Task(Tracking& tracking,string scene, Motion& motion, ControlC
         // 输出调试信息（可选）
         static int frame_counter = 0;
         if(frame_counter++ % 100 == 0) { // 每100帧输出一次
-            debug << "摄像头帧率: " << camera_fps << " FPS, 处理时间: " 
-                    << processing_time_ms << " ms, 延时: " << delay_ms << " ms" << std::endl;
+            NS_LOG_DEBUG("摄像头帧率: %.1f FPS, 处理时间: %d ms, 延时: %d ms", camera_fps, processing_time_ms, delay_ms);
         }
         
-        if(debug_mode == "video" || debug_mode == "picture")
+        if(debug_mode == "recording")
+        {
+            // 录制回放由摄像头按录制时间自行控制节奏
+        }
+        else if(debug_mode == "video" || debug_mode == "picture" || debug_mode == "folder")
         {
-            this_thread::sleep_for(chrono::milliseconds(tracking._camera._video_delay));   //video、picture模式使用，越小播放视频越快
+            this_thread::sleep_for(chrono::milliseconds(tracking._camera._video_delay));   //video、picture、folder模式使用，越小播放视频越快
         }
         else
             this_thread::sleep_for(chrono::milliseconds(delay_ms));  //camera模式使用，根据帧率动态调整播放速度
@@ -170,10 +296,11 @@ void Show_Windows_Task(Tracking& tracking,string scene, Motion& motion, ControlC
     }
     if(key == 's' || key == 'S')
     {
-        // 检查绘制图像是否为空再保存
-        if(!draw_frame.empty()) {
+        // 无界面模式没有绘制图像，保存原始图像
+        cv::Mat save_frame = draw_frame.empty() ? original_frame : draw_frame;
+        if(!save_frame.empty()) {
             string filename = "frame_" + to_string(debug.get_frame_count()) + ".jpg";
-            imwrite(filename, draw_frame);
+            imwrite(filename, save_frame);
             debug << "保存图像：" << filename << std::endl;
         } else {
             debug.force_outputln("错误：无法保存图像，绘制图像为空");
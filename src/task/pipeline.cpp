@@ -0,0 +1,87 @@
+#include "task/pipeline.hpp"
+
+using namespace common;
+using namespace recognition;
+using namespace control;
+using namespace std;
+
+namespace task{
+
+bool Pipeline::Process()
+{
+    if(!_tracker.Picture_Process())  // 采集及预处理
+        return false;
+    _frame_id++;
+    // ========================================== 赛道巡线获取控制点信息 ==========================================
+    _tracker.Track_Recognition(); // 巡线识别
+    _tracker.Edge_Extract(); // 边缘提取
+    _detected = _element.Recognition_Element(_tracker);    // 元素识别
+    Update_Scene(_detected);
+    _middle_error = _element.Get_Middle_Error(_tracker);  // 补线及拟合中心线
+    _control_center.Fitting(_tracker, _element); // 拟合中心线
+    return true;
+}
+
+/**
+ * @brief 由元素识别结果切换场景
+ */
+void Pipeline::Update_Scene(recognition::Scene detected)
+{
+    switch(detected)
+    {
+        case recognition::Scene::ZebraScene:
+            _element._zebra_cnt ++;
+            if(_element._zebra_cnt >= 5)//连着5帧为斑马线再确定
+            {
+                _scene = "ZebraScene";
+                _element._zebra_cnt = 0;
+                _element._zebra_flag = true;
+                NS_LOG_INFO("检测到场景：斑马线 %u", _frame_id);
+            }
+            break;
+        case recognition::Scene::RingScene:
+            _scene = "RingScene";
+            _element._ring_flag = true;
+            NS_LOG_INFO("检测到场景：环岛 %u", _frame_id);
+            break;
+        case recognition::Scene::ObstacleScene:
+            _scene = "ObstacleScene";
+            _element._obstaclee_flag = true;
+            NS_LOG_INFO("检测到场景：障碍物 %u", _frame_id);
+            break;
+        case recognition::Scene::BridgeScene:
+        case recognition::Scene::CateringScene:
+        case recognition::Scene::LaybyScene:
+        case recognition::Scene::ParkingScene:
+        case recognition::Scene::NolmalScene:
+        default: _scene = "NormalScene";
+            // 这些场景暂时不处理
+            break;
+    }
+}
+
+void Pipeline::Speed_Control()
+{
+    _motion.Speed_Control(true, false, _control_center, _motion.Speed_Cap(_scene));
+}
+
+Vision_Target Pipeline::Target() const
+{
+    Vision_Target target;
+    target.frame_id = _frame_id;
+    target.stamp_ns = Now_Ns();
+    target.capture_ns = _tracker._camera.Get_Capture_Ns();
+    target.error = _control_center._control_center - _tracker.Get_Width() / 2.0f;
+    target.speed = _motion._speed;
+    target.width = _tracker.Get_Width();
+    target.fit_valid = _control_center.Fit_Valid();
+    for(int k = 0; k < 4; k++)
+        target.fit_coef[k] = _control_center.Fit_Coef()[k];
+    target.fit_scale = _control_center.Fit_Scale();
+    target.fit_s_min = _control_center.Fit_S_Min();
+    target.fit_range = _control_center.Fit_Range();
+    target.look_ahead = _control_center._look_ahead;
+    return target;
+}
+
+}
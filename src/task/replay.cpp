@@ -0,0 +1,411 @@
+#include "task/replay.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace common;
+using namespace recognition;
+using namespace control;
+using namespace std;
+
+namespace task{
+
+bool Replay_Writer::Open(const string& path, int width, int height)
+{
+    Close();
+    _file = fopen(path.c_str(), "wb");
+    if(!_file)
+        return false;
+    _buffer.resize(1 << 20);
+    setvbuf(_file, _buffer.data(), _IOFBF, _buffer.size());
+    Replay_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.frame_size = sizeof(Replay_Frame);
+    header.width = width;
+    header.height = height;
+    fwrite(&header, sizeof(header), 1, _file);
+    return true;
+}
+
+void Replay_Writer::Write(const Pipeline& pipeline, uint16_t servo_pwm, uint32_t process_ns)
+{
+    if(!_file)
+        return;
+    const Tracking& tracker = pipeline._tracker;
+    const vector<POINT>& left = tracker.Get_Edge_Left();
+    const vector<POINT>& right = tracker.Get_Edge_Right();
+
+    Replay_Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.frame_id = pipeline._frame_id;
+    frame.process_ns = process_ns;
+    frame.servo_pwm = servo_pwm;
+    frame.detected = (uint8_t)pipeline._detected;
+    snprintf(frame.scene, sizeof(frame.scene), "%s", pipeline._scene.c_str());
+    const vector<POINT>& maze_left = tracker.Get_Maze_Edge_Left();
+    const vector<POINT>& maze_right = tracker.Get_Maze_Edge_Right();
+    if(!maze_left.empty() && !maze_right.empty())
+    {
+        frame.flags |= REPLAY_START_FOUND;
+        frame.start_left_x = maze_left[0].x;
+        frame.start_right_x = maze_right[0].x;
+        frame.start_y = maze_left[0].y;
+    }
+    if(pipeline._control_center.Fit_Valid())
+        frame.flags |= REPLAY_FIT_VALID;
+    frame.control_center = pipeline._control_center._control_center;
+    const Corner_Type corners[4] = {LEFT_DOWN, RIGHT_DOWN, LEFT_UP, RIGHT_UP};
+    for(int i = 0; i < 4; i++)
+    {
+        frame.corners[i][0] = tracker.Get_Corner(corners[i]).x;
+        frame.corners[i][1] = tracker.Get_Corner(corners[i]).y;
+    }
+    frame.valid_row = tracker.Get_Valid_Row();
+    frame.left_count = min<size_t>(left.size(), UINT16_MAX);
+    frame.right_count = min<size_t>(right.size(), UINT16_MAX);
+    frame.middle_error = pipeline._middle_error;
+    frame.speed = pipeline._motion._speed;
+    frame.sigma = pipeline._control_center._sigma_center;
+
+    _points.clear();
+    for(size_t i = 0; i < frame.left_count; i++)
+        _points.push_back({(int16_t)left[i].x, (int16_t)left[i].y});
+    for(size_t i = 0; i < frame.right_count; i++)
+        _points.push_back({(int16_t)right[i].x, (int16_t)right[i].y});
+    fwrite(&frame, sizeof(frame), 1, _file);
+    fwrite(_points.data(), sizeof(Replay_Point), _points.size(), _file);
+}
+
+void Replay_Writer::Close()
+{
+    if(_file)
+        fclose(_file);
+    _file = nullptr;
+}
+
+/**
+ * @brief 输入是否为目录
+ */
+static bool Is_Folder(const string& source)
+{
+    struct stat st;
+    return stat(source.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/**
+ * @brief 录制文件的平均帧率（按采集时间）
+ */
+static double Recording_Fps(const RecordingReader& recording)
+{
+    const vector<Recording_Index>& frames = recording.Frames();
+    if(frames.size() < 2 || frames.back().stamp_ns <= frames.front().stamp_ns)
+        return 0;
+    return (frames.size() - 1) * 1e9 / (frames.back().stamp_ns - frames.front().stamp_ns);
+}
+
+/**
+ * @brief 参数快照中只影响运行环境的参数（输入源、输出、显示及设备），回放时不应用
+ */
+static bool Is_Environment_Key(const string& key)
+{
+    static const char* const prefixes[] = {"Debug_", "Recording_", "Camera_"};
+    static const char* const keys[] = {"Video_Delay", "Print_Mode", "Headless", "Shm_Publish", "Profile_Trace",
+                                       "Perf_Counters", "Flight_Records", "Motion_Enable"};
+    for(const char* prefix : prefixes)
+        if(key.compare(0, strlen(prefix), prefix) == 0)
+            return true;
+    for(const char* name : keys)
+        if(key == name)
+            return true;
+    return key.size() > 5 && key.compare(key.size() - 5, 5, "_Name") == 0;
+}
+
+bool Run_Replay(const Replay_Job& job, Replay_Result& result)
+{
+    result = Replay_Result();
+    // 输入源和参数组只覆盖本线程，须在构造流水线之前设置
+    Parameter::Clear_Thread_Overrides();
+    shared_ptr<RecordingReader> recording;
+    if(RecordingReader::Is_Recording(job.source))
+    {
+        recording = RecordingReader::Open(job.source);
+        if(!recording)
+        {
+            result.error = "无法打开录制文件";
+            return false;
+        }
+        // 先应用录制时的参数快照，再由本任务的参数组覆盖
+        nlohmann::json snapshot = job.snapshot ? nlohmann::json::parse(recording->Config(), nullptr, false)
+                                               : nlohmann::json();
+        if(snapshot.is_object())
+            for(auto it = snapshot.begin(); it != snapshot.end(); ++it)
+                if(!Is_Environment_Key(it.key()))
+                    Parameter::Override_Thread(it.key(), it.value());
+        Parameter::Override_Thread("Debug_Mode", "recording");
+        Parameter::Override_Thread("Debug_Recording_Path", job.source);
+        Parameter::Override_Thread("Recording_Realtime", false);
+    }
+    else
+    {
+        bool folder = Is_Folder(job.source);
+        Parameter::Override_Thread("Debug_Mode", folder ? "folder" : "video");
+        Parameter::Override_Thread(folder ? "Debug_Folder_Path" : "Debug_Video_Path", job.source);
+    }
+    for(auto it = job.params.begin(); it != job.params.end(); ++it)
+        Parameter::Override_Thread(it.key(), it.value());
+
+    {
+        Pipeline pipeline;
+        Camera& camera = pipeline._tracker._camera;
+        bool cached = job.cache && camera.Use_Cache(job.cache);    // 跳过解码和预处理
+        if(!cached && job.frames)
+            camera.Use_Frames(job.frames);
+        ControlLoop control_loop(nullptr);  // 不启动控制线程，每帧执行一个控制周期
+        Replay_Writer writer;
+        if(!camera.Is_Initialized())
+            result.error = "无法打开输入";
+        else if(!job.output.empty() && !writer.Open(job.output, pipeline._tracker.Get_Width(), pipeline._tracker.Get_Height()))
+            result.error = "无法写入结果文件";
+        else
+        {
+            // 帧时间按帧率生成，不取实际时钟，保证控制周期的输出可复现
+            result.fps = job.fps > 0 ? job.fps : cached ? job.cache->Fps() :
+                         recording ? Recording_Fps(*recording) : camera.Get_Actual_FPS();
+            if(result.fps <= 0)
+                result.fps = 30;
+            const int64_t period_ns = static_cast<int64_t>(1e9 / result.fps);
+            Profiler& profiler = Profiler::Current();
+            uint64_t frame_count = profiler.Get(Stage::Frame).Count();
+            uint16_t servo_last = PWMSERVOMID;
+
+            int64_t start_ns = Now_Ns();
+            while(job.max_frames == 0 || pipeline._frame_id < job.max_frames)
+            {
+                int64_t frame_start = Now_Ns();
+                {
+                    NS_PROFILE(Frame);
+                    if(!pipeline.Process())
+                        break;      // 视频或图片目录读完
+                    pipeline.Speed_Control();
+                }
+                int64_t frame_ns = pipeline._frame_id * period_ns;
+                if(recording && job.fps <= 0)
+                {
+                    // 录制文件取采集时间（相对录制开始）
+                    size_t k = pipeline._frame_id - 1;
+                    if(cached)
+                        k = job.cache->Index(k).source_index;
+                    frame_ns = cached || job.frames ? recording->Frames()[k].stamp_ns : camera.Get_Recorded_Ns();
+                    frame_ns -= recording->Header().start_ns;
+                }
+                Vision_Target target = pipeline.Target();
+                target.capture_ns = frame_ns;
+                target.stamp_ns = frame_ns;
+                control_loop.Publish(target);
+                control_loop.Control_Step(frame_ns);
+                uint16_t servo = control_loop.Get_Servo_Pwm();
+                pipeline._motion._servo_pwm = servo;
+                writer.Write(pipeline, servo, static_cast<uint32_t>(Now_Ns() - frame_start));
+                if(job.on_frame)
+                    job.on_frame(pipeline, servo);
+
+                if(pipeline._control_center.Fit_Valid())
+                    result.fit_valid++;
+                result.abs_error_sum += fabs(pipeline._middle_error);
+                if(pipeline._frame_id > 1)
+                    result.servo_delta_sum += abs(servo - servo_last);
+                servo_last = servo;
+            }
+            result.elapsed = (Now_Ns() - start_ns) / 1e9;
+            result.frames = pipeline._frame_id;
+            writer.Close();
+            // 绑定的统计对象只属于本任务时，百分位数即本任务的单帧耗时
+            if(profiler.Get(Stage::Frame).Count() == frame_count + result.frames)
+            {
+                result.frame_p50_ns = profiler.Get(Stage::Frame).Percentile(50);
+                result.frame_p99_ns = profiler.Get(Stage::Frame).Percentile(99);
+            }
+            result.ok = result.frames > 0;
+            if(!result.ok)
+                result.error = "没有处理任何帧";
+        }
+    }
+    Parameter::Clear_Thread_Overrides();
+
+    if(result.ok && !job.baseline.empty() && !job.output.empty())
+    {
+        vector<Replay_Entry> expected, actual;
+        if(!Load_Replay(job.baseline, expected) || !Load_Replay(job.output, actual))
+        {
+            result.ok = false;
+            result.error = "无法读取基准文件 " + job.baseline;
+        }
+        else
+        {
+            result.compared = true;
+            result.diff = Compare_Replay(expected, actual, job.tolerance);
+        }
+    }
+    return result.ok;
+}
+
+bool Load_Frames(const string& source, int width, int height, size_t budget, vector<cv::Mat>& frames, double& fps)
+{
+    frames.clear();
+    fps = 0;
+    const size_t frame_bytes = (size_t)width * height * 3;
+    cv::Mat frame;
+    auto add = [&](const cv::Mat& image)
+    {
+        if((frames.size() + 1) * frame_bytes > budget)
+            return false;
+        frames.emplace_back();
+        cv::resize(image, frames.back(), cv::Size(width, height));  // 与Camera::Resize_Frame相同的插值
+        return true;
+    };
+
+    if(Is_Folder(source))
+    {
+        for(const string& file : Camera::List_Images(source))
+        {
+            frame = cv::imread(file);
+            if(!frame.empty() && !add(frame))
+            {
+                frames.clear();
+                return false;
+            }
+        }
+        return !frames.empty();
+    }
+
+    if(RecordingReader::Is_Recording(source))
+    {
+        // 帧时间由Run_Replay取录制的采集时间，fps保持0；跳过的帧会使帧序号与采集时间错位，任何一帧解码失败都放弃
+        shared_ptr<RecordingReader> recording = RecordingReader::Open(source);
+        if(!recording)
+            return false;
+        for(size_t k = 0; k < recording->Frames().size(); k++)
+        {
+            if(!Camera::Decode_Recorded(*recording, k, frame) || !add(frame))
+            {
+                frames.clear();
+                return false;
+            }
+        }
+        return !frames.empty();
+    }
+
+    cv::VideoCapture cap(source);
+    if(!cap.isOpened())
+        return false;
+    fps = cap.get(cv::CAP_PROP_FPS);
+    while(cap.read(frame))
+    {
+        if(!add(frame))
+        {
+            frames.clear();
+            return false;
+        }
+    }
+    return !frames.empty();
+}
+
+void Parallel_For(size_t count, int threads, const function<void(size_t)>& fn)
+{
+    atomic<size_t> next {0};
+    auto worker = [&]()
+    {
+        for(size_t k; (k = next.fetch_add(1, memory_order_relaxed)) < count;)
+            fn(k);
+    };
+    vector<thread> pool;
+    for(int i = 1; i < threads && (size_t)i < count; i++)
+        pool.emplace_back(worker);
+    worker();
+    for(thread& t : pool)
+        t.join();
+}
+
+bool Load_Replay(const string& path, vector<Replay_Entry>& entries)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+        return false;
+    Replay_Header header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) == 0 &&
+              header.frame_size == sizeof(Replay_Frame);
+    entries.clear();
+    Replay_Entry entry;
+    while(ok && fread(&entry.frame, sizeof(Replay_Frame), 1, file) == 1)
+    {
+        entry.left.resize(entry.frame.left_count);
+        entry.right.resize(entry.frame.right_count);
+        ok = fread(entry.left.data(), sizeof(Replay_Point), entry.left.size(), file) == entry.left.size() &&
+             fread(entry.right.data(), sizeof(Replay_Point), entry.right.size(), file) == entry.right.size();
+        if(ok)
+            entries.push_back(entry);
+    }
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief 两条边线的最大x偏差，点数或行不同时返回INT16_MAX
+ */
+static int Edge_Delta(const vector<Replay_Point>& a, const vector<Replay_Point>& b)
+{
+    if(a.size() != b.size())
+        return INT16_MAX;
+    int delta = 0;
+    for(size_t i = 0; i < a.size(); i++)
+    {
+        if(a[i].y != b[i].y)
+            return INT16_MAX;
+        delta = max(delta, abs(a[i].x - b[i].x));
+    }
+    return delta;
+}
+
+Replay_Diff Compare_Replay(const vector<Replay_Entry>& baseline, const vector<Replay_Entry>& current, int tolerance)
+{
+    Replay_Diff diff;
+    diff.frames = min(baseline.size(), current.size());
+    diff.frame_count_delta = max(baseline.size(), current.size()) - diff.frames;
+    for(size_t k = 0; k < diff.frames; k++)
+    {
+        const Replay_Frame& a = baseline[k].frame;
+        const Replay_Frame& b = current[k].frame;
+        bool mismatch = false;
+        if(a.detected != b.detected || strncmp(a.scene, b.scene, REPLAY_SCENE_LENGTH) != 0)
+        {
+            diff.scene_mismatch++;
+            mismatch = true;
+        }
+        int edge = max(Edge_Delta(baseline[k].left, current[k].left), Edge_Delta(baseline[k].right, current[k].right));
+        diff.max_edge_delta = max(diff.max_edge_delta, edge);
+        if(edge > tolerance)
+        {
+            diff.edge_mismatch++;
+            mismatch = true;
+        }
+        int center = abs(a.control_center - b.control_center);
+        int pwm = abs(a.servo_pwm - b.servo_pwm);
+        diff.max_center_delta = max(diff.max_center_delta, center);
+        diff.max_pwm_delta = max(diff.max_pwm_delta, pwm);
+        if(center > tolerance || pwm > tolerance || (a.flags != b.flags))
+        {
+            diff.control_mismatch++;
+            mismatch = true;
+        }
+        if(mismatch && diff.first_mismatch == 0)
+            diff.first_mismatch = b.frame_id;
+    }
+    return diff;
+}
+
+}
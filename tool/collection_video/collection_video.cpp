@@ -6,7 +6,10 @@
  * 功能特性：
  * - 自动检测并打开可用摄像头
  * - 支持自定义录制参数（分辨率、帧率、编码格式）
- * - 实时显示录制预览
+ * - 采集、编码分离：采集线程经有界队列交给编码线程，编码慢时丢帧而不拖慢采集
+ * - 原始模式：直接保存摄像头输出的MJPEG数据包及采集时间（.nsrec，可由ns_replay回放）
+ * - 降频显示录制预览及丢帧、队列深度等统计
+ * - 直接通过V4L2采集，调整参数时在同一设备句柄上停流、设置、开流，按驱动枚举的模式校验并报告用时
  * - 支持键盘控制（开始/停止录制、退出程序）
  * - 自动生成带时间戳的文件名
  * 
@@ -19,13 +22,29 @@
  * @date 2024
  */
 
+#include "common/clock.hpp"
+#include "common/recording.hpp"
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <iostream>
 #include <string>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace cv;
 using namespace std;
@@ -54,6 +73,383 @@ string generate_timestamp() {
     return ss.str();
 }
 
+/**
+ * @brief 像素格式的四字符名称
+ */
+string fourcc_name(uint32_t fourcc) {
+    char name[5] = {(char)(fourcc & 0xFF), (char)((fourcc >> 8) & 0xFF),
+                    (char)((fourcc >> 16) & 0xFF), (char)((fourcc >> 24) & 0xFF), 0};
+    return name;
+}
+
+/**
+ * @brief 采集模式
+ */
+struct CaptureMode {
+    uint32_t fourcc = V4L2_PIX_FMT_MJPEG; // 像素格式（MJPG或YUYV）
+    int width = 0;                        // 分辨率
+    int height = 0;
+    double fps = 0;                       // 帧率
+};
+
+/**
+ * @brief V4L2摄像头
+ * @details 直接通过ioctl采集（内存映射缓冲），格式、分辨率和帧率可在同一设备句柄上
+ *          停流 → 设置 → 开流重新配置，无需关闭设备；设置前按驱动枚举的格式、尺寸和帧间隔校验。
+ *          MJPG格式直接输出数据包，YUYV格式转换为BGR图像。
+ */
+class V4l2Camera {
+private:
+    /**
+     * @brief 内存映射的采集缓冲
+     */
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+    };
+
+    int fd_ = -1;                 // 设备句柄
+    int index_ = -1;              // 设备序号（/dev/videoN）
+    vector<Buffer> buffers_;
+    bool streaming_ = false;
+    CaptureMode mode_;            // 驱动实际采用的模式
+    uint32_t bytes_per_line_ = 0;
+    int buffer_count_ = 4;
+
+    /**
+     * @brief 被信号中断时重试的ioctl
+     */
+    static int xioctl(int fd, unsigned long request, void* arg) {
+        int ret;
+        do {
+            ret = ioctl(fd, request, arg);
+        } while (ret == -1 && errno == EINTR);
+        return ret;
+    }
+
+    /**
+     * @brief 停流并释放缓冲
+     */
+    void release_buffers() {
+        if (fd_ < 0) {
+            return;
+        }
+        if (streaming_) {
+            int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            xioctl(fd_, VIDIOC_STREAMOFF, &type);
+            streaming_ = false;
+        }
+        for (Buffer& buffer : buffers_) {
+            munmap(buffer.start, buffer.length);
+        }
+        buffers_.clear();
+        v4l2_requestbuffers req{};
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = V4L2_MEMORY_MMAP;
+        xioctl(fd_, VIDIOC_REQBUFS, &req);
+    }
+
+    /**
+     * @brief 申请、映射缓冲并开流
+     */
+    bool start_streaming() {
+        v4l2_requestbuffers req{};
+        req.count = buffer_count_;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd_, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+            return false;
+        }
+        for (uint32_t i = 0; i < req.count; i++) {
+            v4l2_buffer buf{};
+            buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            buf.memory = V4L2_MEMORY_MMAP;
+            buf.index = i;
+            if (xioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0) {
+                return false;
+            }
+            Buffer buffer;
+            buffer.length = buf.length;
+            buffer.start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset);
+            if (buffer.start == MAP_FAILED) {
+                return false;
+            }
+            buffers_.push_back(buffer);
+            if (xioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+                return false;
+            }
+        }
+        int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (xioctl(fd_, VIDIOC_STREAMON, &type) < 0) {
+            return false;
+        }
+        streaming_ = true;
+        return true;
+    }
+
+    /**
+     * @brief 尺寸是否在驱动枚举的范围内
+     */
+    bool supports_size(uint32_t fourcc, int width, int height) const {
+        v4l2_frmsizeenum size{};
+        size.pixel_format = fourcc;
+        for (size.index = 0; xioctl(fd_, VIDIOC_ENUM_FRAMESIZES, &size) == 0; size.index++) {
+            if (size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+                if ((int)size.discrete.width == width && (int)size.discrete.height == height) {
+                    return true;
+                }
+                continue;
+            }
+            const v4l2_frmsize_stepwise& s = size.stepwise;  // 连续或步进范围
+            return width >= (int)s.min_width && width <= (int)s.max_width &&
+                   height >= (int)s.min_height && height <= (int)s.max_height &&
+                   (width - s.min_width) % max(1u, s.step_width) == 0 &&
+                   (height - s.min_height) % max(1u, s.step_height) == 0;
+        }
+        return size.index == 0;    // 驱动不支持枚举时不校验
+    }
+
+    /**
+     * @brief 帧率是否在驱动枚举的帧间隔内
+     */
+    bool supports_fps(uint32_t fourcc, int width, int height, double fps) const {
+        v4l2_frmivalenum ival{};
+        ival.pixel_format = fourcc;
+        ival.width = width;
+        ival.height = height;
+        for (ival.index = 0; xioctl(fd_, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0; ival.index++) {
+            if (ival.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
+                if (fabs(ival.discrete.denominator / (double)ival.discrete.numerator - fps) < 0.5) {
+                    return true;
+                }
+                continue;
+            }
+            double fps_max = ival.stepwise.min.denominator / (double)ival.stepwise.min.numerator;
+            double fps_min = ival.stepwise.max.denominator / (double)ival.stepwise.max.numerator;
+            return fps >= fps_min - 0.5 && fps <= fps_max + 0.5;
+        }
+        return ival.index == 0;
+    }
+
+public:
+    ~V4l2Camera() {
+        close();
+    }
+
+    /**
+     * @brief 打开/dev/videoN，成功后才关闭当前设备（失败时当前设备不受影响）
+     * @return 是否为支持流式采集的视频设备
+     */
+    bool open(int index) {
+        string path = "/dev/video" + to_string(index);
+        int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        v4l2_capability cap{};
+        uint32_t caps = 0;
+        if (xioctl(fd, VIDIOC_QUERYCAP, &cap) == 0) {
+            caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+        }
+        if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+            ::close(fd);
+            return false;
+        }
+        close();
+        fd_ = fd;
+        index_ = index;
+        return true;
+    }
+
+    /**
+     * @brief 停流并关闭设备
+     */
+    void close() {
+        release_buffers();
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = -1;
+        index_ = -1;
+    }
+
+    /**
+     * @brief 与另一摄像头交换设备（切换摄像头时使用）
+     */
+    void swap(V4l2Camera& other) {
+        std::swap(fd_, other.fd_);
+        std::swap(index_, other.index_);
+        std::swap(buffers_, other.buffers_);
+        std::swap(streaming_, other.streaming_);
+        std::swap(mode_, other.mode_);
+        std::swap(bytes_per_line_, other.bytes_per_line_);
+        std::swap(buffer_count_, other.buffer_count_);
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+    int index() const { return index_; }
+    const CaptureMode& mode() const { return mode_; }
+
+    /**
+     * @brief 设置采集缓冲数（下次配置时生效），越少延迟越低，越多越能容忍读取抖动
+     */
+    void set_buffer_count(int count) { buffer_count_ = max(2, count); }
+
+    /**
+     * @brief 校验驱动是否支持该模式
+     * @param reason 不支持时的原因
+     */
+    bool supports(const CaptureMode& mode, string& reason) const {
+        bool format = false;
+        v4l2_fmtdesc desc{};
+        desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        for (desc.index = 0; xioctl(fd_, VIDIOC_ENUM_FMT, &desc) == 0 && !format; desc.index++) {
+            format = desc.pixelformat == mode.fourcc;
+        }
+        if (!format) {
+            reason = "不支持像素格式 " + fourcc_name(mode.fourcc);
+        } else if (!supports_size(mode.fourcc, mode.width, mode.height)) {
+            reason = fourcc_name(mode.fourcc) + " 不支持分辨率 " + to_string(mode.width) + "x" + to_string(mode.height);
+        } else if (!supports_fps(mode.fourcc, mode.width, mode.height, mode.fps)) {
+            reason = fourcc_name(mode.fourcc) + " " + to_string(mode.width) + "x" + to_string(mode.height) +
+                     " 不支持帧率 " + to_string((int)mode.fps);
+        } else {
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 驱动支持的全部MJPG、YUYV模式（步进/连续范围只列出两端）
+     */
+    vector<CaptureMode> list_modes() const {
+        vector<CaptureMode> modes;
+        v4l2_fmtdesc desc{};
+        desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        for (desc.index = 0; xioctl(fd_, VIDIOC_ENUM_FMT, &desc) == 0; desc.index++) {
+            if (desc.pixelformat != V4L2_PIX_FMT_MJPEG && desc.pixelformat != V4L2_PIX_FMT_YUYV) {
+                continue;
+            }
+            v4l2_frmsizeenum size{};
+            size.pixel_format = desc.pixelformat;
+            for (size.index = 0; xioctl(fd_, VIDIOC_ENUM_FRAMESIZES, &size) == 0; size.index++) {
+                vector<pair<int, int>> sizes;
+                if (size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+                    sizes.push_back({(int)size.discrete.width, (int)size.discrete.height});
+                } else {
+                    sizes.push_back({(int)size.stepwise.min_width, (int)size.stepwise.min_height});
+                    sizes.push_back({(int)size.stepwise.max_width, (int)size.stepwise.max_height});
+                }
+                for (const auto& wh : sizes) {
+                    v4l2_frmivalenum ival{};
+                    ival.pixel_format = desc.pixelformat;
+                    ival.width = wh.first;
+                    ival.height = wh.second;
+                    for (ival.index = 0; xioctl(fd_, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0; ival.index++) {
+                        CaptureMode mode;
+                        mode.fourcc = desc.pixelformat;
+                        mode.width = wh.first;
+                        mode.height = wh.second;
+                        if (ival.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
+                            mode.fps = ival.discrete.denominator / (double)ival.discrete.numerator;
+                            modes.push_back(mode);
+                            continue;
+                        }
+                        mode.fps = ival.stepwise.min.denominator / (double)ival.stepwise.min.numerator;
+                        modes.push_back(mode);
+                        break;
+                    }
+                }
+                if (size.type != V4L2_FRMSIZE_TYPE_DISCRETE) {
+                    break;
+                }
+            }
+        }
+        return modes;
+    }
+
+    /**
+     * @brief 在当前设备句柄上重新配置：停流 → 释放缓冲 → 设置格式及帧率 → 申请缓冲 → 开流
+     * @return 是否成功，成功后mode()为驱动实际采用的模式
+     */
+    bool configure(const CaptureMode& mode) {
+        if (fd_ < 0) {
+            return false;
+        }
+        release_buffers();
+
+        v4l2_format fmt{};
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = mode.width;
+        fmt.fmt.pix.height = mode.height;
+        fmt.fmt.pix.pixelformat = mode.fourcc;
+        fmt.fmt.pix.field = V4L2_FIELD_ANY;
+        if (xioctl(fd_, VIDIOC_S_FMT, &fmt) < 0) {
+            return false;
+        }
+        mode_.fourcc = fmt.fmt.pix.pixelformat;
+        mode_.width = fmt.fmt.pix.width;
+        mode_.height = fmt.fmt.pix.height;
+        bytes_per_line_ = fmt.fmt.pix.bytesperline ? fmt.fmt.pix.bytesperline : mode_.width * 2;
+
+        v4l2_streamparm parm{};
+        parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        parm.parm.capture.timeperframe.numerator = 1000;
+        parm.parm.capture.timeperframe.denominator = (uint32_t)lround(mode.fps * 1000);
+        xioctl(fd_, VIDIOC_S_PARM, &parm);
+        mode_.fps = mode.fps;
+        if (xioctl(fd_, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0) {
+            mode_.fps = parm.parm.capture.timeperframe.denominator / (double)parm.parm.capture.timeperframe.numerator;
+        }
+
+        if (!start_streaming()) {
+            release_buffers();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读取一帧
+     * @param image 输出：MJPG为1xN的数据包，YUYV为BGR图像（均为新分配的内存）
+     * @param stamp 输出：采集时间（驱动时间戳为单调时钟时取驱动时间戳，否则取出队时间）
+     * @param timeout_ms 等待超时
+     * @return 是否读到
+     */
+    bool read(Mat& image, int64_t& stamp, int timeout_ms) {
+        if (!streaming_) {
+            return false;
+        }
+        pollfd pfd{fd_, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+            return false;
+        }
+        const uint8_t* data = static_cast<const uint8_t*>(buffers_[buf.index].start);
+        if (mode_.fourcc == V4L2_PIX_FMT_MJPEG) {
+            image = Mat(1, (int)buf.bytesused, CV_8UC1);
+            memcpy(image.data, data, buf.bytesused);
+        } else {
+            Mat yuyv(mode_.height, mode_.width, CV_8UC2, const_cast<uint8_t*>(data), bytes_per_line_);
+            cvtColor(yuyv, image, COLOR_YUV2BGR_YUYV);
+        }
+        if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+            stamp = buf.timestamp.tv_sec * 1000000000LL + buf.timestamp.tv_usec * 1000LL;
+        } else {
+            stamp = common::Now_Ns();
+        }
+        bool ok = buf.bytesused > 0;
+        xioctl(fd_, VIDIOC_QBUF, &buf);
+        return ok && !image.empty();
+    }
+};
+
 /**
  * @brief 录制配置结构体
  * @details 包含所有录制相关的参数设置
@@ -67,8 +463,27 @@ struct RecordingConfig {
     string filename_prefix = "recording_"; // 文件名前缀
     
     // 视频编码器设置
-    int fourcc_code = VideoWriter::fourcc('M', 'J', 'P', 'G'); // MJPG编码器
+    int fourcc_code = VideoWriter::fourcc('M', 'J', 'P', 'G'); // MJPG编码器（摄像头优先输出同一格式）
     string file_extension = ".avi"; // 文件扩展名
+
+    // 原始模式：直接保存摄像头输出的MJPEG数据包（不解码、不重新编码），写出.nsrec录制文件
+    bool raw_mjpeg = false;
+
+    // 采集与编码
+    int queue_size = 32;         // 采集线程到编码线程的队列容量（帧），队满时丢弃新帧
+    int preview_interval = 3;    // 每隔几帧更新一次预览
+    int preview_width = 640;     // 预览图像宽度（超过时缩小）
+    int buffer_count = 4;        // 驱动采集缓冲数
+};
+
+/**
+ * @brief 重新配置的结果
+ */
+struct ReconfigureReport {
+    bool ok = false;
+    string error;                // 失败原因
+    double switch_ms = 0;        // 停流到重新开流的用时
+    double first_frame_ms = 0;   // 停流到读到第一帧的用时
 };
 
 /**
@@ -80,18 +495,275 @@ enum class RecordingState {
     STOPPING    // 正在停止录制
 };
 
+/**
+ * @brief 采集到的一帧
+ */
+struct CapturedFrame {
+    Mat image;           // BGR图像，原始模式下为1xN的MJPEG数据包
+    int64_t stamp = 0;   // 采集时间（common::Now_Ns）
+    uint32_t id = 0;     // 帧序号（从1开始）
+
+    /**
+     * @brief 是否为MJPEG数据包
+     */
+    bool is_packet() const {
+        return image.rows == 1 && image.type() == CV_8UC1;
+    }
+};
+
+/**
+ * @brief 有界帧队列（采集线程 → 编码线程）
+ * @details 队满时入队失败而不阻塞采集；关闭后出队取完剩余帧再返回false
+ */
+class FrameQueue {
+private:
+    mutable mutex mutex_;
+    condition_variable cv_;
+    deque<CapturedFrame> queue_;
+    size_t capacity_;
+    bool closed_ = false;
+
+public:
+    explicit FrameQueue(size_t capacity) : capacity_(capacity) {}
+
+    /**
+     * @brief 入队
+     * @return 队满或已关闭时返回false
+     */
+    bool push(CapturedFrame&& frame) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (closed_ || queue_.size() >= capacity_) {
+                return false;
+            }
+            queue_.push_back(std::move(frame));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 出队，队空时等待
+     * @return 已关闭且取完时返回false
+     */
+    bool pop(CapturedFrame& frame) {
+        unique_lock<mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+        if (queue_.empty()) {
+            return false;
+        }
+        frame = std::move(queue_.front());
+        queue_.pop_front();
+        return true;
+    }
+
+    /**
+     * @brief 关闭队列，唤醒等待的编码线程
+     */
+    void close() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief 清空并重新打开队列
+     */
+    void reopen(size_t capacity) {
+        lock_guard<mutex> lock(mutex_);
+        queue_.clear();
+        capacity_ = capacity;
+        closed_ = false;
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const {
+        lock_guard<mutex> lock(mutex_);
+        return capacity_;
+    }
+};
+
+/**
+ * @brief 录制统计
+ */
+struct RecorderStats {
+    uint64_t captured = 0;        // 采集帧数
+    uint64_t encoded = 0;         // 本次录制已写出帧数
+    uint64_t dropped = 0;         // 本次录制因队列满丢弃的帧数
+    uint64_t writer_dropped = 0;  // 原始模式下录制文件写出队列满丢弃的帧数
+    size_t queue_depth = 0;       // 当前队列深度
+    size_t queue_capacity = 0;    // 队列容量
+    double encode_ms = 0;         // 平均每帧编码及写出耗时（毫秒）
+};
+
 /**
  * @brief 视频录制器类
  * @details 封装了摄像头操作和视频录制功能
+ *
+ * 采集线程独占摄像头，只负责取帧、打时间戳并放入有界队列，不做编码和绘制；
+ * 编码线程从队列取帧写入文件，编码慢于采集时队列积压，满后丢弃新帧并计数，采集节奏不受影响。
+ * 预览每隔preview_interval帧取一帧，由主线程缩小后绘制状态信息。
  */
 class VideoRecorder {
 private:
-    VideoCapture cap_;           // 摄像头捕获对象
-    VideoWriter writer_;         // 视频写入对象
+    V4l2Camera camera_;          // 摄像头（采集线程运行时仅由其读取）
+    VideoWriter writer_;         // 视频写入对象（仅编码线程访问）
+    common::RecordingWriter raw_writer_; // 原始模式的录制文件
     RecordingConfig config_;     // 录制配置
     RecordingState state_;       // 当前录制状态
     string current_filename_;    // 当前录制文件名
-    int frame_count_;           // 已录制帧数
+    int frame_width_ = 0;        // 摄像头实际输出尺寸
+    int frame_height_ = 0;
+
+    FrameQueue queue_;                   // 采集 → 编码
+    thread capture_thread_;              // 采集线程
+    thread encoder_thread_;              // 编码线程
+    atomic<bool> capture_running_{false};
+    atomic<bool> capture_failed_{false}; // 连续读取失败，摄像头已不可用
+    atomic<bool> recording_{false};      // 采集线程是否把帧放入队列
+
+    mutex preview_mutex_;                // 保护preview_
+    CapturedFrame preview_;              // 最新的预览帧（与队列共享图像数据，不拷贝）
+    uint32_t preview_shown_ = 0;         // 已显示的预览帧序号（仅主线程访问）
+
+    atomic<uint64_t> captured_{0};
+    atomic<uint64_t> encoded_{0};
+    atomic<uint64_t> dropped_{0};
+    atomic<int64_t> encode_ns_{0};       // 编码及写出总耗时
+    int64_t first_stamp_ = 0;            // 本次录制第一帧和最后一帧的采集时间（仅编码线程访问）
+    int64_t last_stamp_ = 0;
+
+    /**
+     * @brief 采集线程：取帧 → 时间戳 → 预览/入队
+     */
+    void capture_loop() {
+        uint32_t id = 0;
+        int failures = 0;
+        while (capture_running_) {
+            CapturedFrame frame;    // 每帧使用新的图像缓冲，队列中的帧不会被覆盖
+            if (!camera_.read(frame.image, frame.stamp, 1000)) {
+                if (++failures >= 50) {
+                    cerr << "错误：无法读取摄像头帧！" << endl;
+                    capture_failed_ = true;
+                    break;
+                }
+                this_thread::sleep_for(chrono::milliseconds(10));
+                continue;
+            }
+            failures = 0;
+            frame.id = ++id;
+            captured_.fetch_add(1, memory_order_relaxed);
+
+            if (frame.id % max(1, config_.preview_interval) == 0) {
+                lock_guard<mutex> lock(preview_mutex_);
+                preview_ = frame;
+            }
+            if (recording_ && !queue_.push(std::move(frame))) {
+                dropped_.fetch_add(1, memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief 编码线程：取帧编码并写出，队列关闭后写完剩余帧退出
+     */
+    void encoder_loop() {
+        CapturedFrame frame;
+        Mat decoded;
+        while (queue_.pop(frame)) {
+            int64_t start = common::Now_Ns();
+            if (config_.raw_mjpeg) {
+                raw_writer_.Write_Frame(frame.stamp, frame.id,
+                                        frame.is_packet() ? RECORDING_CODEC_MJPG : RECORDING_CODEC_BGR,
+                                        frame_width_, frame_height_, frame.image.data,
+                                        frame.image.total() * frame.image.elemSize());
+            } else if (frame.is_packet()) {
+                decoded = imdecode(frame.image, IMREAD_COLOR);  // MJPEG在编码线程解码，不占用采集线程
+                if (!decoded.empty()) {
+                    writer_.write(decoded);
+                }
+            } else {
+                writer_.write(frame.image);
+            }
+            encode_ns_.fetch_add(common::Now_Ns() - start, memory_order_relaxed);
+            if (first_stamp_ == 0) {
+                first_stamp_ = frame.stamp;
+            }
+            last_stamp_ = frame.stamp;
+
+            // 每100帧显示一次进度
+            uint64_t count = encoded_.fetch_add(1, memory_order_relaxed) + 1;
+            if (count % 100 == 0) {
+                cout << "已录制 " << count << " 帧" << endl;
+            }
+        }
+    }
+
+    /**
+     * @brief 启动采集线程
+     */
+    void start_capture() {
+        capture_failed_ = false;
+        capture_running_ = true;
+        capture_thread_ = thread(&VideoRecorder::capture_loop, this);
+    }
+
+    /**
+     * @brief 停止采集线程
+     */
+    void stop_capture() {
+        capture_running_ = false;
+        if (capture_thread_.joinable()) {
+            capture_thread_.join();
+        }
+    }
+
+    /**
+     * @brief 配置对应的采集模式
+     */
+    static CaptureMode requested_mode(const RecordingConfig& config) {
+        CaptureMode mode;
+        mode.fourcc = (uint32_t)config.fourcc_code;
+        mode.width = config.frame_width;
+        mode.height = config.frame_height;
+        mode.fps = config.fps;
+        return mode;
+    }
+
+    /**
+     * @brief 校验模式，摄像头不支持MJPG时改用YUYV
+     * @return 是否支持
+     */
+    static bool resolve_mode(const V4l2Camera& camera, CaptureMode& mode, string& reason) {
+        if (camera.supports(mode, reason)) {
+            return true;
+        }
+        string mjpg_reason = reason;
+        mode.fourcc = V4L2_PIX_FMT_YUYV;
+        if (camera.supports(mode, reason)) {
+            cout << mjpg_reason << "，使用YUYV格式" << endl;
+            return true;
+        }
+        reason = mjpg_reason;
+        return false;
+    }
+
+    /**
+     * @brief 按摄像头实际采用的模式更新配置
+     */
+    void apply_mode() {
+        const CaptureMode& mode = camera_.mode();
+        frame_width_ = config_.frame_width = mode.width;
+        frame_height_ = config_.frame_height = mode.height;
+        config_.fps = (int)lround(mode.fps);
+        config_.camera_index = camera_.index();
+    }
     
 public:
     /**
@@ -99,12 +771,13 @@ public:
      * @param config 录制配置参数
      */
     VideoRecorder(const RecordingConfig& config) 
-        : config_(config), state_(RecordingState::IDLE), frame_count_(0) {
+        : config_(config), state_(RecordingState::IDLE), queue_(max(1, config.queue_size)) {
         cout << "=== 视频录制器初始化 ===" << endl;
         cout << "摄像头索引: " << config_.camera_index << endl;
         cout << "分辨率: " << config_.frame_width << "x" << config_.frame_height << endl;
         cout << "帧率: " << config_.fps << " FPS" << endl;
         cout << "输出目录: " << config_.output_dir << endl;
+        cout << "录制模式: " << (config_.raw_mjpeg ? "原始MJPEG数据包(.nsrec)" : "重新编码") << endl;
     }
     
     /**
@@ -112,9 +785,8 @@ public:
      */
     ~VideoRecorder() {
         stop_recording();
-        if (cap_.isOpened()) {
-            cap_.release();
-        }
+        stop_capture();
+        camera_.close();
         cout << "视频录制器已关闭" << endl;
     }
     
@@ -122,15 +794,13 @@ public:
      * @brief 初始化摄像头
      * @return 初始化是否成功
      * 
-     * 尝试打开指定摄像头，如果失败则自动尝试其他摄像头
+     * 尝试打开指定摄像头，如果失败则自动尝试其他摄像头；成功后启动采集线程
      */
     bool initialize_camera() {
         cout << "\n正在初始化摄像头..." << endl;
         
         // 首先尝试打开指定摄像头
-        cap_.open(config_.camera_index, CAP_V4L2);
-        
-        if (!cap_.isOpened()) {
+        if (!camera_.open(config_.camera_index)) {
             cout << "指定摄像头 " << config_.camera_index << " 打开失败，尝试其他摄像头..." << endl;
             
             // 尝试常见的摄像头索引
@@ -139,66 +809,191 @@ public:
                 if (idx == config_.camera_index) continue;
                 
                 cout << "尝试摄像头 " << idx << "..." << endl;
-                cap_.open(idx, CAP_V4L2);
-                if (cap_.isOpened()) {
-                    config_.camera_index = idx;
+                if (camera_.open(idx)) {
                     cout << "成功打开摄像头 " << idx << endl;
                     break;
                 }
             }
         }
         
-        if (!cap_.isOpened()) {
+        if (!camera_.is_open()) {
             cerr << "错误：无法打开任何摄像头！" << endl;
             return false;
         }
         
-        // 设置摄像头参数
+        // 设置摄像头参数（优先使用MJPG以获得更高帧率）
         cout << "设置摄像头参数..." << endl;
-        
-        // 设置像素格式（优先使用MJPG以获得更高帧率）
-        bool mjpg_success = cap_.set(CAP_PROP_FOURCC, config_.fourcc_code);
-        if (!mjpg_success) {
-            cout << "MJPG设置失败，使用YUYV格式" << endl;
-            cap_.set(CAP_PROP_FOURCC, VideoWriter::fourcc('Y', 'U', 'Y', 'V'));
+        CaptureMode mode = requested_mode(config_);
+        string reason;
+        if (!resolve_mode(camera_, mode, reason)) {
+            cerr << "错误：" << reason << endl;
+            print_modes();
+            return false;
         }
+        camera_.set_buffer_count(config_.buffer_count);
+        if (!camera_.configure(mode)) {
+            cerr << "错误：摄像头参数设置失败！" << endl;
+            return false;
+        }
+        if (config_.raw_mjpeg && camera_.mode().fourcc != V4L2_PIX_FMT_MJPEG) {
+            cout << "摄像头不输出MJPEG，原始模式保存未压缩的BGR图像" << endl;
+        }
+        apply_mode();
         
-        // 设置分辨率
-        cap_.set(CAP_PROP_FRAME_WIDTH, config_.frame_width);
-        cap_.set(CAP_PROP_FRAME_HEIGHT, config_.frame_height);
-        
-        // 设置帧率
-        cap_.set(CAP_PROP_FPS, config_.fps);
-        
-        // 减少缓冲区大小以降低延迟
-        cap_.set(CAP_PROP_BUFFERSIZE, 1);
-        
-        // 验证设置是否生效
-        double actual_width = cap_.get(CAP_PROP_FRAME_WIDTH);
-        double actual_height = cap_.get(CAP_PROP_FRAME_HEIGHT);
-        double actual_fps = cap_.get(CAP_PROP_FPS);
-        
+        // 驱动实际采用的参数
         cout << "摄像头参数验证：" << endl;
-        cout << "  分辨率: " << actual_width << "x" << actual_height << endl;
-        cout << "  帧率: " << actual_fps << " FPS" << endl;
+        cout << "  格式: " << fourcc_name(camera_.mode().fourcc) << endl;
+        cout << "  分辨率: " << frame_width_ << "x" << frame_height_ << endl;
+        cout << "  帧率: " << camera_.mode().fps << " FPS" << endl;
         
         // 测试读取一帧
         Mat test_frame;
-        cap_ >> test_frame;
-        if (test_frame.empty()) {
+        int64_t stamp;
+        if (!camera_.read(test_frame, stamp, 2000)) {
             cerr << "错误：摄像头无法读取图像！" << endl;
             return false;
         }
         
+        // 启动采集线程
+        start_capture();
+        
         cout << "摄像头初始化成功！" << endl;
         return true;
     }
+
+    /**
+     * @brief 重新配置摄像头（序号、格式、分辨率、帧率），不重建录制器
+     * @details 同一摄像头在已打开的设备句柄上停流、设置、开流；切换摄像头时先打开并校验新设备，
+     *          成功后才替换，失败时保持原设置继续采集。录制中不允许重新配置。
+     * @param config 新配置（录制模式、队列等其余参数同时生效）
+     * @return 结果及用时
+     */
+    ReconfigureReport reconfigure(const RecordingConfig& config) {
+        ReconfigureReport report;
+        if (state_ == RecordingState::RECORDING) {
+            report.error = "录制中无法调整参数，请先停止录制";
+            return report;
+        }
+
+        // 先校验，不支持的模式不打断采集
+        V4l2Camera other;
+        V4l2Camera* target = &camera_;
+        if (config.camera_index != camera_.index()) {
+            if (!other.open(config.camera_index)) {
+                report.error = "无法打开摄像头 " + to_string(config.camera_index);
+                return report;
+            }
+            target = &other;
+        }
+        CaptureMode mode = requested_mode(config);
+        if (!resolve_mode(*target, mode, report.error)) {
+            return report;
+        }
+
+        int64_t start = common::Now_Ns();
+        stop_capture();
+        CaptureMode previous = camera_.mode();
+        target->set_buffer_count(config.buffer_count);
+        if (!target->configure(mode)) {
+            report.error = "摄像头参数设置失败";
+            if (target == &camera_) {
+                camera_.configure(previous);  // 恢复原设置
+            }
+            start_capture();
+            return report;
+        }
+        if (target == &other) {
+            camera_.swap(other);    // 原设备在other析构时关闭
+        }
+        report.switch_ms = (common::Now_Ns() - start) / 1e6;
+
+        Mat first;
+        int64_t stamp;
+        report.ok = camera_.read(first, stamp, 2000);
+        report.first_frame_ms = (common::Now_Ns() - start) / 1e6;
+        if (!report.ok) {
+            report.error = "重新配置后无法读取图像";
+        }
+
+        config_ = config;
+        queue_.reopen(max(1, config_.queue_size));
+        apply_mode();
+        start_capture();
+        return report;
+    }
+
+    /**
+     * @brief 打印摄像头支持的模式
+     */
+    void print_modes() const {
+        cout << "\n=== 摄像头 " << camera_.index() << " 支持的模式 ===" << endl;
+        for (const CaptureMode& mode : camera_.list_modes()) {
+            cout << "  " << fourcc_name(mode.fourcc) << " " << mode.width << "x" << mode.height
+                 << " @ " << mode.fps << " FPS" << endl;
+        }
+    }
+
+    /**
+     * @brief 依次切换到摄像头支持的每个模式，测量切换用时、实际帧率及采集延迟，结束后恢复原模式
+     * @param frames 每个模式测量的帧数
+     * @details 采集延迟为驱动时间戳到读出的时间，驱动时间戳不是单调时钟时不统计
+     */
+    void sweep_modes(int frames = 30) {
+        if (state_ == RecordingState::RECORDING) {
+            cout << "录制中无法扫描模式，请先停止录制" << endl;
+            return;
+        }
+        stop_capture();
+        CaptureMode original = camera_.mode();
+        printf("\n%-5s %-10s %7s %9s %9s %9s %10s\n", "格式", "分辨率", "设定FPS", "实际FPS",
+               "切换ms", "首帧ms", "延迟ms");
+        for (const CaptureMode& mode : camera_.list_modes()) {
+            char size[24];
+            snprintf(size, sizeof(size), "%dx%d", mode.width, mode.height);
+            int64_t start = common::Now_Ns();
+            if (!camera_.configure(mode)) {
+                printf("%-5s %-10s %7.1f  设置失败\n", fourcc_name(mode.fourcc).c_str(), size, mode.fps);
+                continue;
+            }
+            double switch_ms = (common::Now_Ns() - start) / 1e6;
+            double first_ms = 0, latency_ms = 0;
+            int64_t first_stamp = 0, last_stamp = 0;
+            int count = 0, latency_count = 0;
+            Mat image;
+            int64_t stamp;
+            for (int k = 0; k < frames && camera_.read(image, stamp, 1000); k++) {
+                int64_t now = common::Now_Ns();
+                if (k == 0) {
+                    first_ms = (now - start) / 1e6;
+                    first_stamp = stamp;
+                }
+                last_stamp = stamp;
+                count++;
+                if (stamp <= now && now - stamp < 1000000000LL) {
+                    latency_ms += (now - stamp) / 1e6;
+                    latency_count++;
+                }
+            }
+            double fps = count > 1 && last_stamp > first_stamp ? (count - 1) * 1e9 / (last_stamp - first_stamp) : 0;
+            printf("%-5s %-10s %7.1f %9.1f %9.1f %9.1f %10.2f\n", fourcc_name(mode.fourcc).c_str(), size,
+                   mode.fps, fps, switch_ms, first_ms, latency_count ? latency_ms / latency_count : 0.0);
+        }
+        camera_.configure(original);
+        start_capture();
+    }
+
+    /**
+     * @brief 获取当前配置（摄像头实际采用的参数）
+     */
+    const RecordingConfig& get_config() const {
+        return config_;
+    }
     
     /**
      * @brief 开始录制视频
      * @return 录制是否成功开始
      * 
-     * 创建视频文件并开始写入帧数据
+     * 创建视频文件并启动编码线程
      */
     bool start_recording() {
         if (state_ == RecordingState::RECORDING) {
@@ -208,22 +1003,37 @@ public:
         
         // 生成带时间戳的文件名
         string timestamp = generate_timestamp();
-        current_filename_ = config_.output_dir + config_.filename_prefix + timestamp + config_.file_extension;
+        string extension = config_.raw_mjpeg ? string(RECORDING_EXTENSION) : config_.file_extension;
+        current_filename_ = config_.output_dir + config_.filename_prefix + timestamp + extension;
         
         cout << "\n开始录制视频..." << endl;
         cout << "文件名: " << current_filename_ << endl;
         
-        // 创建视频写入器
-        writer_.open(current_filename_, config_.fourcc_code, config_.fps, 
-                    Size(config_.frame_width, config_.frame_height), true);
+        // 创建视频写入器（按摄像头实际输出尺寸）
+        bool opened;
+        if (config_.raw_mjpeg) {
+            stringstream snapshot;
+            snapshot << "{\"Camera_Index\": " << config_.camera_index << ", \"Camera_Width\": " << frame_width_
+                     << ", \"Camera_Height\": " << frame_height_ << ", \"Camera_FPS\": " << config_.fps << "}";
+            opened = raw_writer_.Open(current_filename_, snapshot.str());
+        } else {
+            opened = writer_.open(current_filename_, config_.fourcc_code, config_.fps,
+                                  Size(frame_width_, frame_height_), true);
+        }
         
-        if (!writer_.isOpened()) {
+        if (!opened) {
             cerr << "错误：无法创建视频文件！" << endl;
             return false;
         }
         
+        encoded_ = 0;
+        dropped_ = 0;
+        encode_ns_ = 0;
+        first_stamp_ = last_stamp_ = 0;
+        queue_.reopen(max(1, config_.queue_size));
+        encoder_thread_ = thread(&VideoRecorder::encoder_loop, this);
+        recording_ = true;
         state_ = RecordingState::RECORDING;
-        frame_count_ = 0;
         
         cout << "录制已开始，按 's' 停止录制" << endl;
         return true;
@@ -233,7 +1043,7 @@ public:
      * @brief 停止录制视频
      * @return 停止是否成功
      * 
-     * 关闭视频文件并显示录制统计信息
+     * 停止入队，等待编码线程写完队列中的帧后关闭文件，显示录制统计信息
      */
     bool stop_recording() {
         if (state_ != RecordingState::RECORDING) {
@@ -241,39 +1051,78 @@ public:
         }
         
         cout << "\n停止录制..." << endl;
+        state_ = RecordingState::STOPPING;
+        recording_ = false;
+        queue_.close();
+        if (encoder_thread_.joinable()) {
+            encoder_thread_.join();
+        }
         
         // 关闭视频写入器
-        writer_.release();
+        uint64_t writer_dropped = raw_writer_.Dropped();
+        if (config_.raw_mjpeg) {
+            raw_writer_.Close();
+        } else {
+            writer_.release();
+        }
         
         state_ = RecordingState::IDLE;
         
+        uint64_t frames = encoded_;
         cout << "录制完成！" << endl;
         cout << "文件保存为: " << current_filename_ << endl;
-        cout << "总帧数: " << frame_count_ << endl;
-        cout << "录制时长: " << (frame_count_ / (double)config_.fps) << " 秒" << endl;
+        cout << "总帧数: " << frames << "，丢弃: " << dropped_ << (config_.raw_mjpeg ? "，写出丢弃: " : "")
+             << (config_.raw_mjpeg ? to_string(writer_dropped) : "") << endl;
+        cout << "录制时长: " << (last_stamp_ - first_stamp_) / 1e9 << " 秒" << endl;
+        if (frames > 0) {
+            cout << "平均编码耗时: " << encode_ns_ / 1e6 / frames << " ms/帧" << endl;
+        }
         
         return true;
     }
-    
+
     /**
-     * @brief 处理一帧图像
-     * @param frame 当前帧图像
-     * @return 处理是否成功
-     * 
-     * 如果正在录制，将帧写入视频文件
+     * @brief 取最新的预览帧（主线程调用）
+     * @param preview 输出预览图像（缩小到preview_width，可直接绘制）
+     * @return 是否有新的预览帧
      */
-    bool process_frame(const Mat& frame) {
-        if (state_ == RecordingState::RECORDING) {
-            writer_.write(frame);
-            frame_count_++;
-            
-            // 每100帧显示一次进度
-            if (frame_count_ % 100 == 0) {
-                cout << "已录制 " << frame_count_ << " 帧" << endl;
+    bool take_preview(Mat& preview) {
+        CapturedFrame frame;
+        {
+            lock_guard<mutex> lock(preview_mutex_);
+            if (preview_.id == preview_shown_) {
+                return false;
             }
+            frame = preview_;
+        }
+        preview_shown_ = frame.id;
+
+        Mat image = frame.is_packet() ? imdecode(frame.image, IMREAD_REDUCED_COLOR_2) : frame.image;
+        if (image.empty()) {
+            return false;
+        }
+        if (image.cols > config_.preview_width) {
+            resize(image, preview, Size(config_.preview_width, image.rows * config_.preview_width / image.cols));
+        } else {
+            image.copyTo(preview);  // 预览帧与队列共享数据，绘制前拷贝
         }
         return true;
     }
+
+    /**
+     * @brief 获取录制统计
+     */
+    RecorderStats get_stats() {
+        RecorderStats stats;
+        stats.captured = captured_;
+        stats.encoded = encoded_;
+        stats.dropped = dropped_;
+        stats.writer_dropped = config_.raw_mjpeg ? raw_writer_.Dropped() : 0;
+        stats.queue_depth = queue_.size();
+        stats.queue_capacity = queue_.capacity();
+        stats.encode_ms = stats.encoded > 0 ? encode_ns_ / 1e6 / stats.encoded : 0;
+        return stats;
+    }
     
     /**
      * @brief 获取当前录制状态
@@ -283,23 +1132,41 @@ public:
         return state_;
     }
     
-    /**
-     * @brief 获取摄像头对象
-     * @return 摄像头引用
-     */
-    VideoCapture& get_camera() {
-        return cap_;
-    }
-    
     /**
      * @brief 检查摄像头是否打开
      * @return 摄像头是否可用
      */
     bool is_camera_open() const {
-        return cap_.isOpened();
+        return camera_.is_open() && !capture_failed_;
     }
 };
 
+/**
+ * @brief 在预览图像上绘制录制状态及统计信息
+ * @param preview 预览图像
+ * @param state 录制状态
+ * @param stats 录制统计
+ * @param capture_fps 采集帧率
+ */
+void draw_status(Mat& preview, RecordingState state, const RecorderStats& stats, double capture_fps) {
+    bool recording = state == RecordingState::RECORDING;
+    Scalar text_color = recording ? Scalar(0, 0, 255) : Scalar(0, 255, 0);  // 红色 / 绿色
+    putText(preview, recording ? "recording..." : "idle...", Point(10, 30),
+            FONT_HERSHEY_SIMPLEX, 1.0, text_color, 2);
+
+    char line[128];
+    snprintf(line, sizeof(line), "capture %.1f fps  frames %llu", capture_fps, (unsigned long long)stats.captured);
+    putText(preview, line, Point(10, 60), FONT_HERSHEY_SIMPLEX, 0.6, text_color, 1);
+    if (recording) {
+        snprintf(line, sizeof(line), "queue %zu/%zu  written %llu  dropped %llu",
+                 stats.queue_depth, stats.queue_capacity, (unsigned long long)stats.encoded,
+                 (unsigned long long)(stats.dropped + stats.writer_dropped));
+        putText(preview, line, Point(10, 85), FONT_HERSHEY_SIMPLEX, 0.6, text_color, 1);
+        snprintf(line, sizeof(line), "encode %.2f ms/frame", stats.encode_ms);
+        putText(preview, line, Point(10, 110), FONT_HERSHEY_SIMPLEX, 0.6, text_color, 1);
+    }
+}
+
 /**
  * @brief 显示帮助信息
  */
@@ -321,7 +1188,10 @@ void show_help() {
     cout << "  'd' - 减少分辨率高度 (-120)" << endl;
     cout << "  'f' - 增加帧率 (+10)" << endl;
     cout << "  'g' - 减少帧率 (-10)" << endl;
+    cout << "  'm' - 切换原始MJPEG模式" << endl;
     cout << "  'i' - 显示当前参数" << endl;
+    cout << "  'l' - 列出摄像头支持的模式" << endl;
+    cout << "  'x' - 扫描全部模式的切换用时、实际帧率及采集延迟" << endl;
     cout << "===============================" << endl;
 }
 
@@ -337,9 +1207,29 @@ void show_current_params(const RecordingConfig& config, int current_camera) {
     cout << "帧率: " << config.fps << " FPS" << endl;
     cout << "输出目录: " << config.output_dir << endl;
     cout << "文件名前缀: " << config.filename_prefix << endl;
+    cout << "录制模式: " << (config.raw_mjpeg ? "原始MJPEG数据包(.nsrec)" : "重新编码") << endl;
+    cout << "队列容量: " << config.queue_size << " 帧" << endl;
     cout << "===============================" << endl;
 }
 
+/**
+ * @brief 重新配置录制器并报告用时，失败时保持原配置
+ * @param recorder 录制器
+ * @param config 当前配置，成功后更新为摄像头实际采用的参数
+ * @param next 新配置
+ */
+void apply_config(VideoRecorder& recorder, RecordingConfig& config, const RecordingConfig& next) {
+    ReconfigureReport report = recorder.reconfigure(next);
+    if (!report.ok) {
+        cerr << "参数调整失败: " << report.error << endl;
+        return;
+    }
+    config = recorder.get_config();
+    cout << "重新配置完成: " << config.frame_width << "x" << config.frame_height << " @ " << config.fps
+         << " FPS，切换 " << fixed << setprecision(1) << report.switch_ms << " ms，首帧 "
+         << report.first_frame_ms << " ms" << defaultfloat << endl;
+}
+
 /**
  * @brief 主函数
  * @return 程序退出码
@@ -372,6 +1262,7 @@ int main() {
         cerr << "摄像头初始化失败，程序退出" << endl;
         return -1;
     }
+    config = recorder.get_config();     // 摄像头实际采用的参数
     
     // 显示帮助信息
     show_help();
@@ -381,42 +1272,34 @@ int main() {
     
     cout << "\n程序已启动，等待用户操作..." << endl;
     
-    // 主循环
+    // 主循环：只显示降频后的预览并处理按键，采集和编码在各自线程中进行
+    int64_t fps_start = common::Now_Ns();
+    uint64_t fps_frames = recorder.get_stats().captured;
+    double capture_fps = 0;
     while (true) {
-        // 读取摄像头帧
-        Mat frame;
-        recorder.get_camera() >> frame;
-        
-        if (frame.empty()) {
-            cerr << "错误：无法读取摄像头帧！" << endl;
+        if (!recorder.is_camera_open()) {
+            cerr << "错误：摄像头不可用！" << endl;
             break;
         }
         
-        // 处理帧（如果正在录制则写入文件）
-        recorder.process_frame(frame);
+        // 统计采集帧率（每秒更新）
+        RecorderStats stats = recorder.get_stats();
+        int64_t now = common::Now_Ns();
+        if (now - fps_start >= 1000000000LL) {
+            capture_fps = (stats.captured - fps_frames) * 1e9 / (now - fps_start);
+            fps_start = now;
+            fps_frames = stats.captured;
+        }
         
         // 在预览窗口上添加状态信息
-        Mat display_frame = frame.clone();
-        string status_text;
-        Scalar text_color;
-        
-        if (recorder.get_state() == RecordingState::RECORDING) {
-            status_text = "recording...";
-            text_color = Scalar(0, 0, 255); // 红色
-        } else {
-            status_text = "idle...";
-            text_color = Scalar(0, 255, 0); // 绿色
+        Mat preview;
+        if (recorder.take_preview(preview)) {
+            draw_status(preview, recorder.get_state(), stats, capture_fps);
+            imshow("视频录制预览", preview);
         }
         
-        // 在图像上绘制状态文本
-        putText(display_frame, status_text, Point(10, 30), 
-                FONT_HERSHEY_SIMPLEX, 1.0, text_color, 2);
-        
-        // 显示预览
-        imshow("视频录制预览", display_frame);
-        
         // 处理键盘输入
-        char key = waitKey(1) & 0xFF;
+        char key = waitKey(5) & 0xFF;
         
         switch (key) {
             case 'r': // 开始录制
@@ -443,167 +1326,69 @@ int main() {
                 show_current_params(config, config.camera_index);
                 break;
                 
-            // 摄像头切换
-            case '1': // 切换到摄像头 0
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    cout << "\n尝试切换到摄像头 0..." << endl;
-                    config.camera_index = 0;
-                    // 重新创建录制器
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "摄像头 0 初始化失败！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法切换摄像头，请先停止录制" << endl;
-                }
+            case 'l': // 列出摄像头支持的模式
+                recorder.print_modes();
                 break;
                 
-            case '2': // 切换到摄像头 1
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    cout << "\n尝试切换到摄像头 1..." << endl;
-                    config.camera_index = 1;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "摄像头 1 初始化失败！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法切换摄像头，请先停止录制" << endl;
-                }
+            case 'x': // 扫描全部模式的切换用时和采集延迟
+                recorder.sweep_modes();
                 break;
                 
+            // 摄像头切换
+            case '1': // 切换到摄像头 0
+            case '2': // 切换到摄像头 1
             case '3': // 切换到摄像头 2
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    cout << "\n尝试切换到摄像头 2..." << endl;
-                    config.camera_index = 2;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "摄像头 2 初始化失败！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法切换摄像头，请先停止录制" << endl;
-                }
-                break;
-                
             case '4': // 切换到摄像头 3
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    cout << "\n尝试切换到摄像头 3..." << endl;
-                    config.camera_index = 3;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "摄像头 3 初始化失败！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法切换摄像头，请先停止录制" << endl;
-                }
+            {
+                RecordingConfig next = config;
+                next.camera_index = key - '1';
+                cout << "\n尝试切换到摄像头 " << next.camera_index << "..." << endl;
+                apply_config(recorder, config, next);
                 break;
+            }
                 
             // 分辨率调整
             case 'w': // 增加宽度
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    config.frame_width += 160;
-                    cout << "分辨率宽度调整为: " << config.frame_width << endl;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "参数调整后摄像头初始化失败！" << endl;
-                        config.frame_width -= 160; // 回滚
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
-                }
-                break;
-                
             case 'e': // 减少宽度
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    if (config.frame_width > 160) {
-                        config.frame_width -= 160;
-                        cout << "分辨率宽度调整为: " << config.frame_width << endl;
-                        recorder.~VideoRecorder();
-                        new (&recorder) VideoRecorder(config);
-                        if (!recorder.initialize_camera()) {
-                            cerr << "参数调整后摄像头初始化失败！" << endl;
-                            config.frame_width += 160; // 回滚
-                        }
-                    } else {
-                        cout << "分辨率宽度已达到最小值！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
-                }
-                break;
-                
             case 'a': // 增加高度
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    config.frame_height += 120;
-                    cout << "分辨率高度调整为: " << config.frame_height << endl;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "参数调整后摄像头初始化失败！" << endl;
-                        config.frame_height -= 120; // 回滚
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
-                }
-                break;
-                
             case 'd': // 减少高度
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    if (config.frame_height > 120) {
-                        config.frame_height -= 120;
-                        cout << "分辨率高度调整为: " << config.frame_height << endl;
-                        recorder.~VideoRecorder();
-                        new (&recorder) VideoRecorder(config);
-                        if (!recorder.initialize_camera()) {
-                            cerr << "参数调整后摄像头初始化失败！" << endl;
-                            config.frame_height += 120; // 回滚
-                        }
-                    } else {
-                        cout << "分辨率高度已达到最小值！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
+            {
+                RecordingConfig next = config;
+                next.frame_width += key == 'w' ? 160 : key == 'e' ? -160 : 0;
+                next.frame_height += key == 'a' ? 120 : key == 'd' ? -120 : 0;
+                if (next.frame_width < 160 || next.frame_height < 120) {
+                    cout << "分辨率已达到最小值！" << endl;
+                    break;
                 }
+                cout << "分辨率调整为: " << next.frame_width << "x" << next.frame_height << endl;
+                apply_config(recorder, config, next);
                 break;
+            }
                 
             // 帧率调整
             case 'f': // 增加帧率
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    config.fps += 10;
-                    cout << "帧率调整为: " << config.fps << " FPS" << endl;
-                    recorder.~VideoRecorder();
-                    new (&recorder) VideoRecorder(config);
-                    if (!recorder.initialize_camera()) {
-                        cerr << "参数调整后摄像头初始化失败！" << endl;
-                        config.fps -= 10; // 回滚
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
+            case 'g': // 减少帧率
+            {
+                RecordingConfig next = config;
+                next.fps += key == 'f' ? 10 : -10;
+                if (next.fps < 10) {
+                    cout << "帧率已达到最小值！" << endl;
+                    break;
                 }
+                cout << "帧率调整为: " << next.fps << " FPS" << endl;
+                apply_config(recorder, config, next);
                 break;
+            }
                 
-            case 'g': // 减少帧率
-                if (recorder.get_state() != RecordingState::RECORDING) {
-                    if (config.fps > 10) {
-                        config.fps -= 10;
-                        cout << "帧率调整为: " << config.fps << " FPS" << endl;
-                        recorder.~VideoRecorder();
-                        new (&recorder) VideoRecorder(config);
-                        if (!recorder.initialize_camera()) {
-                            cerr << "参数调整后摄像头初始化失败！" << endl;
-                            config.fps += 10; // 回滚
-                        }
-                    } else {
-                        cout << "帧率已达到最小值！" << endl;
-                    }
-                } else {
-                    cout << "录制中无法调整参数，请先停止录制" << endl;
-                }
+            // 录制模式
+            case 'm': // 切换原始MJPEG模式
+            {
+                RecordingConfig next = config;
+                next.raw_mjpeg = !next.raw_mjpeg;
+                cout << "录制模式调整为: " << (next.raw_mjpeg ? "原始MJPEG数据包" : "重新编码") << endl;
+                apply_config(recorder, config, next);
                 break;
+            }
                 
             default:
                 break;
@@ -0,0 +1,144 @@
+/**
+ * @file flight_decode.cpp
+ * @brief 飞行记录解析工具
+ * @details 读取主程序飞行记录仪保存的flight_*.nsfr文件，按帧打印处理状态，
+ *          或导出CSV及gnuplot脚本绘制各阶段耗时、控制中心、速度和舵机PWM曲线
+ *
+ * 使用方法：
+ * - flight_decode flight_20250101_120000.nsfr              打印全部帧
+ * - flight_decode flight.nsfr -last 100                    只打印最后100帧
+ * - flight_decode flight.nsfr -csv out.csv                 导出CSV
+ * - flight_decode flight.nsfr -plot crash                  生成crash.csv和crash.gp，gnuplot crash.gp 出图
+ */
+
+#include "common/flightrecorder.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace common;
+using namespace std;
+
+/**
+ * @brief 写CSV，时间相对第一帧（毫秒），阶段耗时为毫秒
+ */
+static void Write_Csv(ostream& out, const vector<Flight_Record>& records, size_t first)
+{
+    out << "frame,time_ms,latency_ms";
+    for(int i = 0; i < FLIGHT_STAGES; i++)
+        out << "," << Profiler::Name((Stage)i) << "_ms";
+    out << ",scene,start_left,start_right,start_y,control_center,middle_error,speed,measured_speed,sigma,pwm"
+           ",fit_valid,telemetry,rx_errors,tx_dropped,coalesced" << endl;
+    int64_t t0 = records.empty() ? 0 : records[first].stamp_ns;
+    char line[512];
+    for(size_t k = first; k < records.size(); k++)
+    {
+        const Flight_Record& r = records[k];
+        string scene(r.scene, strnlen(r.scene, FLIGHT_SCENE_LENGTH));
+        out << r.frame_id;
+        snprintf(line, sizeof(line), ",%.3f,%.3f", (r.stamp_ns - t0) / 1e6,
+                 r.capture_ns ? (r.stamp_ns - r.capture_ns) / 1e6 : 0.0);
+        out << line;
+        for(int i = 0; i < FLIGHT_STAGES; i++)
+        {
+            snprintf(line, sizeof(line), ",%.3f", r.stage_ns[i] / 1e6);
+            out << line;
+        }
+        snprintf(line, sizeof(line), ",%s,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.1f,%u,%d,%d,%u,%u,%u",
+                 scene.c_str(), r.start_left_x, r.start_right_x, r.start_y, r.control_center,
+                 r.middle_error, r.speed, r.measured_speed, r.sigma, r.servo_pwm,
+                 (r.flags & FLIGHT_FIT_VALID) ? 1 : 0, (r.flags & FLIGHT_TELEMETRY) ? 1 : 0,
+                 r.uart_rx_errors, r.uart_tx_dropped, r.uart_coalesced);
+        out << line << endl;
+    }
+}
+
+/**
+ * @brief 生成gnuplot脚本：阶段耗时、控制中心与误差、速度与PWM三幅子图
+ */
+static void Write_Plot(const string& prefix)
+{
+    ofstream gp(prefix + ".gp");
+    gp << "set datafile separator ','\n"
+       << "set key autotitle columnhead outside right\n"
+       << "set terminal pngcairo size 1400,1000\n"
+       << "set output '" << prefix << ".png'\n"
+       << "set multiplot layout 3,1\n"
+       << "set ylabel 'ms'\n"
+       << "plot for [i=4:" << 3 + FLIGHT_STAGES << "] '" << prefix << ".csv' using 1:i with lines\n"
+       << "set ylabel 'px'\n"
+       << "plot '" << prefix << ".csv' using 1:" << 8 + FLIGHT_STAGES << " with lines, "    // 控制中心
+       << "'' using 1:" << 9 + FLIGHT_STAGES << " with lines\n"                               // 中线误差
+       << "set ylabel 'm/s'\n"
+       << "set y2label 'PWM'\n"
+       << "set y2tics\n"
+       << "plot '" << prefix << ".csv' using 1:" << 10 + FLIGHT_STAGES << " with lines, "   // 目标速度
+       << "'' using 1:" << 11 + FLIGHT_STAGES << " with lines, "                              // 实测速度
+       << "'' using 1:" << 13 + FLIGHT_STAGES << " axes x1y2 with lines\n"
+       << "unset multiplot\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        cout << "用法: " << argv[0] << " <记录文件> [-last N] [-csv 文件] [-plot 前缀]" << endl;
+        return 1;
+    }
+    string path = argv[1];
+    string csv, plot;
+    size_t last = 0;
+    for(int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "-last" && i + 1 < argc)
+            last = stoul(argv[++i]);
+        else if(arg == "-csv" && i + 1 < argc)
+            csv = argv[++i];
+        else if(arg == "-plot" && i + 1 < argc)
+            plot = argv[++i];
+    }
+
+    vector<Flight_Record> records;
+    if(!FlightRecorder::Load(path, records))
+    {
+        cerr << "无法读取飞行记录: " << path << endl;
+        return 1;
+    }
+    size_t first = last > 0 && last < records.size() ? records.size() - last : 0;
+    cout << "记录帧数: " << records.size() << "，显示: " << records.size() - first << endl;
+
+    if(!csv.empty())
+    {
+        ofstream out(csv);
+        Write_Csv(out, records, first);
+        cout << "已导出: " << csv << endl;
+    }
+    if(!plot.empty())
+    {
+        ofstream out(plot + ".csv");
+        Write_Csv(out, records, first);
+        Write_Plot(plot);
+        cout << "已生成: " << plot << ".csv " << plot << ".gp（gnuplot " << plot << ".gp 生成 " << plot << ".png）" << endl;
+    }
+    if(csv.empty() && plot.empty())
+    {
+        // 表格：帧、整帧及主要阶段耗时、场景、控制量和串口状态
+        printf("%8s %8s %7s %7s %7s %7s %-14s %5s %8s %6s %6s %5s %4s %4s\n",
+               "frame", "frame_ms", "track", "edge", "elem", "fit", "scene", "cc", "error", "speed", "meas", "pwm", "rxE", "txD");
+        for(size_t k = first; k < records.size(); k++)
+        {
+            const Flight_Record& r = records[k];
+            string scene(r.scene, strnlen(r.scene, FLIGHT_SCENE_LENGTH));
+            printf("%8u %8.3f %7.3f %7.3f %7.3f %7.3f %-14s %5d %8.2f %6.2f %6.2f %5u %4u %4u%s\n",
+                   r.frame_id, r.stage_ns[(int)Stage::Frame] / 1e6,
+                   r.stage_ns[(int)Stage::Track_Recognition] / 1e6, r.stage_ns[(int)Stage::Edge_Extract] / 1e6,
+                   r.stage_ns[(int)Stage::Recognition_Element] / 1e6, r.stage_ns[(int)Stage::Fitting] / 1e6,
+                   scene.c_str(), r.control_center, r.middle_error, r.speed, r.measured_speed, r.servo_pwm,
+                   r.uart_rx_errors, r.uart_tx_dropped, (r.flags & FLIGHT_FIT_VALID) ? "" : " 拟合无效");
+        }
+    }
+    return 0;
+}
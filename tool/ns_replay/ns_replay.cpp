@@ -0,0 +1,315 @@
+/**
+ * @file ns_replay.cpp
+ * @brief 离线回放工具
+ * @details 把录制的视频、运行录制文件(.nsrec)或图片目录逐帧送入与主程序相同的处理流水线
+ *          （巡线 → 元素识别 → 中线拟合 → 速度规划 → 控制周期），不休眠、不显示，
+ *          逐帧结果（边线、场景、控制量）写入.nsrp文件，结束时输出吞吐量及分阶段耗时。
+ *          控制周期按帧序号生成的时间驱动，同一输入和参数的结果逐帧可复现，
+ *          可与基准结果比较，不一致时返回2，供回归测试使用。
+ *
+ *          多个输入或多组参数时为批量回放：每个（输入, 参数组）是一个独立任务，
+ *          由线程池分配到各核，每个任务有自己的流水线和统计对象；
+ *          同一输入被多组参数使用时只解码一次，各任务只读共享解码后的帧。
+ *          指定-cache时使用预处理帧缓存（映射的缩放后灰度帧或二值帧），不再解码和预处理，
+ *          预处理参数或输入变化后缓存自动重建。
+ *          运行录制文件先应用其中的参数快照（-params仍优先），控制周期取录制的采集时间。
+ *
+ * 使用方法（在build/bin下运行，读取../../config/config.json）：
+ * - ns_replay ../../res/samples/sample.mp4                  回放视频，结果写入replay.nsrp
+ * - ns_replay ../../res/samples/ -o folder.nsrp             回放图片目录
+ * - ns_replay sample.mp4 -compare golden.nsrp -tolerance 1  与基准比较
+ * - ns_replay sample.mp4 -max 500 -perf -trace replay.json  只回放前500帧，统计硬件计数器并输出trace
+ * - ns_replay a.mp4 b.mp4 c/ -d out -baseline-dir golden    批量回放并逐个与golden下同名文件比较
+ *   （输入文件名相同时结果文件名追加输入序号，如run_0.nsrp、run_1.nsrp）
+ * - ns_replay a.mp4 -params sets.json -j 8                  按sets.json中的每组参数各回放一次
+ * - ns_replay a.mp4 -cache cache/                           首次生成预处理缓存，之后直接读取缓存
+ * - ns_replay run.nsrec -o run.nsrp                         回放实车运行录制
+ *
+ * sets.json为参数对象的数组，如 [{"threshold": 120}, {"threshold": 135, "Speed_High": 2.0}]
+ */
+
+#include "task/pipeline.hpp"
+#include "task/replay.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace common;
+using namespace task;
+using namespace std;
+
+static void Print_Diff(const Replay_Diff& diff)
+{
+    printf("比较帧数: %zu  帧数差: %zu\n", diff.frames, diff.frame_count_delta);
+    printf("场景不一致: %zu  边线不一致: %zu  控制不一致: %zu\n", diff.scene_mismatch, diff.edge_mismatch, diff.control_mismatch);
+    printf("最大偏差 控制中心: %d px  边线: %d px  PWM: %d\n", diff.max_center_delta, diff.max_edge_delta, diff.max_pwm_delta);
+    if(diff.first_mismatch)
+        printf("第一个不一致的帧: %u\n", diff.first_mismatch);
+}
+
+/**
+ * @brief 输入的文件名（不含目录和扩展名），用于生成结果文件名
+ */
+static string Stem(string source)
+{
+    while(source.size() > 1 && source.back() == '/')
+        source.pop_back();
+    size_t slash = source.find_last_of('/');
+    string name = slash == string::npos ? source : source.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        cout << "用法: " << argv[0] << " <视频文件|录制文件|图片目录>... [-o 结果文件] [-compare 基准文件] [-tolerance N]"
+                " [-max 帧数] [-fps 帧率] [-perf] [-trace 文件] [-v]\n"
+                "       批量: [-d 结果目录] [-baseline-dir 基准目录] [-params 参数组.json] [-j 线程数] [-preload MB]\n"
+                "       预处理缓存: [-cache 缓存目录]" << endl;
+        return 1;
+    }
+    vector<string> sources;
+    string output, baseline, trace, out_dir = ".", baseline_dir, params_path, cache_dir;
+    int tolerance = 0, threads = max(1u, thread::hardware_concurrency());
+    uint32_t max_frames = 0;
+    double fps = 0;
+    size_t preload_mb = 1024;
+    bool perf = false, verbose = false;
+    for(int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if(arg == "-compare" && i + 1 < argc)
+            baseline = argv[++i];
+        else if(arg == "-tolerance" && i + 1 < argc)
+            tolerance = stoi(argv[++i]);
+        else if(arg == "-max" && i + 1 < argc)
+            max_frames = stoul(argv[++i]);
+        else if(arg == "-fps" && i + 1 < argc)
+            fps = stod(argv[++i]);
+        else if(arg == "-trace" && i + 1 < argc)
+            trace = argv[++i];
+        else if(arg == "-d" && i + 1 < argc)
+            out_dir = argv[++i];
+        else if(arg == "-baseline-dir" && i + 1 < argc)
+            baseline_dir = argv[++i];
+        else if(arg == "-params" && i + 1 < argc)
+            params_path = argv[++i];
+        else if(arg == "-j" && i + 1 < argc)
+            threads = max(1, stoi(argv[++i]));
+        else if(arg == "-preload" && i + 1 < argc)
+            preload_mb = stoul(argv[++i]);
+        else if(arg == "-cache" && i + 1 < argc)
+            cache_dir = argv[++i];
+        else if(arg == "-perf")
+            perf = true;
+        else if(arg == "-v")
+            verbose = true;
+        else if(!arg.empty() && arg[0] != '-')
+            sources.push_back(arg);
+    }
+
+    // 参数组：每组为覆盖的参数，未指定时只有一组空参数（使用配置文件）
+    vector<nlohmann::json> param_sets;
+    if(!params_path.empty())
+    {
+        try
+        {
+            nlohmann::json sets = nlohmann::json::parse(ifstream(params_path));
+            if(sets.is_object())
+                sets = nlohmann::json::array({sets});
+            for(const nlohmann::json& set : sets)
+                param_sets.push_back(set);
+        }
+        catch(const exception& e)
+        {
+            cerr << "参数组文件解析失败: " << params_path << " " << e.what() << endl;
+            return 1;
+        }
+    }
+    if(param_sets.empty())
+        param_sets.push_back(nlohmann::json::object());
+
+    // 进程内所有流水线共用的设置
+    Parameter::Override("Headless", true);
+    Parameter::Override("Shm_Publish", false);
+    Logger::Instance().Set_Level(verbose ? NS_LOG_LEVEL_DEBUG : NS_LOG_LEVEL_WARN);
+    if(perf)
+        Perf_Counters::Enable(true);
+
+    // 去掉重复输入（末尾的'/'不计），文件名相同（如a/run.nsrec与b/run.nsrec、x.mp4与x.nsrec）时结果文件名追加输入序号，
+    // 避免多个任务并发写同一文件
+    vector<string> unique_sources;
+    set<string> seen;
+    for(string source : sources)
+    {
+        while(source.size() > 1 && source.back() == '/')
+            source.pop_back();
+        if(seen.insert(source).second)
+            unique_sources.push_back(source);
+    }
+    sources.swap(unique_sources);
+    map<string, int> stems;
+    for(const string& source : sources)
+        stems[Stem(source)]++;
+
+    vector<Replay_Job> jobs;
+    set<string> names;
+    for(size_t i = 0; i < sources.size(); i++)
+    {
+        const string& source = sources[i];
+        string stem = Stem(source) + (stems[Stem(source)] > 1 ? "_" + to_string(i) : "");
+        for(size_t p = 0; p < param_sets.size(); p++)
+        {
+            Replay_Job job;
+            job.source = source;
+            job.params = param_sets[p];
+            job.fps = fps;
+            job.max_frames = max_frames;
+            job.tolerance = tolerance;
+            string name = stem + (param_sets.size() > 1 ? "_p" + to_string(p) : "") + ".nsrp";
+            if(!names.insert(name).second)
+            {
+                cerr << "结果文件名冲突: " << name << "（" << source << "）" << endl;
+                return 1;
+            }
+            job.output = out_dir + "/" + name;
+            if(!baseline_dir.empty())
+                job.baseline = baseline_dir + "/" + name;
+            jobs.push_back(job);
+        }
+    }
+    if(jobs.empty())
+    {
+        cerr << "没有输入" << endl;
+        return 1;
+    }
+    bool batch = jobs.size() > 1;
+    if(!batch)
+    {
+        jobs[0].output = output.empty() ? "replay.nsrp" : output;
+        if(!baseline.empty())
+            jobs[0].baseline = baseline;
+    }
+    if(!trace.empty() && (batch || !Profiler::Global().Start_Trace(trace)))
+        cerr << (batch ? "批量回放不输出trace" : "性能追踪文件打开失败: " + trace) << endl;
+
+    // 预处理缓存：各参数组图像尺寸相同时使用，阈值也相同时缓存二值帧，否则缓存灰度帧；
+    // 未使用缓存且同一输入被多组参数使用时预先解码一次，各任务只读共享
+    bool resized = false;
+    set<int> thresholds;
+    Parameter parameter;
+    int width = parameter.Get_Parameter("Image_Width").get<int>();
+    int height = parameter.Get_Parameter("Image_Height").get<int>();
+    for(const nlohmann::json& params : param_sets)
+    {
+        resized = resized || params.contains("Image_Width") || params.contains("Image_Height");
+        thresholds.insert(params.value("threshold", parameter.Get_Parameter("threshold").get<int>()));
+    }
+    if(!cache_dir.empty() && resized)
+        cerr << "参数组修改图像尺寸，不使用预处理缓存" << endl;
+    bool use_cache = !cache_dir.empty() && !resized;
+    bool preload = param_sets.size() > 1 && !resized && preload_mb > 0;
+    if(use_cache || preload)
+    {
+        Frame_Format format = thresholds.size() == 1 ? Frame_Format::BINARY : Frame_Format::GRAY;
+        Parallel_For(sources.size(), threads, [&](size_t k)
+        {
+            shared_ptr<const FrameCache> cache;
+            if(use_cache)
+                cache = FrameCache::Open_Or_Build(sources[k], cache_dir, width, height, format, *thresholds.begin());
+            auto frames = make_shared<vector<cv::Mat>>();
+            double source_fps = 0;
+            if(!cache && preload && !Load_Frames(sources[k], width, height, preload_mb << 20, *frames, source_fps))
+            {
+                cerr << "不预先解码（无法读取或超过-preload上限）: " << sources[k] << endl;
+                return;
+            }
+            for(Replay_Job& job : jobs)
+            {
+                if(job.source != sources[k])
+                    continue;
+                job.cache = cache;
+                if(!cache && preload)
+                    job.frames = frames;
+                if(job.fps <= 0 && !cache)
+                    job.fps = source_fps;
+            }
+        });
+    }
+
+    // 批量时每个任务记录到自己的统计对象，结束后汇总到全局对象
+    vector<Replay_Result> results(jobs.size());
+    int64_t start_ns = Now_Ns();
+    Parallel_For(jobs.size(), threads, [&](size_t k)
+    {
+        unique_ptr<Profiler> profiler = batch ? make_unique<Profiler>() : nullptr;
+        Profiler::Bind(profiler.get());
+        if(!Run_Replay(jobs[k], results[k]))
+            cerr << jobs[k].source << ": " << results[k].error << endl;
+        Profiler::Bind(nullptr);
+        if(profiler)
+            Profiler::Global().Merge(*profiler);
+    });
+    double elapsed = (Now_Ns() - start_ns) / 1e9;
+    Profiler::Global().Stop_Trace();
+    Logger::Instance().Flush();
+
+    // ========================================== 汇总 ==========================================
+    int failed = 0, mismatched = 0;
+    uint64_t total_frames = 0;
+    if(batch)
+    {
+        printf("%-32s %-28s %7s %8s %7s %7s %6s %8s %7s %s\n",
+               "output", "params", "frames", "fps", "p50_ms", "p99_ms", "fit%", "|error|", "dPWM", "baseline");
+    }
+    for(size_t k = 0; k < jobs.size(); k++)
+    {
+        const Replay_Job& job = jobs[k];
+        const Replay_Result& r = results[k];
+        total_frames += r.frames;
+        if(!r.ok)
+            failed++;
+        else if(r.compared && !r.diff.Same())
+            mismatched++;
+        if(!batch)
+        {
+            printf("输入: %s\n", job.source.c_str());
+            printf("帧数: %u  用时: %.3f s  吞吐量: %.1f 帧/秒（录制帧率 %.1f，%.1f倍速）\n", r.frames, r.elapsed,
+                   r.elapsed > 0 ? r.frames / r.elapsed : 0.0, r.fps, r.elapsed > 0 ? r.frames / r.elapsed / r.fps : 0.0);
+            printf("结果文件: %s\n", job.output.c_str());
+            continue;
+        }
+        string params = job.params.empty() ? "-" : job.params.dump();
+        if(params.size() > 28)
+            params = params.substr(0, 25) + "...";
+        const char* status = !r.ok ? "失败" : !r.compared ? "-" : r.diff.Same() ? "一致" : "不一致";
+        double n = max<uint32_t>(r.frames, 1);
+        printf("%-32s %-28s %7u %8.1f %7.3f %7.3f %6.1f %8.2f %7.2f %s\n",
+               job.output.c_str(), params.c_str(), r.frames, r.elapsed > 0 ? r.frames / r.elapsed : 0.0,
+               r.frame_p50_ns / 1e6, r.frame_p99_ns / 1e6, r.fit_valid * 100.0 / n, r.abs_error_sum / n,
+               r.servo_delta_sum / n, status);
+    }
+    cout << Profiler::Global().Report();
+    if(batch)
+    {
+        printf("任务: %zu  线程: %d  总帧数: %llu  用时: %.3f s  总吞吐量: %.1f 帧/秒\n", jobs.size(), threads,
+               (unsigned long long)total_frames, elapsed, elapsed > 0 ? total_frames / elapsed : 0.0);
+        printf("失败: %d  与基准不一致: %d\n", failed, mismatched);
+    }
+    else if(results[0].compared)
+    {
+        Print_Diff(results[0].diff);
+        printf("%s\n", results[0].diff.Same() ? "与基准一致" : "与基准不一致");
+    }
+    return failed ? 1 : mismatched ? 2 : 0;
+}
@@ -0,0 +1,532 @@
+/**
+ * @file ns_sweep.cpp
+ * @brief 参数扫描及自动调参工具
+ * @details 按给定的参数范围生成候选参数组，每组在标注的录像集上回放（与ns_replay相同的流水线），
+ *          由线程池在各核上并行执行；按场景识别准确率、中心线拟合有效率、控制中心帧间抖动和舵机PWM帧间抖动评分，
+ *          把最优参数写入配置文件副本（没有候选严格优于当前配置时保留当前值）。每段录像只解码一次，所有候选只读共享解码后的帧或预处理缓存。
+ *
+ * 使用方法（在build/bin下运行，读取../../config/config.json）：
+ * - ns_sweep sweep.json                      网格搜索（全部组合）
+ * - ns_sweep sweep.json -mode descent        坐标下降：从当前配置出发逐个参数取最优，直到一轮无改进
+ * - ns_sweep sweep.json -j 8 -o best.json -csv all.csv
+ * - ns_sweep sweep.json -cache cache/        使用预处理帧缓存（首次生成），重复扫描时跳过解码和预处理
+ *
+ * sweep.json示例：
+ * {
+ *   "corpus": [
+ *     {"source": "../../res/samples/sample.mp4", "labels": [[1, 120, "NormalScene"], [121, 260, "RingScene"]]},
+ *     {"source": "../../res/samples/zebra/"}
+ *   ],
+ *   "params": {
+ *     "threshold": [110, 150, 5],                 最小值、最大值、步长
+ *     "Corner_Left_Up_Slope2": {"values": [0.5, 1, 2]},
+ *     "Turn_D": [0, 2, 0.5]
+ *   },
+ *   "weights": {"scene": 1.0, "fit": 0.2, "jitter": 0.02, "steer": 0.002},
+ *   "rounds": 3,
+ *   "max_frames": 0,
+ *   "cache": "cache/"
+ * }
+ * 标注为 [起始帧, 结束帧, 场景] （帧序号从1开始，含两端），场景名同recognition::Scene；
+ * 没有标注的录像只参与稳定性评分。舵机PWM由回放中的控制周期计算，转向参数（Run_P2、Turn_D等）通过steer项影响得分。
+ */
+
+#include "task/pipeline.hpp"
+#include "task/replay.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace common;
+using namespace recognition;
+using namespace task;
+using namespace std;
+using json = nlohmann::json;
+
+static const char* SCENE_NAME[] = {
+    "NormalScene", "ZebraScene", "CrossScene", "RingScene", "BridgeScene",
+    "ObstacleScene", "CateringScene", "LaybyScene", "ParkingScene"
+};
+static const int SCENE_COUNT = sizeof(SCENE_NAME) / sizeof(SCENE_NAME[0]);
+
+/**
+ * @brief 一段录像及其逐帧场景标注
+ */
+struct Recording
+{
+    string source;
+    vector<int8_t> labels;      //labels[frame_id - 1]为场景序号，-1为未标注
+    shared_ptr<const vector<cv::Mat>> frames;
+    shared_ptr<const FrameCache> cache;
+    double fps = 0;
+};
+
+/**
+ * @brief 评分权重
+ */
+struct Weights
+{
+    double scene = 1.0;     //场景识别准确率
+    double fit = 0.2;       //中心线拟合有效率
+    double jitter = 0.02;   //控制中心帧间变化（每像素扣分）
+    double steer = 0.002;   //舵机PWM帧间变化（每单位PWM扣分）
+};
+
+/**
+ * @brief 一组候选参数在录像集上的统计及得分
+ */
+struct Score
+{
+    json params;
+    uint64_t frames = 0;
+    uint64_t labelled = 0;      //有标注的帧
+    uint64_t correct = 0;       //场景识别正确的帧
+    uint64_t fit_valid = 0;
+    double jitter_sum = 0;      //|控制中心帧间变化|累计
+    double steer_sum = 0;       //|舵机PWM帧间变化|累计
+    int failed = 0;             //回放失败的录像数
+    double score = -1e30;
+
+    double Accuracy() const { return labelled ? (double)correct / labelled : 0; }
+    double Fit_Rate() const { return frames ? (double)fit_valid / frames : 0; }
+    double Jitter() const { return frames > 1 ? jitter_sum / (frames - 1) : 0; }
+    double Steer_Jitter() const { return frames > 1 ? steer_sum / (frames - 1) : 0; }
+
+    void Evaluate(const Weights& w)
+    {
+        score = failed || frames == 0 ? -1e30 : w.scene * Accuracy() + w.fit * Fit_Rate() - w.jitter * Jitter() -
+                                                      w.steer * Steer_Jitter();
+    }
+};
+
+/**
+ * @brief 单个回放任务的逐帧统计（只由执行该任务的线程访问）
+ */
+struct Metrics
+{
+    uint64_t frames = 0, labelled = 0, correct = 0, fit_valid = 0;
+    double jitter_sum = 0, steer_sum = 0;
+    int last_center = 0;
+    int last_servo = 0;
+};
+
+/**
+ * @brief 解析参数取值：[最小值, 最大值, 步长] 或 {"values": [...]}
+ */
+static bool Parse_Values(const string& key, const json& spec, vector<json>& values)
+{
+    if(spec.is_object() && spec.contains("values") && spec["values"].is_array())
+    {
+        for(const json& v : spec["values"])
+            values.push_back(v);
+        return !values.empty();
+    }
+    if(!spec.is_array() || spec.size() != 3 || !spec[0].is_number() || !spec[1].is_number() || !spec[2].is_number() ||
+       spec[2].get<double>() <= 0)
+    {
+        cerr << "参数范围格式错误（应为[最小值, 最大值, 步长]或{\"values\": [...]}）: " << key << endl;
+        return false;
+    }
+    bool integer = spec[0].is_number_integer() && spec[1].is_number_integer() && spec[2].is_number_integer();
+    double low = spec[0].get<double>(), high = spec[1].get<double>(), step = spec[2].get<double>();
+    for(int k = 0; low + k * step <= high + step * 1e-6; k++)
+    {
+        double v = low + k * step;
+        if(integer)
+            values.push_back((int64_t)llround(v));
+        else
+            values.push_back(round(v * 1e9) / 1e9);     // 去掉累加误差
+    }
+    return true;
+}
+
+/**
+ * @brief 参数组的简短文本
+ */
+static string Describe(const json& params)
+{
+    ostringstream ss;
+    for(auto it = params.begin(); it != params.end(); ++it)
+        ss << (it == params.begin() ? "" : " ") << it.key() << "=" << it.value().dump();
+    return ss.str();
+}
+
+/**
+ * @brief 并行评估候选参数组
+ */
+class Evaluator
+{
+public:
+    vector<Recording> _corpus;
+    Weights _weights;
+    uint32_t _max_frames = 0;
+    int _threads = 1;
+    size_t _evaluated = 0;      //已评估的候选数
+
+    vector<Score> Evaluate(const vector<json>& candidates)
+    {
+        size_t n = _corpus.size();
+        vector<Metrics> metrics(candidates.size() * n);
+        vector<Replay_Result> results(metrics.size());
+        Parallel_For(metrics.size(), _threads, [&](size_t k)
+        {
+            const Recording& recording = _corpus[k % n];
+            Metrics& m = metrics[k];
+            Replay_Job job;
+            job.source = recording.source;
+            job.params = candidates[k / n];
+            job.frames = recording.frames;
+            job.cache = recording.cache;
+            job.fps = recording.fps;
+            job.max_frames = _max_frames;
+            job.on_frame = [&](const Pipeline& pipeline, uint16_t servo_pwm)
+            {
+                int center = pipeline._control_center._control_center;
+                if(m.frames > 0)
+                {
+                    m.jitter_sum += abs(center - m.last_center);
+                    m.steer_sum += abs(servo_pwm - m.last_servo);
+                }
+                m.last_center = center;
+                m.last_servo = servo_pwm;
+                m.frames++;
+                if(pipeline._control_center.Fit_Valid())
+                    m.fit_valid++;
+                size_t index = pipeline._frame_id - 1;
+                if(index < recording.labels.size() && recording.labels[index] >= 0)
+                {
+                    m.labelled++;
+                    if((int)pipeline._detected == recording.labels[index])
+                        m.correct++;
+                }
+            };
+            Profiler profiler;      // 各任务独立统计，不与其他线程争用
+            Profiler::Bind(&profiler);
+            Run_Replay(job, results[k]);
+            Profiler::Bind(nullptr);
+        });
+
+        vector<Score> scores(candidates.size());
+        for(size_t c = 0; c < candidates.size(); c++)
+        {
+            Score& s = scores[c];
+            s.params = candidates[c];
+            for(size_t r = 0; r < n; r++)
+            {
+                const Metrics& m = metrics[c * n + r];
+                if(!results[c * n + r].ok)
+                    s.failed++;
+                s.frames += m.frames;
+                s.labelled += m.labelled;
+                s.correct += m.correct;
+                s.fit_valid += m.fit_valid;
+                s.jitter_sum += m.jitter_sum;
+                s.steer_sum += m.steer_sum;
+            }
+            s.Evaluate(_weights);
+        }
+        _evaluated += candidates.size();
+        return scores;
+    }
+};
+
+/**
+ * @brief 配置文件中扫描参数的当前取值
+ */
+static json Current_Params(const vector<string>& keys)
+{
+    Parameter parameter;
+    json current = json::object();
+    for(const string& key : keys)
+        current[key] = parameter.Get_Parameter(key);
+    return current;
+}
+
+/**
+ * @brief 网格搜索：当前配置及全部组合（结果第一项为当前配置）
+ */
+static vector<Score> Grid_Search(Evaluator& evaluator, const vector<string>& keys, const vector<vector<json>>& values, const json& current)
+{
+    vector<json> candidates(1, json::object());
+    for(size_t i = 0; i < keys.size(); i++)
+    {
+        vector<json> next;
+        for(const json& base : candidates)
+        {
+            for(const json& v : values[i])
+            {
+                json c = base;
+                c[keys[i]] = v;
+                next.push_back(c);
+            }
+        }
+        candidates.swap(next);
+    }
+    candidates.erase(remove(candidates.begin(), candidates.end(), current), candidates.end());
+    candidates.insert(candidates.begin(), current);
+    printf("网格搜索: %zu 组参数 × %zu 段录像\n", candidates.size(), evaluator._corpus.size());
+    return evaluator.Evaluate(candidates);
+}
+
+/**
+ * @brief 坐标下降：从当前配置出发，每次固定其余参数，在一个参数的全部取值中取最优（结果第一项为当前配置）
+ */
+static vector<Score> Coordinate_Descent(Evaluator& evaluator, const vector<string>& keys, const vector<vector<json>>& values,
+                                        const json& current, int rounds)
+{
+    vector<Score> history = evaluator.Evaluate({current});
+    Score best = history[0];
+    printf("初始配置: 得分 %.4f  %s\n", best.score, Describe(current).c_str());
+
+    for(int round = 1; round <= rounds; round++)
+    {
+        bool improved = false;
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+            vector<json> candidates;
+            for(const json& v : values[i])
+            {
+                if(v == best.params[keys[i]])
+                    continue;
+                json c = best.params;
+                c[keys[i]] = v;
+                candidates.push_back(c);
+            }
+            vector<Score> scores = evaluator.Evaluate(candidates);
+            history.insert(history.end(), scores.begin(), scores.end());
+            for(const Score& s : scores)
+            {
+                if(s.score > best.score + 1e-9)
+                {
+                    best = s;
+                    improved = true;
+                }
+            }
+            printf("第%d轮 %-28s → %-10s 得分 %.4f\n", round, keys[i].c_str(), best.params[keys[i]].dump().c_str(), best.score);
+        }
+        if(!improved)
+            break;
+    }
+    return history;
+}
+
+/**
+ * @brief 把最优参数写入配置文件副本：在原文本中替换数值，保留顺序和说明项
+ */
+static bool Write_Config(const string& config_path, const string& output, const json& params)
+{
+    ifstream in(config_path);
+    if(!in)
+        return false;
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    for(auto it = params.begin(); it != params.end(); ++it)
+    {
+        regex pattern("(\"" + it.key() + "\"\\s*:\\s*)[-+0-9.eE]+");
+        if(regex_search(text, pattern))
+            text = regex_replace(text, pattern, "${1}" + it.value().dump(), regex_constants::format_first_only);
+        else
+            cerr << "配置文件中没有数值参数 " << it.key() << "，未写入" << endl;
+    }
+    ofstream out(output);
+    out << text;
+    return (bool)out;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        cout << "用法: " << argv[0] << " <扫描配置.json> [-mode grid|descent] [-j 线程数] [-o 最优配置文件]"
+                " [-csv 全部结果] [-max 帧数] [-rounds N] [-preload MB] [-cache 缓存目录]" << endl;
+        return 1;
+    }
+    json spec;
+    try
+    {
+        spec = json::parse(ifstream(argv[1]));
+    }
+    catch(const exception& e)
+    {
+        cerr << "扫描配置解析失败: " << argv[1] << " " << e.what() << endl;
+        return 1;
+    }
+    string mode = spec.value("mode", string("grid"));
+    string output = spec.value("output", string("config.best.json"));
+    string cache_dir = spec.value("cache", string());
+    string csv;
+    int rounds = spec.value("rounds", 3);
+    size_t preload_mb = 1024;
+    Evaluator evaluator;
+    evaluator._threads = max(1u, thread::hardware_concurrency());
+    evaluator._max_frames = spec.value("max_frames", 0u);
+    for(int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "-mode" && i + 1 < argc)
+            mode = argv[++i];
+        else if(arg == "-j" && i + 1 < argc)
+            evaluator._threads = max(1, stoi(argv[++i]));
+        else if(arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if(arg == "-csv" && i + 1 < argc)
+            csv = argv[++i];
+        else if(arg == "-max" && i + 1 < argc)
+            evaluator._max_frames = stoul(argv[++i]);
+        else if(arg == "-rounds" && i + 1 < argc)
+            rounds = stoi(argv[++i]);
+        else if(arg == "-preload" && i + 1 < argc)
+            preload_mb = stoul(argv[++i]);
+        else if(arg == "-cache" && i + 1 < argc)
+            cache_dir = argv[++i];
+    }
+    if(mode != "grid" && mode != "descent")
+    {
+        cerr << "未知的扫描方式: " << mode << endl;
+        return 1;
+    }
+
+    // 参数范围
+    vector<string> keys;
+    vector<vector<json>> values;
+    if(spec.contains("params") && spec["params"].is_object())
+    {
+        for(auto it = spec["params"].begin(); it != spec["params"].end(); ++it)
+        {
+            vector<json> v;
+            if(!Parse_Values(it.key(), it.value(), v))
+                return 1;
+            keys.push_back(it.key());
+            values.push_back(v);
+        }
+    }
+    if(keys.empty())
+    {
+        cerr << "没有要扫描的参数" << endl;
+        return 1;
+    }
+    if(spec.contains("weights"))
+    {
+        evaluator._weights.scene = spec["weights"].value("scene", evaluator._weights.scene);
+        evaluator._weights.fit = spec["weights"].value("fit", evaluator._weights.fit);
+        evaluator._weights.jitter = spec["weights"].value("jitter", evaluator._weights.jitter);
+        evaluator._weights.steer = spec["weights"].value("steer", evaluator._weights.steer);
+    }
+
+    // 录像集及标注
+    for(const json& item : spec.value("corpus", json::array()))
+    {
+        Recording recording;
+        recording.source = item.value("source", string());
+        for(const json& label : item.value("labels", json::array()))
+        {
+            string name = label.size() == 3 ? label[2].get<string>() : "";
+            int scene = find(SCENE_NAME, SCENE_NAME + SCENE_COUNT, name) - SCENE_NAME;
+            if(scene == SCENE_COUNT)
+            {
+                cerr << recording.source << ": 无法识别的标注 " << label.dump() << endl;
+                return 1;
+            }
+            size_t from = label[0].get<size_t>(), to = label[1].get<size_t>();
+            if(recording.labels.size() < to)
+                recording.labels.resize(to, -1);
+            for(size_t f = max<size_t>(from, 1); f <= to; f++)
+                recording.labels[f - 1] = scene;
+        }
+        evaluator._corpus.push_back(recording);
+    }
+    if(evaluator._corpus.empty())
+    {
+        cerr << "录像集为空" << endl;
+        return 1;
+    }
+
+    Parameter::Override("Headless", true);
+    Parameter::Override("Shm_Publish", false);
+    Logger::Instance().Set_Level(NS_LOG_LEVEL_WARN);
+
+    // 每段录像只解码一次，全部候选共享：指定缓存目录时映射预处理缓存（扫描阈值时缓存灰度帧，否则缓存二值帧），
+    // 否则预先解码到内存；扫描图像尺寸时各任务自行解码
+    bool resized = count(keys.begin(), keys.end(), "Image_Width") || count(keys.begin(), keys.end(), "Image_Height");
+    if(!resized && (!cache_dir.empty() || preload_mb > 0))
+    {
+        Parameter parameter;
+        int width = parameter.Get_Parameter("Image_Width").get<int>();
+        int height = parameter.Get_Parameter("Image_Height").get<int>();
+        int threshold = parameter.Get_Parameter("threshold").get<int>();
+        Frame_Format format = count(keys.begin(), keys.end(), "threshold") ? Frame_Format::GRAY : Frame_Format::BINARY;
+        Parallel_For(evaluator._corpus.size(), evaluator._threads, [&](size_t k)
+        {
+            Recording& recording = evaluator._corpus[k];
+            if(!cache_dir.empty())
+                recording.cache = FrameCache::Open_Or_Build(recording.source, cache_dir, width, height, format, threshold);
+            if(recording.cache || preload_mb == 0)
+                return;
+            auto frames = make_shared<vector<cv::Mat>>();
+            if(Load_Frames(recording.source, width, height, preload_mb << 20, *frames, recording.fps))
+                recording.frames = frames;
+            else
+                cerr << "不预先解码（无法读取或超过-preload上限）: " << recording.source << endl;
+        });
+    }
+    else if(resized && !cache_dir.empty())
+        cerr << "扫描图像尺寸，不使用预处理缓存" << endl;
+
+    int64_t start_ns = Now_Ns();
+    json current = Current_Params(keys);
+    vector<Score> scores = mode == "grid" ? Grid_Search(evaluator, keys, values, current)
+                                          : Coordinate_Descent(evaluator, keys, values, current, rounds);
+    double elapsed = (Now_Ns() - start_ns) / 1e9;
+    Logger::Instance().Flush();
+
+    // 同分时保持评估顺序（当前配置在最前），只有严格更优的候选才替换当前配置
+    const Score baseline = scores[0];
+    stable_sort(scores.begin(), scores.end(), [](const Score& a, const Score& b) { return a.score > b.score; });
+    const Score& best = scores[0].score > baseline.score + 1e-9 ? scores[0] : baseline;
+    if(!csv.empty())
+    {
+        ofstream out(csv);
+        for(const string& key : keys)
+            out << key << ",";
+        out << "score,accuracy,fit_rate,jitter,steer_jitter,frames,failed" << endl;
+        for(const Score& s : scores)
+        {
+            for(const string& key : keys)
+                out << s.params[key].dump() << ",";
+            out << s.score << "," << s.Accuracy() << "," << s.Fit_Rate() << "," << s.Jitter() << "," << s.Steer_Jitter() << "," << s.frames << "," << s.failed << endl;
+        }
+    }
+
+    printf("%8s %8s %8s %8s %8s  %s\n", "score", "accuracy", "fit%", "jitter", "steer", "params");
+    for(size_t k = 0; k < scores.size() && k < 10; k++)
+    {
+        const Score& s = scores[k];
+        if(s.failed || s.frames == 0)
+            printf("%8s %8s %8s %8s %8s  %s（有录像回放失败）\n", "-", "-", "-", "-", "-", Describe(s.params).c_str());
+        else
+            printf("%8.4f %8.3f %8.1f %8.2f %8.2f  %s\n", s.score, s.Accuracy(), s.Fit_Rate() * 100, s.Jitter(), s.Steer_Jitter(),
+                   Describe(s.params).c_str());
+    }
+    printf("评估 %zu 组参数，用时 %.1f s\n", evaluator._evaluated, elapsed);
+    if(best.failed || best.frames == 0)
+    {
+        cerr << "没有可用的结果" << endl;
+        return 1;
+    }
+    if(&best == &baseline)
+        printf("没有候选严格优于当前配置，保留当前值\n");
+    if(!Write_Config(Parameter().Get_Config_Path(), output, best.params))
+    {
+        cerr << "无法写入: " << output << endl;
+        return 1;
+    }
+    printf("最优配置已写入: %s\n", output.c_str());
+    return 0;
+}
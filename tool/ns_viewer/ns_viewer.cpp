@@ -0,0 +1,155 @@
+/**
+ * @file ns_viewer.cpp
+ * @brief 共享内存图像查看器
+ * @details 连接视觉进程发布的共享内存环形缓冲（配置Shm_Publish），取最新一帧，
+ *          在查看器进程中绘制中线、边线、角点、控制中心及文字信息并显示窗口，
+ *          视觉进程本身不做任何绘制和HighGUI调用
+ *
+ * 功能特性：
+ * - 只读映射，不影响视觉进程；显示跟不上时直接跳到最新帧
+ * - 视觉进程重启后自动重新连接
+ * - 默认以低优先级运行
+ * - 可通过挂载访问车上的/dev/shm，在笔记本上查看
+ *
+ * 使用方法：
+ * - ns_viewer                                    连接本机 /natural_selection
+ * - ns_viewer /mnt/car/dev/shm/natural_selection 通过挂载的文件连接
+ * - ns_viewer -nice 0                            不降低优先级
+ *
+ * 按键：q/ESC 退出，s 保存当前绘制图像
+ */
+
+#include "common/publisher.hpp"
+#include "common/clock.hpp"
+#include <opencv2/opencv.hpp>
+#include <sys/resource.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace common;
+using namespace std;
+
+/**
+ * @brief 在原始图像上绘制叠加信息（与主程序Show_Draw_Line_Task一致）
+ */
+static void Draw_Overlay(cv::Mat& draw, const Shm_Overlay& overlay, bool local)
+{
+    auto pt = [](const Shm_Point& p) { return cv::Point(p.x, p.y); };
+    for(size_t i = 0; i < overlay.line_count && i < SHM_MAX_POINTS; i++)
+    {
+        cv::circle(draw, pt(overlay.middle[i]), 1, cv::Scalar(0, 255, 255), -1);
+        cv::circle(draw, pt(overlay.left[i]), 1, cv::Scalar(255, 0, 0), -1);
+        cv::circle(draw, pt(overlay.right[i]), 1, cv::Scalar(0, 0, 255), -1);
+    }
+    for(size_t i = 0; i < overlay.center_count && i < SHM_MAX_POINTS; i++)
+        cv::circle(draw, pt(overlay.center[i]), 1, cv::Scalar(0, 0, 0), -1);
+    // 角点：下方绿色，上方黄色
+    for(int i = 0; i < 4; i++)
+        cv::circle(draw, pt(overlay.corners[i]), 2, i < 2 ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 255, 255), -1);
+    cv::circle(draw, cv::Point(overlay.control_center, overlay.control_row), 4, cv::Scalar(0, 0, 255), -1);
+
+    int font_face = cv::FONT_HERSHEY_SIMPLEX;
+    double font_scale = 0.5;
+    cv::Scalar text_color(255, 255, 0);
+    string scene(overlay.scene, strnlen(overlay.scene, SHM_SCENE_LENGTH));
+    cv::putText(draw, "Scene: " + scene, cv::Point(10, 30), font_face, font_scale, text_color, 1);
+    cv::putText(draw, "Avg FPS: " + to_string(static_cast<int>(overlay.fps)), cv::Point(10, 55), font_face, font_scale, text_color, 1);
+    cv::putText(draw, "Frame: " + to_string(overlay.frame_id), cv::Point(10, 80), font_face, font_scale, text_color, 1);
+    cv::putText(draw, "Control: " + to_string(overlay.control_center) + " " + to_string(static_cast<int>(overlay.sigma)),
+                cv::Point(250, 55), font_face, font_scale, text_color, 1);
+    cv::putText(draw, "Speed: " + to_string(overlay.speed) + " PWM: " + to_string(overlay.servo_pwm),
+                cv::Point(250, 80), font_face, font_scale, text_color, 1);
+    // 同一台机器上单调时钟可比，显示发布到显示的延迟
+    if(local)
+    {
+        double delay_ms = (Now_Ns() - overlay.stamp_ns) / 1e6;
+        cv::putText(draw, "Delay: " + to_string(static_cast<int>(delay_ms)) + " ms",
+                    cv::Point(250, 30), font_face, font_scale, text_color, 1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string path = SHM_NAME;
+    int nice_value = 10;
+    for(int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if(arg == "-nice" && i + 1 < argc)
+            nice_value = stoi(argv[++i]);
+        else if(arg == "-h" || arg == "--help")
+        {
+            cout << "用法: " << argv[0] << " [共享内存名或文件路径] [-nice N]" << endl;
+            return 0;
+        }
+        else
+            path = arg;
+    }
+    if(nice_value != 0 && setpriority(PRIO_PROCESS, 0, nice_value) != 0)
+        cerr << "降低优先级失败" << endl;
+    bool local = path.find('/', 1) == string::npos;
+
+    FrameSubscriber subscriber;
+    Shm_Frame frame;
+    cv::Mat draw;
+    int64_t last_frame_ns = 0;
+    bool waiting = false;
+    bool connected = false;     //无新帧时的重新连接不重复提示
+    while(true)
+    {
+        if(!subscriber.Is_Attached())
+        {
+            if(!subscriber.Attach(path))
+            {
+                if(!waiting)
+                    cout << "等待视觉进程发布: " << path << endl;
+                waiting = true;
+                this_thread::sleep_for(chrono::milliseconds(500));
+                continue;
+            }
+            if(waiting || !connected)
+                cout << "已连接: " << path << endl;
+            waiting = false;
+            connected = true;
+            last_frame_ns = Now_Ns();
+        }
+
+        if(subscriber.Read(frame))
+        {
+            last_frame_ns = Now_Ns();
+            if(!frame.raw.empty())
+            {
+                if(frame.raw.channels() == 1)
+                    cv::cvtColor(frame.raw, draw, cv::COLOR_GRAY2BGR);
+                else
+                    frame.raw.copyTo(draw);
+                cv::imshow("原始图像", frame.raw);
+                Draw_Overlay(draw, frame.overlay, local);
+                cv::imshow("巡线路径", draw);
+            }
+            if(!frame.binary.empty())
+                cv::imshow("二值化图像", frame.binary);
+        }
+        else if(Now_Ns() - last_frame_ns > 2000000000LL)
+        {
+            // 长时间无新帧：视觉进程可能已重启，重新连接新的共享内存
+            subscriber.Detach();
+            continue;
+        }
+
+        int key = cv::waitKey(10);
+        if(key == 'q' || key == 'Q' || key == 27)
+            break;
+        if((key == 's' || key == 'S') && !draw.empty())
+        {
+            string filename = "frame_" + to_string(frame.overlay.frame_id) + ".jpg";
+            cv::imwrite(filename, draw);
+            cout << "保存图像：" << filename << endl;
+        }
+    }
+    cout << "读取重试次数: " << subscriber.Retries() << endl;
+    cv::destroyAllWindows();
+    return 0;
+}
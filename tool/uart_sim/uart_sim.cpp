@@ -0,0 +1,368 @@
+/**
+ * @file uart_sim.cpp
+ * @brief 下位机串口模拟器
+ * @details 在伪终端(pty)上模拟下位机，按USB通信协议收发数据，
+ *          用于在没有下位机的情况下测试Uart的吞吐、延迟和抗干扰能力
+ *
+ * 功能特性：
+ * - 解析控制帧并回复编码器帧（应答）
+ * - 定时发送按键帧
+ * - 按设定概率向应答帧中注入线路噪声（随机字节、伪帧头、错误校验）
+ * - 自测模式：进程内用Uart连接pty从端，统计下发延迟、吞吐和解码重同步情况
+ * - 外部模式：只运行模拟下位机，可通过符号链接代替/dev/ttyUSB0供主程序连接
+ * - 回放：外部模式下按原始时间间隔发送运行录制(.nsrec)中的下位机上报数据（编码器、IMU等）
+ *
+ * 使用方法：
+ * - uart_sim                         自测，默认2000帧、200Hz
+ * - uart_sim -n 10000 -r 1000        自测，10000帧、1000Hz
+ * - uart_sim -noise 0.05             自测，5%的应答帧注入噪声
+ * - uart_sim -r 2000 -max 200        自测，验证限速时旧指令被覆盖
+ * - uart_sim -external -link /tmp/ttyMCU   外部模式，Ctrl+C退出
+ * - uart_sim -external -link /tmp/ttyMCU -replay run.nsrec  外部模式回放录制
+ */
+
+#include "common/uart.hpp"
+#include "common/histogram.hpp"
+#include <pty.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+using namespace common;
+using namespace std;
+
+/**
+ * @brief 模拟器配置
+ */
+struct Sim_Config {
+    int frames = 2000;          // 自测发送帧数
+    int rate = 200;             // 自测发送频率（Hz）
+    double noise = 0;           // 应答帧注入噪声的概率
+    int key_period_ms = 500;    // 按键帧发送周期（毫秒），0为不发送
+    int max_rate = 0;           // Uart最大发送频率（Hz），0为不限速
+    bool external = false;      // 外部模式
+    string link;                // 外部模式下为pty从端创建的符号链接
+    string replay;              // 外部模式下回放的运行录制文件
+};
+
+/**
+ * @brief 模拟器统计
+ */
+struct Sim_Stats {
+    atomic<uint64_t> bytes{0};          // 收到的字节数
+    atomic<uint64_t> frames{0};         // 收到的有效控制帧数
+    atomic<uint64_t> repeats{0};        // 重复收到的控制帧数（心跳）
+    atomic<uint64_t> bad_frames{0};     // 校验失败的帧数
+    atomic<uint64_t> acks{0};           // 发出的应答帧数
+    atomic<uint64_t> noisy_acks{0};     // 被注入噪声的应答帧数
+    atomic<uint64_t> keys{0};           // 发出的按键帧数
+    Histogram latency;                  // 提交到模拟器收到的延迟（纳秒）
+};
+
+static atomic<bool> g_running{true};
+
+static void on_signal(int) { g_running = false; }
+
+/**
+ * @brief 写出全部数据（pty主端为阻塞模式）
+ */
+static void write_all(int fd, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief 发送应答帧，按概率注入噪声
+ *
+ * 噪声形式：应答帧前插入随机字节（含伪帧头），或破坏应答帧的一个数据字节。
+ * 被破坏的帧应被上位机丢弃，其后的有效帧应被重新同步解出。
+ */
+static void send_frame(int fd, uint8_t *frame, size_t len, double noise,
+                       mt19937 &rng, Sim_Stats &stats) {
+    uniform_real_distribution<double> prob(0, 1);
+    if (noise > 0 && prob(rng) < noise) {
+        stats.noisy_acks++;
+        if (rng() & 1) {
+            uint8_t junk[6];
+            for (auto &b : junk)
+                b = (rng() % 4 == 0) ? USB_FRAME_HEAD : static_cast<uint8_t>(rng());
+            write_all(fd, junk, sizeof(junk));
+        } else {
+            frame[3 + rng() % (len - 4)] ^= 0x5A; // 破坏数据，校验失败
+        }
+    }
+    write_all(fd, frame, len);
+}
+
+/**
+ * @brief 模拟下位机主循环
+ * @param fd pty主端
+ * @param config 配置
+ * @param stats 统计
+ * @param send_ns 自测模式下各序号的提交时间，外部模式为空
+ */
+static void mcu_loop(int fd, const Sim_Config &config, Sim_Stats &stats,
+                     const vector<int64_t> *send_ns) {
+    mt19937 rng(12345);
+    vector<uint8_t> buffer;
+    uint8_t chunk[4096];
+    int32_t pulses = 0;
+    vector<bool> seen(send_ns ? send_ns->size() : 0, false);
+    int64_t next_key = config.key_period_ms > 0
+                           ? Now_Ns() + config.key_period_ms * 1000000LL
+                           : INT64_MAX;
+
+    while (g_running) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ret = poll(&pfd, 1, 5);
+        int64_t now = Now_Ns();
+
+        // 定时按键
+        if (now >= next_key) {
+            uint8_t frame[protocol::Key_Press::LENGTH];
+            protocol::Key_Press::Encode(frame, 1);
+            write_all(fd, frame, sizeof(frame));
+            stats.keys++;
+            next_key += config.key_period_ms * 1000000LL;
+        }
+        if (ret <= 0 || !(pfd.revents & POLLIN))
+            continue;
+
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0)
+            continue;
+        stats.bytes += n;
+        buffer.insert(buffer.end(), chunk, chunk + n);
+
+        // 解析控制帧（独立实现，不依赖被测的解码器）
+        size_t pos = 0;
+        while (buffer.size() - pos >= USB_FRAME_LENMIN) {
+            if (buffer[pos] != USB_FRAME_HEAD) {
+                pos++;
+                continue;
+            }
+            uint8_t len = buffer[pos + 2];
+            if (len < USB_FRAME_LENMIN || len > USB_FRAME_LENMAX) {
+                pos++;
+                continue;
+            }
+            if (buffer.size() - pos < len)
+                break;
+            const uint8_t *frame = buffer.data() + pos;
+            if (frame[1] == USB_ADDR_CARCTRL) {
+                float speed;
+                uint16_t seq;
+                if (!protocol::Car_Control::Decode(frame, speed, seq)) {
+                    stats.bad_frames++;
+                    pos++;
+                    continue;
+                }
+                if (seq < seen.size() && seen[seq]) {
+                    stats.repeats++; // 心跳重发，不计入延迟
+                } else {
+                    stats.frames++;
+                    if (seq < seen.size() && (*send_ns)[seq] != 0) {
+                        seen[seq] = true;
+                        stats.latency.Record(now - (*send_ns)[seq]);
+                    }
+                }
+
+                // 应答：回复编码器帧，实测车速取指令速度（回放时由记录提供）
+                if (!config.replay.empty()) {
+                    pos += len;
+                    continue;
+                }
+                pulses += static_cast<int32_t>(speed * 100);
+                uint8_t ack[protocol::Encoder::LENGTH];
+                protocol::Encoder::Encode(ack, speed, pulses);
+                send_frame(fd, ack, sizeof(ack), config.noise, rng, stats);
+                stats.acks++;
+            }
+            pos += len;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + pos);
+    }
+}
+
+/**
+ * @brief 按原始时间间隔回放运行录制中的串口接收数据（UART_RX）
+ * @param fd pty主端
+ * @param path 录制文件(.nsrec)
+ */
+static void replay_loop(int fd, const string &path) {
+    shared_ptr<RecordingReader> reader = RecordingReader::Open(path);
+    if (reader == nullptr) {
+        cerr << "录制文件无效: " << path << endl;
+        return;
+    }
+    const vector<Recording_Index> &rx = reader->Uart_Rx();
+    int64_t start = Now_Ns();
+    uint64_t count = 0;
+    for (size_t k = 0; g_running && k < rx.size(); k++) {
+        int64_t wait = start + (rx[k].stamp_ns - rx[0].stamp_ns) - Now_Ns();
+        if (wait > 0)
+            this_thread::sleep_for(chrono::nanoseconds(wait));
+        write_all(fd, reader->Payload(rx[k]), rx[k].size);
+        count++;
+    }
+    cout << "回放结束，共 " << count << " 帧" << endl;
+}
+
+/**
+ * @brief 输出延迟分布
+ */
+static void print_latency(const char *name, const Histogram &hist) {
+    cout << fixed << setprecision(1) << name << ": P50 "
+         << hist.Percentile(50) / 1e3 << " us, P99 "
+         << hist.Percentile(99) / 1e3 << " us, 最大 " << hist.Max() / 1e3
+         << " us" << endl;
+}
+
+/**
+ * @brief 自测：进程内通过Uart连接pty从端
+ */
+static int self_test(int master, const string &slave, const Sim_Config &config) {
+    Sim_Stats stats;
+    vector<int64_t> send_ns(config.frames, 0);
+    Histogram call;                     // carControl调用耗时
+
+    Uart uart(slave);
+    if (uart.open() != 0)
+        return -1;
+    uart.setMaxRate(config.max_rate);
+    uart.subscribeMessages();
+    uart.startReceive();
+    thread mcu(mcu_loop, master, cref(config), ref(stats), &send_ns);
+
+    uint64_t acks = 0, keys = 0;
+    auto drain = [&]() {
+        Uart::Message msg;
+        while (uart.popMessage(msg)) {
+            if (msg.addr == USB_ADDR_ENCODER)
+                acks++;
+            else if (msg.addr == USB_ADDR_KEY)
+                keys++;
+        }
+    };
+
+    auto period = chrono::nanoseconds(1000000000LL / max(1, config.rate));
+    auto next = chrono::steady_clock::now();
+    int64_t start = Now_Ns();
+    for (int i = 0; i < config.frames && g_running; i++) {
+        // 舵机字段携带序号，用于模拟器端计算延迟
+        int64_t t0 = Now_Ns();
+        send_ns[i] = t0;
+        uart.carControl(1.0f, static_cast<uint16_t>(i));
+        call.Record(Now_Ns() - t0);
+        drain();
+        next += period;
+        this_thread::sleep_until(next);
+    }
+    int64_t elapsed = Now_Ns() - start;
+    this_thread::sleep_for(chrono::milliseconds(200));
+    drain();
+    g_running = false;
+    mcu.join();
+    uart.close();
+
+    double seconds = elapsed * 1e-9;
+    cout << "========== 串口模拟测试 ==========" << endl;
+    cout << "发送控制帧: " << config.frames << "，模拟器收到: " << stats.frames
+         << "，重复: " << stats.repeats << "，校验失败: " << stats.bad_frames << endl;
+    cout << "吞吐: " << fixed << setprecision(0) << stats.frames / seconds
+         << " 帧/秒, " << stats.bytes / seconds << " 字节/秒" << endl;
+    print_latency("carControl调用耗时", call);
+    print_latency("提交到下位机收到", stats.latency);
+    cout << "应答帧: 发出 " << stats.acks << "（注入噪声 " << stats.noisy_acks
+         << "），上位机解出 " << acks << endl;
+    cout << "按键帧: 发出 " << stats.keys << "，上位机解出 " << keys << endl;
+    cout << "解码重同步次数: " << uart.frameErrors()
+         << "，接收队列丢弃: " << uart.droppedMessages()
+         << "，发送缓冲丢帧: " << uart.droppedFrames() << endl;
+    cout << "指令覆盖: " << uart.coalescedFrames() << "，相同省略: "
+         << uart.unchangedFrames() << "，心跳: " << uart.heartbeatFrames()
+         << "，链路占用: " << setprecision(1) << uart.linkUtilisation() * 100
+         << " %" << endl;
+    cout << "==================================" << endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Sim_Config config;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            config.frames = atoi(argv[++i]);
+        else if (arg == "-r" && i + 1 < argc)
+            config.rate = atoi(argv[++i]);
+        else if (arg == "-noise" && i + 1 < argc)
+            config.noise = atof(argv[++i]);
+        else if (arg == "-key" && i + 1 < argc)
+            config.key_period_ms = atoi(argv[++i]);
+        else if (arg == "-max" && i + 1 < argc)
+            config.max_rate = atoi(argv[++i]);
+        else if (arg == "-external")
+            config.external = true;
+        else if (arg == "-link" && i + 1 < argc)
+            config.link = argv[++i];
+        else if (arg == "-replay" && i + 1 < argc)
+            config.replay = argv[++i];
+        else {
+            cerr << "用法: " << argv[0]
+                 << " [-n 帧数] [-r 频率Hz] [-noise 概率] [-key 按键周期ms] [-max 限速Hz]"
+                    " [-external] [-link 路径] [-replay 录制.nsrec]" << endl;
+            return -1;
+        }
+    }
+    config.frames = max(0, min(config.frames, 65536)); // 序号为16位
+
+    int master, slave;
+    char name[256];
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0) {
+        perror("openpty");
+        return -1;
+    }
+    // 保持从端打开，避免上位机重连期间主端收到挂断
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    int ret = 0;
+    if (config.external) {
+        if (!config.link.empty()) {
+            unlink(config.link.c_str());
+            if (symlink(name, config.link.c_str()) != 0)
+                perror("symlink");
+        }
+        cout << "模拟下位机已启动: " << name
+             << (config.link.empty() ? "" : " -> " + config.link) << endl;
+        Sim_Stats stats;
+        thread replay;
+        if (!config.replay.empty()) {
+            config.key_period_ms = 0; // 按键也来自记录
+            replay = thread(replay_loop, master, config.replay);
+        }
+        mcu_loop(master, config, stats, nullptr);
+        if (replay.joinable())
+            replay.join();
+        cout << "收到控制帧 " << stats.frames << "，校验失败 " << stats.bad_frames
+             << "，应答 " << stats.acks << endl;
+        if (!config.link.empty())
+            unlink(config.link.c_str());
+    } else {
+        ret = self_test(master, name, config);
+    }
+    close(slave);
+    close(master);
+    return ret;
+}